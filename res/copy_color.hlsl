@@ -39,11 +39,13 @@ Interpolators main_vertex(uint vertex_id : SV_VertexID) {
 }
 
 float4 main_fragment(Interpolators input) : SV_Target0 {
-    float3 color = screen_color_sampled.Sample(sampler_nearest_clamp, input.position_uv.xy, 0).rgb;
+    // Bilinear upscale when drawn to the surface, exact texel centers at 1:1, clamped to the render area
+    float2 uv_max = (global_buffer.screen_params.xy - 0.5) / global_buffer.screen_params.zw;
+    float3 color = screen_color_sampled.Sample(sampler_linear_clamp, min(input.position_uv.xy, uv_max), 0).rgb;
     float  dither_amount = 1.0; // Adjust for strength
-    color.r = ordered_dither(color.r, input.position_uv.xy * global_buffer.screen_params.xy, dither_amount);
-    color.g = ordered_dither(color.g, input.position_uv.xy * global_buffer.screen_params.xy, dither_amount);
-    color.b = ordered_dither(color.b, input.position_uv.xy * global_buffer.screen_params.xy, dither_amount);
+    color.r = ordered_dither(color.r, input.position_cs.xy, dither_amount);
+    color.g = ordered_dither(color.g, input.position_cs.xy, dither_amount);
+    color.b = ordered_dither(color.b, input.position_cs.xy, dither_amount);
 
     return float4(color, 1);
 }
@@ -1,7 +1,7 @@
 
 
 struct GlobalBuffer {
-    /* [screen_width, screen_height, buffer_width, buffer_height] */
+    /* [render_width, render_height, buffer_width, buffer_height], render area is scaled by frame time, scale is xy / zw */
     float4   screen_params;
     float4   sun_direction;
     float4   camera_position;
@@ -146,7 +146,8 @@ Pixel main_fragment(Interpolators input, bool is_front_face : SV_IsFrontFace) {
 
         float3 hor_view = normalize(float3(-view_dir.x, light_dir.y * light_dir.y, -view_dir.y));
 
-        float3 scene_color   = sqrt(color_copy_sampled.Sample(sampler_linear_clamp, saturate(screen_uv + normal.xz * 0.01), 0).rgb);
+        float2 refract_uv    = clamp(screen_uv + normal.xz * 0.01, 0, (global_buffer.screen_params.xy - 0.5) / global_buffer.screen_params.zw);
+        float3 scene_color   = sqrt(color_copy_sampled.Sample(sampler_linear_clamp, refract_uv, 0).rgb);
         float3 sky_color     = saturate(sky(hor_view, light_dir));
         float3 horizon_color = water_color;
 
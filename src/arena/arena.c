@@ -0,0 +1,172 @@
+/* MAP_ANONYMOUS, MAP_NORESERVE and madvise are not part of c99, base.h pulls in libc headers first */
+#define _DEFAULT_SOURCE
+#include "arena.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/* PLATFORM */
+/* reserved pages have no access until committed, decommitted pages read zero when committed again */
+
+void* arena_os_reserve(
+    u64 size
+) {
+#if defined(_WIN32)
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_READWRITE);
+#else
+    void* memory = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return (memory == MAP_FAILED) ? NULL : memory;
+#endif
+}
+
+b32 arena_os_commit(
+    void* memory,
+    u64   size
+) {
+#if defined(_WIN32)
+    return VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(memory, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+b32 arena_os_decommit(
+    void* memory,
+    u64   size
+) {
+#if defined(_WIN32)
+    return VirtualFree(memory, size, MEM_DECOMMIT) != 0;
+#else
+    return madvise(memory, size, MADV_DONTNEED) == 0 && mprotect(memory, size, PROT_NONE) == 0;
+#endif
+}
+
+b32 arena_os_release(
+    void* memory,
+    u64   size
+) {
+#if defined(_WIN32)
+    return VirtualFree(memory, 0, MEM_RELEASE) != 0;
+#else
+    return munmap(memory, size) == 0;
+#endif
+}
+
+/* ARENA */
+
+b32 arena_create(
+    Arena*        arena,
+    ArenaLifetime lifetime,
+    u64           reserve_size
+) {
+    if(arena == NULL || reserve_size == 0 || lifetime >= ARENA_LIFETIME_COUNT) {
+        LOG_ERROR("invalid arena params");
+        goto fail;
+    }
+
+    reserve_size = ALIGN(reserve_size, ARENA_COMMIT_GRANULARITY);
+
+    u8* base = arena_os_reserve(reserve_size);
+    if(base == NULL) {
+        LOG_ERROR("failed to reserve arena size: %llu", reserve_size);
+        goto fail;
+    }
+
+    *arena = (Arena) {
+        .base         = base,
+        .reserve_size = reserve_size,
+        .lifetime     = lifetime
+    };
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+void arena_destroy(
+    Arena* arena
+) {
+    if(arena->base == NULL) {
+        return;
+    }
+    if(!arena_os_release(arena->base, arena->reserve_size)) {
+        LOG_ERROR("failed to release arena lifetime: %u", arena->lifetime);
+    }
+    *arena = (Arena){0};
+}
+
+b32 arena_commit(
+    Arena* arena,
+    u64    size
+) {
+    if(size <= arena->commit_size) {
+        return TRUE;
+    }
+    if(size > arena->reserve_size) {
+        LOG_ERROR("arena exhausted lifetime: %u size: %llu/%llu", arena->lifetime, size, arena->reserve_size);
+        goto fail;
+    }
+
+    const u64 commit_size = MIN(ALIGN(size, ARENA_COMMIT_GRANULARITY), arena->reserve_size);
+    if(!arena_os_commit(arena->base + arena->commit_size, commit_size - arena->commit_size)) {
+        LOG_ERROR("failed to commit arena memory lifetime: %u size: %llu", arena->lifetime, commit_size);
+        goto fail;
+    }
+    arena->commit_size = commit_size;
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+void* arena_push(
+    Arena* arena,
+    u64    size,
+    u64    alignment
+) {
+    alignment = alignment ? alignment : ARENA_DEFAULT_ALIGNMENT;
+
+    const u64 offset = ALIGN(arena->used_size, alignment);
+    if(!arena_commit(arena, offset + size)) {
+        return NULL;
+    }
+
+    arena->used_size = offset + size;
+    arena->peak_size = MAX(arena->peak_size, arena->used_size);
+    return arena->base + offset;
+}
+
+ArenaMarker arena_marker(
+    const Arena* arena
+) {
+    return arena->used_size;
+}
+
+void arena_rewind(
+    Arena*      arena,
+    ArenaMarker marker
+) {
+    arena->used_size = MIN(arena->used_size, marker);
+}
+
+void arena_reset(
+    Arena* arena,
+    u64    keep_size
+) {
+    arena->used_size = 0;
+
+    const u64 commit_size = MIN(ALIGN(keep_size, ARENA_COMMIT_GRANULARITY), arena->commit_size);
+    if(commit_size == arena->commit_size) {
+        return;
+    }
+    if(!arena_os_decommit(arena->base + commit_size, arena->commit_size - commit_size)) {
+        LOG_ERROR("failed to decommit arena memory lifetime: %u", arena->lifetime);
+        return;
+    }
+    arena->commit_size = commit_size;
+}
@@ -0,0 +1,49 @@
+#ifndef _ARENA_INCLUDED
+#define _ARENA_INCLUDED
+
+#include "../base.h"
+
+/* arenas grow their committed range in steps of this */
+#define ARENA_COMMIT_GRANULARITY (0x10000)
+#define ARENA_DEFAULT_ALIGNMENT  (16)
+
+/* who resets the arena and how often */
+typedef u32 ArenaLifetime;
+
+enum ArenaLifetime {
+    /* lives as long as its owner */
+    ARENA_LIFETIME_PERMANENT = 0,
+    /* reset when the owner reloads, e.g. shaders between levels */
+    ARENA_LIFETIME_LEVEL     = 1,
+    /* reset every frame, keeps its committed pages */
+    ARENA_LIFETIME_FRAME     = 2,
+    ARENA_LIFETIME_COUNT     = 3
+};
+
+/* reserved address range, committed up to commit_size, bump allocated up to used_size */
+typedef struct {
+    u8*           base;
+    u64           reserve_size;
+    u64           commit_size;
+    u64           used_size;
+    u64           peak_size;
+    ArenaLifetime lifetime;
+} Arena;
+
+/* used size of an arena to rewind to */
+typedef u64 ArenaMarker;
+
+b32         arena_create(Arena* arena, ArenaLifetime lifetime, u64 reserve_size);
+void        arena_destroy(Arena* arena);
+
+/* NULL when the reserved range is exhausted, memory reads zero only the first time its pages are used */
+void*       arena_push(Arena* arena, u64 size, u64 alignment);
+/* commits the first size bytes, for users that place memory in the range themselves */
+b32         arena_commit(Arena* arena, u64 size);
+
+ArenaMarker arena_marker(const Arena* arena);
+void        arena_rewind(Arena* arena, ArenaMarker marker);
+/* rewinds to the start, pages past keep_size go back to the system */
+void        arena_reset(Arena* arena, u64 keep_size);
+
+#endif
@@ -99,8 +99,9 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debug_messenger_callback(
 
 
 VkSurfaceKHR create_surface(
-    HWND       window, 
-    VkInstance instance
+    HWND                         window, 
+    VkInstance                   instance,
+    const VkAllocationCallbacks* allocator
 ) {
     VkSurfaceKHR                surface_handle = NULL;
     VkWin32SurfaceCreateInfoKHR surface_info   = {
@@ -111,7 +112,7 @@ VkSurfaceKHR create_surface(
     if(vkCreateWin32SurfaceKHR(
         instance,
         &surface_info,
-        NULL,
+        allocator,
         &surface_handle
     ) != VK_SUCCESS) {
         LOG_ERROR("failed to create vulkan win32 surface");
@@ -126,8 +127,9 @@ VkSurfaceKHR create_surface(
 }
 
 VkInstance create_instance(
-    const char*               name, 
-    VkDebugUtilsMessengerEXT* debug_messenger
+    const char*                  name, 
+    const VkAllocationCallbacks* allocator,
+    VkDebugUtilsMessengerEXT*    debug_messenger
 ) {
     const char* release_instance_ext[]  = {
         "VK_KHR_surface",
@@ -187,7 +189,7 @@ VkInstance create_instance(
 
     if(vkCreateInstance(
         &instance_info,
-        NULL,
+        allocator,
         &instance
     ) != VK_SUCCESS) {
         LOG_ERROR("failed to create vulkan instance");
@@ -204,7 +206,7 @@ VkInstance create_instance(
         if(create_debug_messenger(
             instance,
             &debug_messenger_info,
-            NULL,
+            allocator,
             debug_messenger
         ) != VK_SUCCESS) {
             LOG_ERROR("failed to create debug messenger");
@@ -223,16 +225,21 @@ VkInstance create_instance(
 
 const char* device_extensions[] = {
     "VK_KHR_swapchain",
-    "VK_KHR_dynamic_rendering"
+    "VK_KHR_dynamic_rendering",
+    "VK_KHR_synchronization2"
 };
 
+/* optional, enabled when the adapter has it */
+const char* memory_budget_extension = "VK_EXT_memory_budget";
+
 b32 check_graphics_adapter_memory(
     VkPhysicalDevice physical_device,
     u64*             device_size,
     u64*             host_size
 ) {
-    const u64 required_device_size = VRAM_SIZE_DEVICE_BUFFERS + VRAM_SIZE_DEVICE_IMAGES + VRAM_SIZE_DEVICE_VULKAN; 
-    const u64 required_host_size   = VRAM_SIZE_HOST_TRANSFER + VRAM_SIZE_HOST_VULKAN;
+    /* first blocks start at least this large, the rest is sized from the budget later */
+    const u64 required_device_size = VRAM_BLOCK_MIN_DEVICE_BUFFERS + VRAM_BLOCK_MIN_DEVICE_IMAGES + VRAM_RESERVE_DEVICE; 
+    const u64 required_host_size   = VRAM_BLOCK_MIN_HOST_TRANSFER;
     VkPhysicalDeviceMemoryProperties memory_properties = (VkPhysicalDeviceMemoryProperties){0};
     
     *device_size = 0;
@@ -252,7 +259,8 @@ b32 check_graphics_adapter_memory(
     if(*device_size < required_device_size) {
         goto fail;
     }
-    if(*device_size < required_host_size) {
+    /* unified memory adapters keep host visible types in device local heaps */
+    if(*device_size + *host_size < required_device_size + required_host_size) {
         goto fail;
     }
 
@@ -324,7 +332,8 @@ b32 check_graphics_adapter_queues(
 }
 
 b32 check_graphics_adapter_extensions(
-    VkPhysicalDevice physical_device
+    VkPhysicalDevice physical_device,
+    b32*             memory_budget
 ) {
     VkExtensionProperties extension_properties[GPU_MAX_DEVICE_EXTENSIONS] = {0};
     u32                   extension_properties_count                      = 0;
@@ -341,6 +350,14 @@ b32 check_graphics_adapter_extensions(
     /* get extensions */
     vkEnumerateDeviceExtensionProperties(physical_device, NULL, &extension_properties_count, extension_properties);
 
+    /* optional */
+    *memory_budget = FALSE;
+    for(u32 i = 0; i != extension_properties_count; i++) {
+        if(strcmp(memory_budget_extension, extension_properties[i].extensionName) == 0) {
+            *memory_budget = TRUE;
+        }
+    }
+
     for(u32 i = 0; i != ARRAY_SIZE(device_extensions); i++) {
         for(u32 j = 0; j != extension_properties_count; j++) {
             if(strcmp(device_extensions[i], extension_properties[j].extensionName) == 0) {
@@ -451,7 +468,11 @@ b32 check_graphics_adapter(
     adapter->device_type     = (u16)device_properties.deviceType;
     adapter->physical_device = device;
 
-    if(!check_graphics_adapter_extensions(device)) {
+    adapter->uniform_offset_alignment = device_properties.limits.minUniformBufferOffsetAlignment;
+    adapter->non_coherent_atom_size   = device_properties.limits.nonCoherentAtomSize;
+    adapter->timestamp_period         = device_properties.limits.timestampComputeAndGraphics ? device_properties.limits.timestampPeriod : 0.0f;
+
+    if(!check_graphics_adapter_extensions(device, &adapter->memory_budget)) {
         goto fail;
     }
 
@@ -605,27 +626,26 @@ const VkMemoryPropertyFlags memory_flags_host[] = {
     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
 };
 
-u32 find_memory_type(
+/* host reads, uncached memory only as the last resort */
+const VkMemoryPropertyFlags memory_flags_readback[] = {
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+    VK_MEMORY_PROPERTY_HOST_CACHED_BIT  ,
+
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+    VK_MEMORY_PROPERTY_HOST_CACHED_BIT  |
+    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+};
+
+u32 find_memory_type_from_list(
     VkPhysicalDeviceMemoryProperties* device_memory_properties,
-    VkPhysicalDeviceType              device_type,
-    VkPhysicalDevice                  device,
+    const VkMemoryPropertyFlags*      memory_flags_list,
+    u32                               memory_flags_list_length,
     u64                               size,
-    u32                               type_bits,
-    b32                               is_device_local
+    u32                               type_bits
 ) {
-    /* select list of prioritized memory types */
-    const VkMemoryPropertyFlags* memory_flags_list        = NULL;
-    u32                          memory_flags_list_length = 0;
-
-    if(device_type == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
-        memory_flags_list        = is_device_local ?            memory_flags_device_only    :            memory_flags_host;
-        memory_flags_list_length = is_device_local ? ARRAY_SIZE(memory_flags_device_only)   : ARRAY_SIZE(memory_flags_host);
-    } else {
-        memory_flags_list        = is_device_local ?            memory_flags_device_shared  :            memory_flags_host;
-        memory_flags_list_length = is_device_local ? ARRAY_SIZE(memory_flags_device_shared) : ARRAY_SIZE(memory_flags_host);
-    }
-
-    /* find memory type */
     const u32           memory_types_count = device_memory_properties->memoryTypeCount;
     const VkMemoryType* memory_types       = device_memory_properties->memoryTypes;
     VkMemoryHeap*       memory_heaps       = device_memory_properties->memoryHeaps;
@@ -663,24 +683,95 @@ u32 find_memory_type(
     }
 }
 
+u32 find_memory_type(
+    VkPhysicalDeviceMemoryProperties* device_memory_properties,
+    VkPhysicalDeviceType              device_type,
+    VkPhysicalDevice                  device,
+    u64                               size,
+    u32                               type_bits,
+    b32                               is_device_local
+) {
+    /* select list of prioritized memory types */
+    const VkMemoryPropertyFlags* memory_flags_list        = NULL;
+    u32                          memory_flags_list_length = 0;
+
+    if(device_type == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
+        memory_flags_list        = is_device_local ?            memory_flags_device_only    :            memory_flags_host;
+        memory_flags_list_length = is_device_local ? ARRAY_SIZE(memory_flags_device_only)   : ARRAY_SIZE(memory_flags_host);
+    } else {
+        memory_flags_list        = is_device_local ?            memory_flags_device_shared  :            memory_flags_host;
+        memory_flags_list_length = is_device_local ? ARRAY_SIZE(memory_flags_device_shared) : ARRAY_SIZE(memory_flags_host);
+    }
+
+    return find_memory_type_from_list(device_memory_properties, memory_flags_list, memory_flags_list_length, size, type_bits);
+}
+
+/* U32_MAX = no lazily allocated memory, usual on desktop adapters */
+u32 find_lazy_memory_type(
+    VkPhysicalDevice physical_device
+) {
+    VkPhysicalDeviceMemoryProperties memory_properties = (VkPhysicalDeviceMemoryProperties){0};
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    for(u32 i = 0; i != memory_properties.memoryTypeCount; i++) {
+        if(memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) {
+            return i;
+        }
+    }
+    return U32_MAX;
+}
+
+/* sizes blocks from what the budgets leave us, heaps have to be set */
+void video_memory_size_blocks(
+    VulkanDevice* vulkan_device
+) {
+    GpuVideoMemoryAllocation* video_memory_device_buffers = &vulkan_device->video_memory_device_buffers;
+    GpuVideoMemoryAllocation* video_memory_device_images  = &vulkan_device->video_memory_device_images;
+    GpuVideoMemoryAllocation* video_memory_host_transfer  = &vulkan_device->video_memory_host_transfer;
+
+    u64 device_budget = 0;
+    u64 device_usage  = 0;
+    u64 host_budget   = 0;
+    u64 host_usage    = 0;
+    video_memory_heap_budget(vulkan_device, video_memory_device_images->heap_id, &device_budget, &device_usage);
+    video_memory_heap_budget(vulkan_device, video_memory_host_transfer->heap_id, &host_budget,   &host_usage  );
+
+    const u64 device_available = (device_budget > device_usage + VRAM_RESERVE_DEVICE) ? device_budget - device_usage - VRAM_RESERVE_DEVICE : 0;
+    const u64 host_available   = (host_budget   > host_usage                         ) ? host_budget   - host_usage                         : 0;
+
+    const u64 size_device_buffers = ALIGN(device_available / 16, 1024 * 1024);
+    const u64 size_device_images  = ALIGN(device_available /  8, 1024 * 1024);
+    const u64 size_host_transfer  = ALIGN(host_available   / 16, 1024 * 1024);
+
+    video_memory_device_buffers->block_size = CLAMP(VRAM_BLOCK_MIN_DEVICE_BUFFERS, VRAM_BLOCK_MAX_DEVICE_BUFFERS, size_device_buffers);
+    video_memory_device_images->block_size  = CLAMP(VRAM_BLOCK_MIN_DEVICE_IMAGES,  VRAM_BLOCK_MAX_DEVICE_IMAGES,  size_device_images );
+    video_memory_host_transfer->block_size  = CLAMP(VRAM_BLOCK_MIN_HOST_TRANSFER,  VRAM_BLOCK_MAX_HOST_TRANSFER,  size_host_transfer );
+
+    LOG_MESSAGE(
+        "video memory budget device: %llu/%llu host: %llu/%llu blocks buffers: %llu images: %llu transfer: %llu",
+        device_usage, device_budget,
+        host_usage,   host_budget,
+        video_memory_device_buffers->block_size,
+        video_memory_device_images->block_size,
+        video_memory_host_transfer->block_size
+    );
+}
+
 b32 allocate_video_memory(
-    VkDevice                  device,
-    VkPhysicalDevice          physical_device,
-    VkPhysicalDeviceType      physical_device_type,
-    GpuVideoMemoryAllocation* video_memory_device_buffers,
-    GpuVideoMemoryAllocation* video_memory_device_images,
-    GpuVideoMemoryAllocation* video_memory_host_transfer
+    VulkanDevice* vulkan_device
 ) {
+    const VkDevice         device          = vulkan_device->device;
+    const GraphicsAdapter* adapter         = vulkan_device->adapter;
+    const VkPhysicalDevice physical_device = adapter->physical_device;
+
     /* get memory properties */
     VkPhysicalDeviceMemoryProperties memory_properties = (VkPhysicalDeviceMemoryProperties){0};
     vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
 
-    u32                   type_device_buffers  = U32_MAX;
-    u32                   type_device_images   = U32_MAX;
-    u32                   type_host_transfer   = U32_MAX;
-    VkMemoryPropertyFlags flags_device_buffers = 0;
-    VkMemoryPropertyFlags flags_device_images  = 0;
-    VkMemoryPropertyFlags flags_host_transfer  = 0;
+    u32 type_device_buffers = U32_MAX;
+    u32 type_device_images  = U32_MAX;
+    u32 type_host_transfer  = U32_MAX;
+    u32 type_host_readback  = U32_MAX;
 
     /* find memory types */ {
 
@@ -709,11 +800,11 @@ b32 allocate_video_memory(
     VkBuffer dummy_buffer = NULL;
     VkImage  dummy_image  = NULL;
     
-    if(vkCreateBuffer(device, &dummy_buffer_info, NULL, &dummy_buffer) != VK_SUCCESS) {
+    if(vkCreateBuffer(device, &dummy_buffer_info, vulkan_device->allocator, &dummy_buffer) != VK_SUCCESS) {
         LOG_ERROR("failed to create dummy buffer");
         goto fail;
     }
-    if(vkCreateImage(device, &dummy_image_info, NULL, &dummy_image) != VK_SUCCESS) {
+    if(vkCreateImage(device, &dummy_image_info, vulkan_device->allocator, &dummy_image) != VK_SUCCESS) {
         LOG_ERROR("failed to create dummy image");
         goto fail;
     }
@@ -726,145 +817,114 @@ b32 allocate_video_memory(
     vkGetImageMemoryRequirements(device, dummy_image, &dummy_image_requirements);
 
     /* get rid of prototypes*/
-    vkDestroyBuffer(device, dummy_buffer, NULL);
-    vkDestroyImage(device, dummy_image, NULL);
-    
+    vkDestroyBuffer(device, dummy_buffer, vulkan_device->allocator);
+    vkDestroyImage(device, dummy_image, vulkan_device->allocator);
     
-    const VkMemoryType* memory_types = memory_properties.memoryTypes;
-
-    if(VRAM_SIZE_DEVICE_BUFFERS != 0) {
-        type_device_buffers = find_memory_type(
-            &memory_properties, 
-            physical_device_type, 
-            physical_device, 
-            VRAM_SIZE_DEVICE_BUFFERS, 
-            dummy_buffer_requirements.memoryTypeBits, 
-            TRUE
-        );
-        if(type_device_buffers == U32_MAX) {
-            LOG_ERROR("failed to find device buffers memory type");
-            goto fail;
-        }
-
-        flags_device_buffers = memory_types[type_device_buffers].propertyFlags;
-    }
-    if(VRAM_SIZE_DEVICE_IMAGES != 0) {
-        type_device_images = find_memory_type(
-            &memory_properties, 
-            physical_device_type, 
-            physical_device, 
-            VRAM_SIZE_DEVICE_IMAGES, 
-            dummy_image_requirements.memoryTypeBits, 
-            TRUE
-        );
-        if(type_device_images == U32_MAX) {
-            LOG_ERROR("failed to find device images memory type");
-            goto fail;
-        }
-
-        flags_device_images = memory_types[type_device_images].propertyFlags;
-    }
-    if(VRAM_SIZE_HOST_TRANSFER != 0) {
-        type_host_transfer = find_memory_type(
-            &memory_properties,
-            physical_device_type,
-            physical_device,
-            VRAM_SIZE_HOST_TRANSFER,
-            dummy_buffer_requirements.memoryTypeBits,
-            FALSE
-        );
-        if(type_host_transfer == U32_MAX) {
-            LOG_ERROR("failed to find host transfer type");
-            goto fail;
-        }
-
-        flags_host_transfer = memory_types[type_host_transfer].propertyFlags;
-    }
+    /* heaps have to fit at least the smallest blocks */
+    type_device_buffers = find_memory_type(
+        &memory_properties, 
+        adapter->device_type, 
+        physical_device, 
+        VRAM_BLOCK_MIN_DEVICE_BUFFERS, 
+        dummy_buffer_requirements.memoryTypeBits, 
+        TRUE
+    );
+    if(type_device_buffers == U32_MAX) {
+        LOG_ERROR("failed to find device buffers memory type");
+        goto fail;
     }
-
-    VkDeviceMemory memory_device_buffers = NULL;
-    VkDeviceMemory memory_device_images  = NULL;
-    VkDeviceMemory memory_host_transfer  = NULL;
-    void*          map_device_buffers    = NULL;
-    void*          map_device_images     = NULL;
-    void*          map_host_transfer     = NULL;
-
-    /* allocate memory */ {
-    const VkMemoryAllocateInfo alloc_device_buffers_info = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .memoryTypeIndex = type_device_buffers,
-        .allocationSize  = VRAM_SIZE_DEVICE_BUFFERS
-    };
-    const VkMemoryAllocateInfo alloc_device_images_info = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .memoryTypeIndex = type_device_images,
-        .allocationSize  = VRAM_SIZE_DEVICE_IMAGES
-    };
-    const VkMemoryAllocateInfo alloc_host_transfer_info = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .memoryTypeIndex = type_host_transfer,
-        .allocationSize  = VRAM_SIZE_HOST_TRANSFER
-    };
-
-    if(type_device_buffers != U32_MAX) {
-        if(vkAllocateMemory(device, &alloc_device_buffers_info, NULL, &memory_device_buffers) != VK_SUCCESS) {
-            LOG_ERROR("failed to allocate device buffers memory");
-            goto fail;
-        }
-        
-        if(flags_device_buffers & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-            if(vkMapMemory(device, memory_device_buffers, 0, VRAM_SIZE_DEVICE_BUFFERS, 0, &map_device_buffers) != VK_SUCCESS) {
-                LOG_ERROR("failed to map device buffers memory");
-                goto fail;
-            }
-        }
+    type_device_images = find_memory_type(
+        &memory_properties, 
+        adapter->device_type, 
+        physical_device, 
+        VRAM_BLOCK_MIN_DEVICE_IMAGES, 
+        dummy_image_requirements.memoryTypeBits, 
+        TRUE
+    );
+    if(type_device_images == U32_MAX) {
+        LOG_ERROR("failed to find device images memory type");
+        goto fail;
     }
-    if(type_device_images != U32_MAX) {
-        if(vkAllocateMemory(device, &alloc_device_images_info, NULL, &memory_device_images) != VK_SUCCESS) {
-            LOG_ERROR("failed to allocate device images memory");
-            goto fail;
-        }
-
-        if(flags_device_images & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-            if(vkMapMemory(device, memory_device_images, 0, VRAM_SIZE_DEVICE_IMAGES, 0, &map_device_images) != VK_SUCCESS) {
-                LOG_ERROR("failed to map device images memory");
-                goto fail;
-            }
-        }
+    type_host_transfer = find_memory_type(
+        &memory_properties,
+        adapter->device_type,
+        physical_device,
+        VRAM_BLOCK_MIN_HOST_TRANSFER,
+        dummy_buffer_requirements.memoryTypeBits,
+        FALSE
+    );
+    if(type_host_transfer == U32_MAX) {
+        LOG_ERROR("failed to find host transfer type");
+        goto fail;
     }
-    if(type_host_transfer != U32_MAX) {
-        if(vkAllocateMemory(device, &alloc_host_transfer_info, NULL, &memory_host_transfer) != VK_SUCCESS) {
-            LOG_ERROR("failed to allocate host transfer memory");
-            goto fail;
-        }
-
-        if(vkMapMemory(device, memory_host_transfer, 0, VRAM_SIZE_HOST_TRANSFER, 0, &map_host_transfer) != VK_SUCCESS) {
-            LOG_ERROR("failed to map host transfer memory");
-            goto fail;
-        }
+    /* readbacks are optional */
+    type_host_readback = find_memory_type_from_list(
+        &memory_properties,
+        memory_flags_readback,
+        ARRAY_SIZE(memory_flags_readback),
+        VRAM_BLOCK_HOST_READBACK,
+        dummy_buffer_requirements.memoryTypeBits
+    );
+    if(type_host_readback == U32_MAX) {
+        LOG_WARNING("failed to find host readback type, readbacks are disabled");
     }
     }
 
     /* fill allocation structs */
+    const VkMemoryType* memory_types = memory_properties.memoryTypes;
+
+    GpuVideoMemoryAllocation* video_memory_device_buffers = &vulkan_device->video_memory_device_buffers;
+    GpuVideoMemoryAllocation* video_memory_device_images  = &vulkan_device->video_memory_device_images;
+    GpuVideoMemoryAllocation* video_memory_host_transfer  = &vulkan_device->video_memory_host_transfer;
+    GpuVideoMemoryAllocation* video_memory_host_readback  = &vulkan_device->video_memory_host_readback;
+
     *video_memory_device_buffers = (GpuVideoMemoryAllocation) {
-        .device_memory = memory_device_buffers,
-        .memory_map    = map_device_buffers,
-        .type_id       = type_device_buffers,
-        .type_flags    = flags_device_buffers
+        .type_id    = type_device_buffers,
+        .heap_id    = memory_types[type_device_buffers].heapIndex,
+        .type_flags = memory_types[type_device_buffers].propertyFlags
     };
     *video_memory_device_images = (GpuVideoMemoryAllocation) {
-        .device_memory = memory_device_images,
-        .memory_map    = map_device_images,
-        .type_id       = type_device_images,
-        .type_flags    = flags_device_images
+        .type_id    = type_device_images,
+        .heap_id    = memory_types[type_device_images].heapIndex,
+        .type_flags = memory_types[type_device_images].propertyFlags
     };
     *video_memory_host_transfer = (GpuVideoMemoryAllocation) {
-        .device_memory = memory_host_transfer,
-        .memory_map    = map_host_transfer,
-        .type_id       = type_host_transfer,
-        .type_flags    = flags_host_transfer
+        .type_id    = type_host_transfer,
+        .heap_id    = memory_types[type_host_transfer].heapIndex,
+        .type_flags = memory_types[type_host_transfer].propertyFlags
+    };
+    *video_memory_host_readback = (GpuVideoMemoryAllocation) {
+        .type_id    = type_host_readback,
+        .heap_id    = (type_host_readback != U32_MAX) ? memory_types[type_host_readback].heapIndex     : U32_MAX,
+        .type_flags = (type_host_readback != U32_MAX) ? memory_types[type_host_readback].propertyFlags : 0,
+        .block_size = VRAM_BLOCK_HOST_READBACK
     };
 
+    video_memory_size_blocks(vulkan_device);
+
+    /* first blocks live as long as the device, resources sub-allocate from them */
+    if(video_memory_add_block(vulkan_device, video_memory_device_buffers, video_memory_device_buffers->block_size) == U32_MAX) {
+        LOG_ERROR("failed to allocate device buffers memory");
+        goto fail;
+    }
+    if(video_memory_add_block(vulkan_device, video_memory_device_images, video_memory_device_images->block_size) == U32_MAX) {
+        LOG_ERROR("failed to allocate device images memory");
+        goto fail;
+    }
+    if(video_memory_add_block(vulkan_device, video_memory_host_transfer, video_memory_host_transfer->block_size) == U32_MAX) {
+        LOG_ERROR("failed to allocate host transfer memory");
+        goto fail;
+    }
+    if(video_memory_host_transfer->blocks[0].memory_map == NULL) {
+        LOG_ERROR("host transfer memory is not mapped");
+        goto fail;
+    }
+    if(type_host_readback != U32_MAX && video_memory_add_block(vulkan_device, video_memory_host_readback, video_memory_host_readback->block_size) == U32_MAX) {
+        LOG_ERROR("failed to allocate host readback memory");
+        goto fail;
+    }
+    vulkan_device->memory_pressure_pending = FALSE;
+
     return TRUE;
 
     fail: {
@@ -898,6 +958,7 @@ b32 create_vulkan_objects(
     /* vulkan instance */
     vulkan_objects->instance = create_instance(
         vulkan_objects->window_name,
+        vulkan_objects->allocator,
         enable_debug ? &vulkan_objects->debug_messenger : NULL
     );
     if(vulkan_objects->instance == NULL) {
@@ -908,7 +969,8 @@ b32 create_vulkan_objects(
     /* surface */
     vulkan_objects->surface = create_surface(
         vulkan_objects->window, 
-        vulkan_objects->instance
+        vulkan_objects->instance,
+        vulkan_objects->allocator
     );
     if(vulkan_objects->surface == NULL) {
         LOG_ERROR("failed to create vulkan surface");
@@ -993,20 +1055,43 @@ b32 create_vulkan_device(
     }
 
     /* create device */
-    const VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering_feature = {
+    /* timeline semaphores signal background upload tokens */
+    VkPhysicalDeviceTimelineSemaphoreFeatures      timeline_semaphore_feature = {
+        .sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+        .timelineSemaphore = TRUE
+    };
+    /* all barriers are recorded with exact stage and access masks */
+    VkPhysicalDeviceSynchronization2Features       synchronization2_feature   = {
+        .sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+        .synchronization2 = TRUE,
+        .pNext            = &timeline_semaphore_feature
+    };
+    const VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering_feature  = {
         .sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES,
-        .dynamicRendering = TRUE
+        .dynamicRendering = TRUE,
+        .pNext            = &synchronization2_feature
     };
+    /* required extensions followed by supported optional ones */
+    const char* enabled_extensions[ARRAY_SIZE(device_extensions) + 1] = {0};
+    u32         enabled_extensions_count                              = 0;
+
+    for(u32 i = 0; i != ARRAY_SIZE(device_extensions); i++) {
+        enabled_extensions[enabled_extensions_count++] = device_extensions[i];
+    }
+    if(adapter->memory_budget) {
+        enabled_extensions[enabled_extensions_count++] = memory_budget_extension;
+    }
+
     const VkDeviceCreateInfo device_info = {
         .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .enabledExtensionCount   = ARRAY_SIZE(device_extensions),
-        .ppEnabledExtensionNames = device_extensions,
+        .enabledExtensionCount   = enabled_extensions_count,
+        .ppEnabledExtensionNames = enabled_extensions,
         .queueCreateInfoCount    = queues_count,
         .pQueueCreateInfos       = queues_infos,
         .pNext                   = &dynamic_rendering_feature
     };
 
-    if(vkCreateDevice(adapter->physical_device, &device_info, NULL, &vulkan_device->device) != VK_SUCCESS) {
+    if(vkCreateDevice(adapter->physical_device, &device_info, vulkan_device->allocator, &vulkan_device->device) != VK_SUCCESS) {
         LOG_ERROR("failed to create vulkan device");
         goto fail;
     }
@@ -1030,50 +1115,46 @@ b32 create_vulkan_device(
 
     if(adapter->render_queue_id != U32_MAX) {
         vkGetDeviceQueue(vulkan_device->device, adapter->render_queue_id, 0, &vulkan_device->queue_render);
-        if(vkCreateCommandPool(vulkan_device->device, &render_command_pool_info, NULL, &vulkan_device->command_pool_render) != VK_SUCCESS) {
+        if(vkCreateCommandPool(vulkan_device->device, &render_command_pool_info, vulkan_device->allocator, &vulkan_device->command_pool_render) != VK_SUCCESS) {
             LOG_ERROR("failed to create render command pool");
             goto fail;
         }
     }
     if(adapter->compute_queue_id != U32_MAX) {
         vkGetDeviceQueue(vulkan_device->device, adapter->compute_queue_id, 0, &vulkan_device->queue_compute);
-        if(vkCreateCommandPool(vulkan_device->device, &compute_command_pool_info, NULL, &vulkan_device->command_pool_compute) != VK_SUCCESS) {
+        if(vkCreateCommandPool(vulkan_device->device, &compute_command_pool_info, vulkan_device->allocator, &vulkan_device->command_pool_compute) != VK_SUCCESS) {
             LOG_ERROR("failed to create compute command pool");
             goto fail;
         }
     }
     if(adapter->transfer_queue_id != U32_MAX) {
         vkGetDeviceQueue(vulkan_device->device, adapter->transfer_queue_id, 0, &vulkan_device->queue_transfer);
-        if(vkCreateCommandPool(vulkan_device->device, &transfer_command_pool_info, NULL, &vulkan_device->command_pool_transfer) != VK_SUCCESS) {
+        if(vkCreateCommandPool(vulkan_device->device, &transfer_command_pool_info, vulkan_device->allocator, &vulkan_device->command_pool_transfer) != VK_SUCCESS) {
             LOG_ERROR("failed to create transfer command pool");
             goto fail;
         }
     }
 
     /* load device extensions procedures */
-    vulkan_device->cmd_begin_rendering_khr = (void*)vkGetDeviceProcAddr(vulkan_device->device, "vkCmdBeginRenderingKHR");
-    vulkan_device->cmd_end_rendering_khr   = (void*)vkGetDeviceProcAddr(vulkan_device->device, "vkCmdEndRenderingKHR");
+    vulkan_device->cmd_begin_rendering_khr   = (void*)vkGetDeviceProcAddr(vulkan_device->device, "vkCmdBeginRenderingKHR");
+    vulkan_device->cmd_end_rendering_khr     = (void*)vkGetDeviceProcAddr(vulkan_device->device, "vkCmdEndRenderingKHR");
+    vulkan_device->cmd_pipeline_barrier2_khr = (void*)vkGetDeviceProcAddr(vulkan_device->device, "vkCmdPipelineBarrier2KHR");
 
     if(
-        vulkan_device->cmd_begin_rendering_khr == NULL ||
-        vulkan_device->cmd_end_rendering_khr   == NULL
+        vulkan_device->cmd_begin_rendering_khr   == NULL ||
+        vulkan_device->cmd_end_rendering_khr     == NULL ||
+        vulkan_device->cmd_pipeline_barrier2_khr == NULL
     ) {
         LOG_ERROR("failed to load device extension procedures");
         goto fail;
     }
 
     /* allocate memory */
-    if(!allocate_video_memory(
-        vulkan_device->device,
-        vulkan_device->adapter->physical_device,
-        vulkan_device->adapter->device_type,
-        &vulkan_device->video_memory_device_buffers,
-        &vulkan_device->video_memory_device_images,
-        &vulkan_device->video_memory_host_transfer
-    )) {
+    if(!allocate_video_memory(vulkan_device)) {
         LOG_ERROR("failed to allocate device memory");
         goto fail;
     }
+    vulkan_device->lazy_memory_type_id = find_lazy_memory_type(vulkan_device->adapter->physical_device);
 
     return TRUE;
 
@@ -1090,44 +1171,22 @@ void destroy_vulkan_device(
 
     vkDeviceWaitIdle(device);
 
-    const VkDeviceMemory memory_device_buffers = vulkan_device->video_memory_device_buffers.device_memory;
-    const VkDeviceMemory memory_device_images  = vulkan_device->video_memory_device_images.device_memory;
-    const VkDeviceMemory memory_host_transfer  = vulkan_device->video_memory_host_transfer.device_memory;
-    const void*          map_device_buffers    = vulkan_device->video_memory_device_buffers.memory_map;
-    const void*          map_device_images     = vulkan_device->video_memory_device_images.memory_map;
-    const void*          map_host_transfer     = vulkan_device->video_memory_host_transfer.memory_map;
-
-    if(map_device_buffers != NULL) {
-        vkUnmapMemory(device, memory_device_buffers);
-    }
-    if(map_device_images != NULL) {
-        vkUnmapMemory(device, memory_device_images);
-    }
-    if(map_host_transfer != NULL) {
-        vkUnmapMemory(device, memory_host_transfer);
-    }
-
-    if(memory_device_buffers != NULL) {
-        vkFreeMemory(device, memory_device_buffers, NULL);
-    }
-    if(memory_device_images != NULL) {
-        vkFreeMemory(device, memory_device_images, NULL);
-    }
-    if(memory_host_transfer != NULL) {
-        vkFreeMemory(device, memory_host_transfer, NULL);
-    }
+    video_memory_release(vulkan_device, &vulkan_device->video_memory_device_buffers);
+    video_memory_release(vulkan_device, &vulkan_device->video_memory_device_images);
+    video_memory_release(vulkan_device, &vulkan_device->video_memory_host_transfer);
+    video_memory_release(vulkan_device, &vulkan_device->video_memory_host_readback);
 
     if(vulkan_device->command_pool_render != NULL) {
-        vkDestroyCommandPool(device, vulkan_device->command_pool_render, NULL);
+        vkDestroyCommandPool(device, vulkan_device->command_pool_render, vulkan_device->allocator);
     }
     if(vulkan_device->command_pool_compute != NULL) {
-        vkDestroyCommandPool(device, vulkan_device->command_pool_compute, NULL);
+        vkDestroyCommandPool(device, vulkan_device->command_pool_compute, vulkan_device->allocator);
     }
     if(vulkan_device->command_pool_transfer != NULL) {
-        vkDestroyCommandPool(device, vulkan_device->command_pool_transfer, NULL);
+        vkDestroyCommandPool(device, vulkan_device->command_pool_transfer, vulkan_device->allocator);
     }
 
-    vkDestroyDevice(device, NULL);
+    vkDestroyDevice(device, vulkan_device->allocator);
 
     *vulkan_device = (VulkanDevice){0};
 }
@@ -1135,7 +1194,7 @@ void destroy_vulkan_device(
 void destroy_vulkan_objects(
     VulkanObjects* vulkan_objects
 ) {
-    vkDestroySurfaceKHR(vulkan_objects->instance, vulkan_objects->surface, NULL);
+    vkDestroySurfaceKHR(vulkan_objects->instance, vulkan_objects->surface, vulkan_objects->allocator);
     destroy_window(vulkan_objects->window, vulkan_objects->window_name);
     
     if(vulkan_objects->debug_messenger != NULL) {
@@ -1143,10 +1202,10 @@ void destroy_vulkan_objects(
         if(destroy_debug_utils_messenger_ext == NULL) {
             LOG_ERROR("failed to load vkDestroyDebugUtilsMessengerEXT");
         }
-        destroy_debug_utils_messenger_ext(vulkan_objects->instance, vulkan_objects->debug_messenger, NULL);
+        destroy_debug_utils_messenger_ext(vulkan_objects->instance, vulkan_objects->debug_messenger, vulkan_objects->allocator);
     }
 
-    vkDestroyInstance(vulkan_objects->instance, NULL);
+    vkDestroyInstance(vulkan_objects->instance, vulkan_objects->allocator);
     *vulkan_objects = (VulkanObjects){0};
 }
 
@@ -1160,22 +1219,41 @@ CtxHandle gpu_start(
         LOG_ERROR("gpu_info is NULL");
         goto fail;
     }
+    const u32 frames_in_flight = gpu_info->frames_in_flight ? gpu_info->frames_in_flight : GPU_DEFAULT_FRAMES_IN_FLIGHT;
+    if(frames_in_flight > GPU_MAX_FRAMES_IN_FLIGHT) {
+        LOG_ERROR("too many frames in flight: %u/%u", frames_in_flight, GPU_MAX_FRAMES_IN_FLIGHT);
+        goto fail;
+    }
 
-    /* allocate virtual memory */
-    /* [context (aligned to 4KB)] + [4KB] + [GPU_VIRTUAL_RESOURCES_BASE : GPU_VIRTUAL_RESOURCES_LIMIT] */
-    const u64 ctx_size        = ALIGN(sizeof(GpuContext), 0x1000);
-    const u64 allocation_size = ctx_size + 0x1000 + GPU_VIRTUAL_RESOURCES_LIMIT;
-    GpuContext* context = VirtualAlloc(NULL, allocation_size, MEM_RESERVE, PAGE_READWRITE);
+    /* context lives at the start of its own permanent arena */
+    Arena arena_permanent = (Arena){0};
+    if(!arena_create(&arena_permanent, ARENA_LIFETIME_PERMANENT, sizeof(GpuContext))) {
+        LOG_ERROR("failed to create gpu permanent arena");
+        goto fail;
+    }
+    GpuContext* context = arena_push(&arena_permanent, sizeof(GpuContext), 0);
     if(context == NULL) {
-        LOG_ERROR("failed to allocate gpu virtual space");
+        LOG_ERROR("failed to allocate gpu context");
         goto fail;
     }
-    if(VirtualAlloc(context, ctx_size, MEM_COMMIT, PAGE_READWRITE) == NULL) {
-        LOG_ERROR("failed to commit context memory");
+    context->arena_permanent = arena_permanent;
+
+    if(!arena_create(&context->arena_shaders, ARENA_LIFETIME_LEVEL, GPU_ARENA_SHADERS_SIZE)) {
+        LOG_ERROR("failed to create gpu shaders arena");
+        goto fail;
+    }
+    if(!arena_create(&context->arena_bakes, ARENA_LIFETIME_LEVEL, GPU_ARENA_BAKES_SIZE)) {
+        LOG_ERROR("failed to create gpu bakes arena");
         goto fail;
     }
-    context->resources_base       = (u8*)context + ctx_size + 0x1000 + GPU_VIRTUAL_RESOURCES_BASE;
-    context->resources_limit      = (u8*)context + ctx_size + 0x1000 + GPU_VIRTUAL_RESOURCES_LIMIT;
+
+    /* every vulkan object is created with the context callbacks */
+    if(!host_allocator_init(&context->vulkan_host)) {
+        LOG_ERROR("failed to init host allocator");
+        goto fail;
+    }
+    context->vulkan_objects.allocator = &context->vulkan_host.callbacks;
+    context->vulkan_device.allocator  = &context->vulkan_host.callbacks;
 
     /* create context */
     if(!create_vulkan_objects(
@@ -1198,6 +1276,8 @@ CtxHandle gpu_start(
         LOG_ERROR("failed to create vulkan device");
         goto fail;
     }
+    context->vulkan_device.frames_in_flight    = frames_in_flight;
+    context->vulkan_device.frame_overlap_check = gpu_info->frame_overlap_check;
 
     return context;
 
@@ -1218,11 +1298,13 @@ void gpu_stop(
 
     destroy_vulkan_device(&context->vulkan_objects, &context->vulkan_device);
     destroy_vulkan_objects(&context->vulkan_objects);
+    host_allocator_release(&context->vulkan_host);
 
-    if(!VirtualFree(context, 0, MEM_RELEASE)) {
-        LOG_ERROR("failed to free virtual context memory");
-        goto fail;
-    }
+    /* context is gone after this */
+    Arena arena_permanent = context->arena_permanent;
+    arena_destroy(&context->arena_shaders);
+    arena_destroy(&context->arena_bakes);
+    arena_destroy(&arena_permanent);
 
     fail: {};
 }
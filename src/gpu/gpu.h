@@ -3,14 +3,30 @@
 
 #include "../base.h"
 
-#define VRAM_SIZE_DEVICE_BUFFERS (256 * 1024 * 1024)
-#define VRAM_SIZE_DEVICE_IMAGES  (512 * 1024 * 1024)
-#define VRAM_SIZE_HOST_TRANSFER  (512 * 1024 * 1024)
+#define GPU_MAX_FRAMES_IN_FLIGHT     (4)
+#define GPU_DEFAULT_FRAMES_IN_FLIGHT (2)
 
-#define GPU_SYNC_TRANSFER_SIZE   (         4 * 1024)
+/* per frame in flight, carved from host transfer memory */
+#define GPU_UPLOAD_FRAME_SIZE    (  16 * 1024 * 1024)
+/* background uploads, carved from host transfer memory */
+#define GPU_STREAM_RING_SIZE     ( 128 * 1024 * 1024)
+/* readbacks, carved from host readback memory */
+#define GPU_READBACK_RING_SIZE   (  32 * 1024 * 1024)
 
-#define VRAM_SIZE_DEVICE_VULKAN  (VRAM_SIZE_DEVICE_BUFFERS + VRAM_SIZE_DEVICE_IMAGES)
-#define VRAM_SIZE_HOST_VULKAN    (VRAM_SIZE_HOST_TRANSFER                           )
+/* memory blocks are sized from the heap budgets at startup and clamped to these */
+/* more blocks are allocated on demand while the heap budget allows, emptied ones are freed */
+#define VRAM_BLOCK_MIN_DEVICE_BUFFERS (  32 * 1024 * 1024)
+#define VRAM_BLOCK_MAX_DEVICE_BUFFERS ( 256 * 1024 * 1024)
+#define VRAM_BLOCK_MIN_DEVICE_IMAGES  (  64 * 1024 * 1024)
+#define VRAM_BLOCK_MAX_DEVICE_IMAGES  ( 512 * 1024 * 1024)
+#define VRAM_BLOCK_MIN_HOST_TRANSFER  (GPU_UPLOAD_FRAME_SIZE * GPU_MAX_FRAMES_IN_FLIGHT + GPU_STREAM_RING_SIZE + 16 * 1024 * 1024)
+#define VRAM_BLOCK_MAX_HOST_TRANSFER  ( 512 * 1024 * 1024)
+/* holds the readback ring only */
+#define VRAM_BLOCK_HOST_READBACK      (GPU_READBACK_RING_SIZE + 1024 * 1024)
+/* left to the driver, swapchain and other processes */
+#define VRAM_RESERVE_DEVICE           ( 256 * 1024 * 1024)
+/* pressure callback fires once usage of a heap passes this part of its budget */
+#define GPU_MEMORY_PRESSURE_PERCENT   (90)
 
 #define GPU_SHADER_ENTRY_VERTEX   "main_vertex"
 #define GPU_SHADER_ENTRY_FRAGMENT "main_fragment"
@@ -18,9 +34,15 @@
 
 #define GPU_MAX_STATIC_BUFFERS          (32)
 #define GPU_MAX_STATIC_IMAGES           (32)
+/* static and runtime resources, runtime ones take the slots after the static ones */
+#define GPU_MAX_BUFFERS                 (128)
+#define GPU_MAX_IMAGES                  (128)
 #define GPU_MAX_COLOR_ATTACHMENTS       (8)
 #define GPU_MAX_BINDINGS_PER_DESCRIPTOR (16)
 #define GPU_PUSH_CONSTANTS_SIZE         (64)
+/* bytes a shader reads at a frame uniforms offset */
+#define GPU_FRAME_UNIFORMS_RANGE        (256)
+#define GPU_MAX_RECORD_THREADS          (8)
 
 #define GPU_SAMPLER_LINEAR_REPEAT_ID    (0)
 #define GPU_SAMPLER_LINEAR_CLAMP_ID     (1)
@@ -28,6 +50,8 @@
 #define GPU_SAMPLER_NEAREST_CLAMP_ID    (3)
 
 #define GPU_IMAGE_SURFACE_ID            (0xFFFFFFFE)
+/* pass functions record into the current command buffer, between begin/end_drawing */
+#define GPU_INLINE_PASS_ID              (0xFFFFFFFF)
 
 typedef u32 GpuFormat;
 typedef u32 GpuImageFlags;
@@ -57,14 +81,26 @@ enum GpuImageFlags {
     GPU_IMAGE_FLAG_DEPTH_ATTACHMENT = 0x2,
     GPU_IMAGE_FLAG_SAMPLED          = 0x4,
     GPU_IMAGE_FLAG_STORAGE          = 0x8,
-    GPU_IMAGE_FLAGS_MASK            = 0xF
+    /* contents and layout survive frames, for history images */
+    GPU_IMAGE_FLAG_PERSISTENT       = 0x10,
+    /* contents live only inside lifetime, memory is shared with transient images of disjoint lifetimes */
+    /* attachment only transient images use lazily allocated memory when the adapter has it */
+    GPU_IMAGE_FLAG_TRANSIENT        = 0x20,
+    /* size_x and size_y are percent of the swapchain size, recreated in place on resize */
+    GPU_IMAGE_FLAG_SURFACE_RELATIVE = 0x40,
+    GPU_IMAGE_FLAGS_MASK            = 0x7F
 };
 
 enum GpuBufferFlags {
     GPU_BUFFER_FLAGS_NONE            = 0x0,
     GPU_BUFFER_FLAG_UNIFORM_BUFFER   = 0x1,
     GPU_BUFFER_FLAG_STORAGE_BUFFER   = 0x2,
-    GPU_BUFFER_FLAGS_MASK            = 0x3
+    /* host visible, one slot per frame in flight, bind as UNIFORM_BUFFER_DYNAMIC */
+    GPU_BUFFER_FLAG_LATE_LATCH       = 0x4,
+    /* host visible, size bytes per frame in flight handed out by gpu_render_allocate_uniforms */
+    /* uniform buffer only, bind as UNIFORM_BUFFER_DYNAMIC */
+    GPU_BUFFER_FLAG_FRAME_UNIFORMS   = 0x8,
+    GPU_BUFFER_FLAGS_MASK            = 0xF
 };
 
 enum GpuPipelineType {
@@ -74,13 +110,14 @@ enum GpuPipelineType {
 };
 
 enum GpuDescriptorType {
-    GPU_DESCRIPTOR_TYPE_NONE           = 0,
-    GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER = 1,
-    GPU_DESCRIPTOR_TYPE_STORAGE_BUFFER = 2,
-    GPU_DESCRIPTOR_TYPE_SAMPLED_IMAGE  = 3,
-    GPU_DESCRIPTOR_TYPE_STORAGE_IMAGE  = 4,
-    GPU_DESCRIPTOR_TYPE_SAMPLER        = 5,
-    GPU_DESCRIPTOR_TYPE_COUNT          = 6
+    GPU_DESCRIPTOR_TYPE_NONE                   = 0,
+    GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER         = 1,
+    GPU_DESCRIPTOR_TYPE_STORAGE_BUFFER         = 2,
+    GPU_DESCRIPTOR_TYPE_SAMPLED_IMAGE          = 3,
+    GPU_DESCRIPTOR_TYPE_STORAGE_IMAGE          = 4,
+    GPU_DESCRIPTOR_TYPE_SAMPLER                = 5,
+    GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC = 6,
+    GPU_DESCRIPTOR_TYPE_COUNT                  = 7
 };
 
 enum GpuDescriptorSets {
@@ -96,6 +133,10 @@ typedef struct {
     GpuFormat     format;
     u32           size_x;
     u32           size_y;
+    /* transient only, inclusive range of passes in frame order, U32_MAX = unused */
+    /* first use inside a frame has to discard contents */
+    u32           lifetime_first;
+    u32           lifetime_last;
 } ImageInfo;
 
 typedef struct {
@@ -128,6 +169,11 @@ typedef struct {
     u16         pci_vendor_id;
     u16         pci_device_id;
     b32         vulkan_debug_enabled;
+    /* 0 = GPU_DEFAULT_FRAMES_IN_FLIGHT */
+    u32         frames_in_flight;
+    /* debug, periodically logs cpu recording time against gpu frame time and how often they overlapped */
+    /* frame_end fails when gpu bound frames never found the previous frame still executing */
+    b32         frame_overlap_check;
 } GpuInfo;
 
 typedef struct {
@@ -178,11 +224,111 @@ typedef struct {
     u32        buffers_read_only_count;
 } ComputeInfo;
 
+/* buffer: offset and size in bytes */
+/* image: texel rectangle of the first mip and layer, read back tightly packed */
+typedef struct {
+    u32 resource_id;
+    b32 is_image;
+    u64 offset;
+    u64 size;
+    u32 x;
+    u32 y;
+    u32 size_x;
+    u32 size_y;
+} ReadbackInfo;
+
+/* barriers recorded during one frame, replayed bakes record none */
+typedef struct {
+    /* barriers written to command buffers */
+    u32 barriers_emitted;
+    /* read after read and repeated transitions that were dropped */
+    u32 barriers_elided;
+    /* barrier calls of drawing passes and compute barriers */
+    u32 barrier_calls;
+} BarrierStats;
+
+/* heaps holding device memory blocks and host transfer blocks, same values on unified memory */
+typedef struct {
+    u64 device_budget;
+    u64 device_usage;
+    u64 host_budget;
+    u64 host_usage;
+} GpuMemoryBudget;
+
+/* one memory class, blocks of the same memory type */
+typedef struct {
+    u32 blocks_count;
+    u32 allocations_count;
+    /* device memory blocks */
+    u64 reserved;
+    u64 used;
+    u64 peak;
+    /* alignment and size rounding of resources, part of used */
+    u64 padding;
+    u64 largest_free;
+    /* 1 - largest_free / free, 0 = free memory is one range */
+    f32 fragmentation;
+} GpuMemorySectionStats;
+
+/* host memory the driver allocates through the context callbacks, one per VkSystemAllocationScope */
+enum GpuHostScopes {
+    GPU_HOST_SCOPE_COMMAND  = 0,
+    GPU_HOST_SCOPE_OBJECT   = 1,
+    GPU_HOST_SCOPE_CACHE    = 2,
+    GPU_HOST_SCOPE_DEVICE   = 3,
+    GPU_HOST_SCOPE_INSTANCE = 4,
+    GPU_HOST_SCOPE_COUNT    = 5
+};
+
+typedef struct {
+    u32 allocations_count;
+    /* allocation and reallocation calls since start */
+    u32 allocations_total;
+    /* scope pool was full, allocation went to the process heap */
+    u32 heap_fallbacks;
+    /* pages of the scope range */
+    u64 committed;
+    u64 used;
+    u64 peak;
+    /* driver allocated on its own and only reported it */
+    u64 internal;
+} GpuHostScopeStats;
+
+typedef struct {
+    GpuMemoryBudget       budget;
+    GpuMemorySectionStats device_buffers;
+    GpuMemorySectionStats device_images;
+    GpuMemorySectionStats host_transfer;
+    GpuMemorySectionStats host_readback;
+    GpuHostScopeStats     host_scopes[GPU_HOST_SCOPE_COUNT];
+} GpuMemoryStats;
+
+/* called by frame_end right before submit */
+typedef void (*GpuLatchFunc)(CtxHandle ctx, void* user_data);
+/* called by frame_begin, resources can be destroyed from it */
+typedef void (*GpuMemoryPressureFunc)(CtxHandle ctx, const GpuMemoryBudget* budget, void* user_data);
+
 CtxHandle gpu_start(const GpuInfo* gpu_info);
 void      gpu_stop(CtxHandle ctx);
 
 b32  gpu_allocate_resources(CtxHandle ctx, const ResourcesInfo* resources_info);
 void gpu_release_resources(CtxHandle ctx);
+/* runtime resources, created after allocate_resources, return handle, U32_MAX = fail */
+/* handles are used like static ids, static ids are handles that never go stale */
+/* destroyed handles are invalid right away, memory is freed once the frames that could use them retired */
+/* bindings using a runtime resource have to be rewritten after it changes, its uploads have to be complete before destroy */
+u32  gpu_create_buffer(CtxHandle ctx, const BufferInfo* buffer_info);
+u32  gpu_create_image(CtxHandle ctx, const ImageInfo* image_info);
+void gpu_destroy_buffer(CtxHandle ctx, u32 buffer_id);
+void gpu_destroy_image(CtxHandle ctx, u32 image_id);
+/* budgets are reported by the driver when it has VK_EXT_memory_budget, estimated from heap sizes otherwise */
+void gpu_query_memory_budget(CtxHandle ctx, GpuMemoryBudget* budget);
+/* pressure is reported when a heap passes GPU_MEMORY_PRESSURE_PERCENT of its budget or a block could not grow */
+/* NULL = none */
+void gpu_set_memory_pressure_callback(CtxHandle ctx, GpuMemoryPressureFunc func, void* user_data);
+void gpu_query_memory_stats(CtxHandle ctx, GpuMemoryStats* stats);
+/* stats and every resource as json, returns the full length even when buffer is too small, like snprintf */
+u64  gpu_dump_memory_stats(CtxHandle ctx, char* buffer, u64 buffer_size);
 
 b32  gpu_compile_shaders(CtxHandle ctx, const ShadersInfo* shaders_info);
 void gpu_release_shaders(CtxHandle ctx);
@@ -193,17 +339,79 @@ void gpu_render_terminate(CtxHandle ctx);
 /* 0 = success; 1 = fail; 2 = window_terminated */
 i32  gpu_render_frame_begin(CtxHandle ctx, u32* screen_x, u32* screen_y);
 i32  gpu_render_frame_end(CtxHandle ctx);
+/* frame timeline, n-th frame signals n once the gpu is done with it */
+u64  gpu_render_frame_counter(CtxHandle ctx);
+u64  gpu_render_frame_completed(CtxHandle ctx);
+/* milliseconds the gpu spent on the last retired frame, 0 = not measured yet or no timestamps */
+f32  gpu_render_frame_gpu_time(CtxHandle ctx);
+b32  gpu_render_frame_wait(CtxHandle ctx, u64 frame_value, u64 timeout);
+/* stats of the last ended frame */
+void gpu_render_barrier_stats(CtxHandle ctx, BarrierStats* stats);
 /* drawing */
 void gpu_render_begin_drawing(CtxHandle ctx, const DrawingInfo* drawing_info);
 void gpu_render_end_drawing(CtxHandle ctx);
-void gpu_render_bind_graphics_pipeline(CtxHandle ctx, u32 pipeline_id);
+/* dynamic_offsets has one offset per dynamic binding in set then binding order, descriptor sets are rebound with them */
+/* NULL keeps the bound offsets, U32_MAX entries point to the frame slot */
+void gpu_render_bind_graphics_pipeline(CtxHandle ctx, u32 pipeline_id, const u32* dynamic_offsets);
 void gpu_render_push_constants(CtxHandle ctx, const void* constants, u64 size);
 void gpu_render_draw(CtxHandle ctx, i32 instance_count, i32 vertex_count);
-/* sync transfer */
+/* parallel drawing */
+/* passes are declared in order on the main thread, declaration records nothing but resolves barriers */
+/* pass contents can be recorded from any thread, each thread with its own thread_id < GPU_MAX_RECORD_THREADS */
+/* end_passes stitches passes in declaration order and must be called after all threads finished recording */
+/* passes that failed or were never ended are skipped and end_passes returns FALSE */
+void gpu_render_begin_passes(CtxHandle ctx);
+u32  gpu_render_declare_pass(CtxHandle ctx, const DrawingInfo* drawing_info);
+b32  gpu_render_end_passes(CtxHandle ctx);
+b32  gpu_render_pass_begin(CtxHandle ctx, u32 pass_id, u32 thread_id);
+void gpu_render_pass_end(CtxHandle ctx, u32 pass_id);
+void gpu_render_pass_bind_graphics_pipeline(CtxHandle ctx, u32 pass_id, u32 pipeline_id, const u32* dynamic_offsets);
+void gpu_render_pass_push_constants(CtxHandle ctx, u32 pass_id, const void* constants, u64 size);
+void gpu_render_pass_draw(CtxHandle ctx, u32 pass_id, i32 instance_count, i32 vertex_count);
+/* baked frames */
+/* drawing and compute between bake_begin/bake_end is recorded once per swapchain image and frame slot */
+/* bake_begin returns FALSE when the bake is replayed, nothing has to be recorded then but bake_end is still called */
+/* bakes are rerecorded after resize, bake_invalidate or when resource states at bake_begin differ */
+/* bake_invalidate has to be called after shaders, resources or bindings change */
+/* only late latch buffers can change inside a bake */
+b32  gpu_render_bake_begin(CtxHandle ctx);
+void gpu_render_bake_end(CtxHandle ctx);
+void gpu_render_bake_invalidate(CtxHandle ctx);
+/* upload ring transfer, copies are batched until next drawing/compute/frame end */
+/* late latch buffers are written in place and can be written until the latch callback returns */
 void gpu_render_write_buffer(CtxHandle ctx, u32 buffer_id, const void* data, u64 offset, u64 size);
+/* latch callback for the current frame, reset by frame_begin */
+/* runs right before the first submit of the frame, end_async_compute submits early when there is a compute queue */
+/* late latch buffers can't be written and the latch can't be set once that happened */
+void gpu_render_set_latch(CtxHandle ctx, GpuLatchFunc func, void* user_data);
+/* frame uniforms, copies data into the next free slice of the frame slot and returns its dynamic offset, U32_MAX = fail */
+/* size up to GPU_FRAME_UNIFORMS_RANGE, can be called from record threads, not inside bakes */
+u32  gpu_render_allocate_uniforms(CtxHandle ctx, u32 buffer_id, const void* data, u64 size);
 /* compute */
+/* between begin/end compute is recorded for the dedicated compute queue, if there is one */
+/* render work recorded until wait_async_compute overlaps with it and must not touch its resources */
+/* upload writes have to be done before begin_async_compute */
+void gpu_render_begin_async_compute(CtxHandle ctx);
+void gpu_render_end_async_compute(CtxHandle ctx);
+void gpu_render_wait_async_compute(CtxHandle ctx);
 void gpu_render_compute_barrier(CtxHandle ctx, const ComputeInfo* compute_info);
-void gpu_render_bind_compute_pipeline(CtxHandle ctx, u32 pipeline_id);
+void gpu_render_bind_compute_pipeline(CtxHandle ctx, u32 pipeline_id, const u32* dynamic_offsets);
 void gpu_render_dispatch(CtxHandle ctx, u32 groups_x, u32 groups_y, u32 groups_z);
 
+/* background uploads on the transfer queue, return completion token, 0 = fail */
+/* destination must not be used by the gpu until the token is complete */
+/* copies wait for submitted frames to retire, between frame_begin and frame_end the batch is submitted by frame_end and waits for that frame too */
+/* late latch and frame uniforms buffers can't be uploaded */
+/* token completes on the first frame_begin after the transfer finished, image data is tightly packed */
+u64  gpu_upload_buffer_async(CtxHandle ctx, u32 buffer_id, const void* data, u64 offset, u64 size);
+u64  gpu_upload_image_async(CtxHandle ctx, u32 image_id, const void* data, u64 size);
+b32  gpu_upload_is_complete(CtxHandle ctx, u64 token);
+
+/* readbacks into host cached memory, return ticket, 0 = fail */
+/* copy is recorded into the frame command buffer, outside drawing, passes, bakes and async compute */
+/* ticket resolves once its frame retired, data is kept until polled or expires when the ring needs the space */
+u64  gpu_request_readback(CtxHandle ctx, const ReadbackInfo* readback_info);
+/* never waits; 0 = ready, up to data_size bytes copied and ticket released; 1 = pending; 2 = unknown or expired ticket */
+i32  gpu_readback_poll(CtxHandle ctx, u64 ticket, void* data, u64 data_size);
+
 #endif
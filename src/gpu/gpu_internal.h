@@ -2,15 +2,20 @@
 #define _GPU_INTERNAL_INCLUDED
 
 #include "gpu.h"
+#include "../arena/arena.h"
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #include <windows.h>
 #include <vulkan/vulkan.h>
 
-#define GPU_VIRTUAL_RESOURCES_BASE         (0x0000000000000000)
-#define GPU_VIRTUAL_SHADERS_BASE           (0x0000000000010000)
-#define GPU_VIRTUAL_SHADERS_LIMIT          (0x000000000001F000)
-#define GPU_VIRTUAL_RESOURCES_LIMIT        (0x0000000000020000)
+/* pipeline handles, reset by gpu_release_shaders */
+#define GPU_ARENA_SHADERS_SIZE             (0x0000000000100000)
+/* baked frames, pushed on first use of a swapchain image and frame slot, reset by gpu_render_terminate */
+#define GPU_ARENA_BAKES_SIZE               (sizeof(GpuBake) * GPU_MAX_SWAPCHAIN_IMAGES * GPU_MAX_FRAMES_IN_FLIGHT)
+
+/* driver host allocations, permanent arena per allocation scope, committed as it grows */
+#define GPU_HOST_SCOPE_SIZE                (0x0000000002000000)
+#define GPU_HOST_MIN_ALIGNMENT             (16)
 
 #define GPU_MAX_GRAPHICS_ADAPTERS          (8)
 #define GPU_MAX_NAME_LENGTH                (32)
@@ -20,9 +25,47 @@
 #define GPU_MAX_QUEUE_FAMILIES             (32)
 #define GPU_MAX_SWAPCHAIN_IMAGES           (32)
 
+#define GPU_MAX_UPLOAD_COPIES              (256)
+#define GPU_UPLOAD_ALIGNMENT               (16)
+#define GPU_MAX_UPLOAD_BATCHES             (256)
+#define GPU_MAX_PARALLEL_PASSES            (16)
+#define GPU_MAX_DYNAMIC_BINDINGS           (8)
+#define GPU_MAX_RETIRED_RESOURCES          (64)
+#define GPU_MAX_DIRTY_RANGES               (64)
+#define GPU_MAX_READBACKS                  (64)
+#define GPU_READBACK_ALIGNMENT             (16)
+
+/* resource handles, slot in low bits, generation of the slot in high bits */
+#define GPU_HANDLE_SLOT_MASK               (0xFFFF)
+#define GPU_HANDLE_GENERATION_SHIFT        (16)
+
+/* tlsf pools, one per device memory block */
+#define GPU_MEMORY_MAX_BLOCKS              (1024)
+/* device memory blocks per memory class, allocation ids keep the block above the pool block */
+#define GPU_MAX_VIDEO_MEMORY_BLOCKS        (8)
+#define GPU_VIDEO_MEMORY_BLOCK_SHIFT       (16)
+/* frames between budget polls */
+#define GPU_MEMORY_BUDGET_POLL_FRAMES      (16)
+/* frames averaged per frame overlap log line and check */
+#define GPU_OVERLAP_CHECK_FRAMES           (256)
+#define GPU_MEMORY_SL_LOG2                 (4)
+#define GPU_MEMORY_SL_COUNT                (1 << GPU_MEMORY_SL_LOG2)
+#define GPU_MEMORY_FL_COUNT                (64)
+
 #define GPU_OPTIMAL_SWAPCHAIN_IMAGES       (2)
 #define GPU_EMPTY_DESCRIPTOR_TYPE          (VK_DESCRIPTOR_TYPE_SAMPLER)
 
+/* accesses that need a barrier even after the same access */
+#define GPU_ACCESS_WRITE_MASK              (             \
+    VK_ACCESS_2_SHADER_WRITE_BIT                       | \
+    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT               | \
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT             | \
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT     | \
+    VK_ACCESS_2_TRANSFER_WRITE_BIT                     | \
+    VK_ACCESS_2_HOST_WRITE_BIT                         | \
+    VK_ACCESS_2_MEMORY_WRITE_BIT                         \
+)
+
 typedef struct {
     u16                  vendor_id;
     u16                  device_id;
@@ -36,19 +79,41 @@ typedef struct {
     VkPresentModeKHR     surface_present_mode;
     u64                  heap_device_size;
     u64                  heap_host_size;
+    u64                  uniform_offset_alignment;
+    /* flushes of non coherent maps are aligned to it */
+    u64                  non_coherent_atom_size;
+    /* VK_EXT_memory_budget is enabled */
+    b32                  memory_budget;
+    /* nanoseconds per timestamp tick, 0 = no timestamps on render queue */
+    f32                  timestamp_period;
 } GraphicsAdapter;
 
 typedef struct {
     VkBufferUsageFlags usage;
+    /* memory pool block, U32_MAX = not owned */
+    u32                allocation_id;
     u64                allocation_offset;
     u64                allocation_size;
     u64                used_size;
+    /* late latch and frame uniforms slot stride, 0 for device local buffers */
+    u64                frame_stride;
+    /* slot is sub allocated per frame, used_size is the slot capacity */
+    b32                frame_uniforms;
     VkBuffer           buffer;
+    /* memory block, map is NULL when the block is not host visible */
+    VkDeviceMemory     memory;
+    void*              memory_map;
+    /* atom aligned flush and invalidate ranges are clamped to it */
+    u64                memory_size;
+    /* host writes to coherent maps need no flush */
+    b32                host_coherent;
 } GpuBuffer;
 
 typedef struct {
     VkImageUsageFlags  usage;
     VkFormat           format;
+    /* memory pool block, U32_MAX for transient and lazy images */
+    u32                allocation_id;
     u64                allocation_offset;
     u64                allocation_size;
     u32                size_x;
@@ -56,80 +121,227 @@ typedef struct {
     VkImage            image;
     VkImageView        view;
     VkImageAspectFlags aspect;
+    /* contents and layout survive frames */
+    b32                persistent;
+    b32                transient;
+    /* transient images sharing memory with this one */
+    u32                alias_mask;
+    /* dedicated lazily allocated memory, NULL when bound to images memory */
+    VkDeviceMemory     lazy_memory;
 } GpuImage;
 
+/* destroyed runtime resource, kept in its slot until frame_value retired */
+typedef struct {
+    u64 frame_value;
+    b32 is_image;
+    u32 slot;
+} GpuRetiredResource;
+
+/* headers of device memory ranges, free blocks are also in a segregated list */
+typedef struct {
+    u64 offset;
+    u64 size;
+    u32 prev_physical;
+    u32 next_physical;
+    u32 prev_free;
+    u32 next_free;
+    b32 is_free;
+} GpuMemoryBlock;
+
 typedef struct {
     VkDeviceMemory memory;
-    u64            offset;
-    u64            limit;
-} GpuMemorySection;
+    u64            size;
+    u64            used;
+    u64            fl_bitmap;
+    u32            sl_bitmaps   [GPU_MEMORY_FL_COUNT];
+    u32            free_heads   [GPU_MEMORY_FL_COUNT][GPU_MEMORY_SL_COUNT];
+    GpuMemoryBlock blocks       [GPU_MEMORY_MAX_BLOCKS];
+    u32            unused_blocks[GPU_MEMORY_MAX_BLOCKS];
+    u32            unused_blocks_count;
+} GpuMemoryPool;
 
+/* last access of a resource, carried over to the next frame */
 typedef struct {
-    VkAccessFlags        access;
-    VkImageLayout        layout;
-    VkPipelineStageFlags stage;
+    VkAccessFlags2        access;
+    VkImageLayout         layout;
+    VkPipelineStageFlags2 stage;
 } GpuImageState;
 
 typedef struct {
-    VkAccessFlags        access;
-    VkPipelineStageFlags stage;
+    VkAccessFlags2        access;
+    VkPipelineStageFlags2 stage;
 } GpuBufferState;
 
+/* copy recorded on the next flush_upload_copies */
+typedef struct {
+    u32          buffer_id;
+    VkBufferCopy region;
+} GpuUploadCopy;
+
+/* ring positions only grow, [ring_begin : ring_end] includes the padding in front of the data */
+typedef struct {
+    u64 ticket;
+    /* frame timeline value of the frame the copy was recorded in */
+    u64 frame_value;
+    u64 ring_begin;
+    u64 ring_end;
+    /* data offset inside buffer_readback_ring */
+    u64 offset;
+    u64 size;
+    /* frame retired and the range is invalidated */
+    b32 resolved;
+    /* polled or expired, ring space is freed once it reaches the front */
+    b32 released;
+} GpuReadback;
+
+/* host written bytes of a non coherent block, aligned to the atom size, disjoint with other ranges of the block */
+typedef struct {
+    VkDeviceMemory memory;
+    u64            begin;
+    u64            end;
+} GpuDirtyRange;
+
+/* one background upload, slot is reused after the render queue acquired it */
+typedef struct {
+    u64             token;
+    u64             stream_end;
+    VkCommandBuffer command_buffer;
+    b32             is_image;
+    u32             resource_id;
+    u64             offset;
+    u64             size;
+    VkImageLayout   layout;
+} GpuUploadBatch;
+
+/* NULL device_memory = unused block */
+typedef struct {
+    VkDeviceMemory device_memory;
+    void*          memory_map;
+    GpuMemoryPool  pool;
+} GpuVideoMemoryBlock;
+
+/* written right before the pointer handed to the driver */
+typedef struct {
+    /* pool block, U32_MAX = process heap */
+    u32 block_id;
+    u32 scope;
+    /* from the start of the allocation to the pointer */
+    u64 offset;
+    u64 size;
+} GpuHostHeader;
+
+/* the driver can call from any thread, the lock guards the whole scope */
+typedef struct {
+    SRWLOCK       lock;
+    Arena         arena;
+    u64           used;
+    u64           peak;
+    u64           internal;
+    u32           allocations_count;
+    u32           allocations_total;
+    u32           heap_fallbacks;
+    GpuMemoryPool pool;
+} GpuHostScope;
+
+/* memory class, blocks of one memory type, first one lives as long as the device */
 typedef struct {
-    VkDeviceMemory        device_memory;
-    void*                 memory_map;
     u32                   type_id;
+    u32                   heap_id;
     VkMemoryPropertyFlags type_flags;
+    /* size new blocks get, larger requests get a block of their own */
+    u64                   block_size;
+    /* pool block bytes over all blocks */
+    u64                   used;
+    u64                   peak;
+    u32                   blocks_count;
+    GpuVideoMemoryBlock   blocks[GPU_MAX_VIDEO_MEMORY_BLOCKS];
 } GpuVideoMemoryAllocation;
 
 /* CONTEXT STRUCTS */
 
 typedef struct {
-    HWND                     window;
-    VkInstance               instance;
-    VkSurfaceKHR             surface;
-    VkDebugUtilsMessengerEXT debug_messenger;
-    u32                      available_devices_count;
-    GraphicsAdapter          available_devices[GPU_MAX_GRAPHICS_ADAPTERS];
-    char                     window_name[GPU_MAX_NAME_LENGTH];
+    VkAllocationCallbacks callbacks;
+    GpuHostScope          scopes[GPU_HOST_SCOPE_COUNT];
+} VulkanHost;
+
+typedef struct {
+    const VkAllocationCallbacks* allocator;
+    HWND                         window;
+    VkInstance                   instance;
+    VkSurfaceKHR                 surface;
+    VkDebugUtilsMessengerEXT     debug_messenger;
+    u32                          available_devices_count;
+    GraphicsAdapter              available_devices[GPU_MAX_GRAPHICS_ADAPTERS];
+    char                         window_name[GPU_MAX_NAME_LENGTH];
 } VulkanObjects;
 
 typedef struct {
-    VkDevice                   device;
-    const GraphicsAdapter*     adapter;
-    VkQueue                    queue_render;
-    VkQueue                    queue_compute;
-    VkQueue                    queue_transfer;
-    VkCommandPool              command_pool_render;
-    VkCommandPool              command_pool_compute;
-    VkCommandPool              command_pool_transfer;
-    PFN_vkCmdBeginRenderingKHR cmd_begin_rendering_khr;
-    PFN_vkCmdEndRenderingKHR   cmd_end_rendering_khr;
-
-    GpuVideoMemoryAllocation   video_memory_device_buffers;
-    GpuVideoMemoryAllocation   video_memory_device_images;
-    GpuVideoMemoryAllocation   video_memory_host_transfer;
+    const VkAllocationCallbacks* allocator;
+    VkDevice                     device;
+    const GraphicsAdapter*       adapter;
+    VkQueue                      queue_render;
+    VkQueue                      queue_compute;
+    VkQueue                      queue_transfer;
+    VkCommandPool                command_pool_render;
+    VkCommandPool                command_pool_compute;
+    VkCommandPool                command_pool_transfer;
+    PFN_vkCmdBeginRenderingKHR   cmd_begin_rendering_khr;
+    PFN_vkCmdEndRenderingKHR     cmd_end_rendering_khr;
+    PFN_vkCmdPipelineBarrier2KHR cmd_pipeline_barrier2_khr;
+    u32                          frames_in_flight;
+    b32                          frame_overlap_check;
+    /* for attachment only transient images, U32_MAX = adapter has none */
+    u32                          lazy_memory_type_id;
+
+    GpuVideoMemoryAllocation     video_memory_device_buffers;
+    GpuVideoMemoryAllocation     video_memory_device_images;
+    GpuVideoMemoryAllocation     video_memory_host_transfer;
+    /* blocks_count = 0 when the adapter has no host visible memory for it */
+    GpuVideoMemoryAllocation     video_memory_host_readback;
+
+    /* budget pressure, reported from frame_begin */
+    GpuMemoryPressureFunc        memory_pressure_func;
+    void*                        memory_pressure_user_data;
+    b32                          memory_pressure;
+    /* a block failed to grow since the last poll */
+    b32                          memory_pressure_pending;
 } VulkanDevice;
 
 typedef struct {
-    VkSwapchainKHR swapchain;
-    VkImage        swapchain_images[GPU_MAX_SWAPCHAIN_IMAGES];
-    VkImageView    swapchain_views [GPU_MAX_SWAPCHAIN_IMAGES];
-    u32            swapchain_images_count;
-    u32            swapchain_x;
-    u32            swapchain_y;
+    VkSwapchainKHR     swapchain;
+    VkImage            swapchain_images[GPU_MAX_SWAPCHAIN_IMAGES];
+    VkImageView        swapchain_views [GPU_MAX_SWAPCHAIN_IMAGES];
+    u32                swapchain_images_count;
+    u32                swapchain_x;
+    u32                swapchain_y;
 
-    VkSampler      sampler_linear_repeat;
-    VkSampler      sampler_linear_clamp;
-    VkSampler      sampler_nearest_repeat;
-    VkSampler      sampler_nearest_clamp;    
+    VkSampler          sampler_linear_repeat;
+    VkSampler          sampler_linear_clamp;
+    VkSampler          sampler_nearest_repeat;
+    VkSampler          sampler_nearest_clamp;    
 
-    GpuBuffer      buffer_sync_transfer;
+    GpuBuffer          buffer_upload_ring;
+    GpuBuffer          buffer_stream_ring;
+    /* NULL buffer = readbacks are not available */
+    GpuBuffer          buffer_readback_ring;
 
-    GpuBuffer      buffers[GPU_MAX_STATIC_BUFFERS];
-    GpuImage       images [GPU_MAX_STATIC_IMAGES ];
-    u32            buffers_count;
-    u32            images_count;
+    /* static resources first, then runtime ones, NULL buffer or image = free slot */
+    GpuBuffer          buffers           [GPU_MAX_BUFFERS];
+    GpuImage           images            [GPU_MAX_IMAGES ];
+    u32                buffer_generations[GPU_MAX_BUFFERS];
+    u32                image_generations [GPU_MAX_IMAGES ];
+    /* slots up to the highest one ever used */
+    u32                buffers_count;
+    u32                images_count;
+    u32                static_buffers_count;
+    u32                static_images_count;
+    /* one block holds all transient images */
+    u32                transient_allocation_id;
+    /* infos images were created from, surface relative sizes unresolved */
+    ImageInfo          image_infos       [GPU_MAX_IMAGES ];
+
+    GpuRetiredResource retired[GPU_MAX_RETIRED_RESOURCES];
+    u32                retired_count;
 } VulkanResources;
 
 typedef struct {
@@ -139,51 +351,444 @@ typedef struct {
     /* descriptor_types[binding_id + set_id * GPU_MAX_BINDINGS_PER_DESCRIPTOR] */
     VkDescriptorType      descriptor_types  [GPU_DESCRIPTOR_SET_COUNT * GPU_MAX_BINDINGS_PER_DESCRIPTOR];
 
+    /* dynamic uniform buffers in set/binding order, the order of bind offsets */
+    u32                   dynamic_bindings  [GPU_MAX_DYNAMIC_BINDINGS];
+    u32                   dynamic_buffer_ids[GPU_MAX_DYNAMIC_BINDINGS];
+    u32                   dynamic_bindings_count;
+
+    /* resource ids written by gpu_write_bindings, U32_MAX = never written */
+    u32                   binding_resources [GPU_DESCRIPTOR_SET_COUNT * GPU_MAX_BINDINGS_PER_DESCRIPTOR];
+
     VkPipelineLayout      pipeline_layout;
     VkPipeline*           pipelines;
     u32                   pipelines_count;
 } VulkanShaders;
 
+/* transitions collected for one command, recorded with a single vkCmdPipelineBarrier2 */
+/* holds at most one barrier per resource */
 typedef struct {
-    VkCommandBuffer command_buffer_render;
-    VkFence         fence_frame;
-    VkSemaphore     semaphore_image_available;
+    VkImageMemoryBarrier2  image_barriers [GPU_MAX_IMAGES ];
+    VkBufferMemoryBarrier2 buffer_barriers[GPU_MAX_BUFFERS];
+    u32                    image_barriers_count;
+    u32                    buffer_barriers_count;
+} GpuBarrierBatch;
+
+/* drawing pass, barriers and attachments are generated on declaration */
+typedef struct {
+    GpuBarrierBatch           barriers;
+
+    VkRenderingAttachmentInfo color_attachments[GPU_MAX_COLOR_ATTACHMENTS];
+    VkRenderingAttachmentInfo depth_attachment;
+    VkFormat                  color_formats[GPU_MAX_COLOR_ATTACHMENTS];
+    VkFormat                  depth_format;
+    u32                       color_attachments_count;
+    VkViewport                viewport;
+    VkRect2D                  render_area;
+
+    /* secondary command buffer, NULL if nothing was recorded */
+    VkCommandBuffer           command_buffer;
+    /* between pass_begin and pass_end */
+    b32                       recording;
+    /* contents are incomplete, end_passes skips them and fails */
+    b32                       failed;
+} GpuPass;
+
+/* owned by one recording thread, reset every frame_begin */
+typedef struct {
+    VkCommandPool   command_pool;
+    VkCommandBuffer command_buffers[GPU_MAX_PARALLEL_PASSES];
+    u32             command_buffers_used;
+} GpuThreadCommands;
+
+/* cpu recording against gpu execution, summed until checked */
+typedef struct {
+    i64 counter_frequency;
+    i64 record_begin;
+    f64 record_time;
+    f64 gpu_time;
+    u32 frames;
+    /* previous frame was still executing when recording began and when the frame was submitted */
+    u32 busy_begin_frames;
+    u32 busy_submit_frames;
+} GpuOverlapStats;
+
+/* frame section recorded once and replayed from the frame command buffer */
+typedef struct {
+    /* secondary, allocated with the bake */
+    VkCommandBuffer command_buffer;
+    b32             is_valid;
+    /* resource states the bake was recorded against and leaves behind */
+    GpuImageState   image_states_begin [GPU_MAX_IMAGES ];
+    GpuBufferState  buffer_states_begin[GPU_MAX_BUFFERS];
+    GpuImageState   image_states_end   [GPU_MAX_IMAGES ];
+    GpuBufferState  buffer_states_end  [GPU_MAX_BUFFERS];
+} GpuBake;
+
+/* with async compute the render stream is split into three submissions: */
+/* render (before compute) -> overlap (runs alongside compute) -> join (after compute) */
+typedef struct {
+    VkCommandBuffer   command_buffer_render;
+    VkCommandBuffer   command_buffer_render_overlap;
+    VkCommandBuffer   command_buffer_render_join;
+    VkCommandBuffer   command_buffer_compute;
+    VkSemaphore       semaphore_image_available;
+    /* secondary command buffers of parallel passes */
+    GpuThreadCommands thread_commands[GPU_MAX_RECORD_THREADS];
+    /* frame timeline value signaled once the frame retires */
+    u64               frame_value;
+    /* frame region inside buffer_upload_ring */
+    u64               upload_offset;
+    /* top and bottom timestamps were written, read once the frame retired */
+    b32               timestamps_written;
+} GpuFrame;
+
+typedef struct {
+    GpuFrame        frames[GPU_MAX_FRAMES_IN_FLIGHT];
+    u32             frames_count;
+    u32             frame_id;
     VkSemaphore     semaphores_images_finished[GPU_MAX_SWAPCHAIN_IMAGES];
 
+    /* binary semaphores are left only for the swapchain */
+    /* frame timeline, value n is reached when the n-th frame retired */
+    VkSemaphore     semaphore_frame_timeline;
+    u64             frame_counter;
+    /* last frame value on the render queue, async uploads wait for it */
+    u64             frame_submitted;
+    /* async compute timeline, render part signals odd values, compute queue even */
+    VkSemaphore     semaphore_compute_timeline;
+    u64             compute_counter;
+
+    /* command buffer being recorded, render stream or async compute */
+    VkCommandBuffer command_buffer;
+
     u32             swapchain_image_id;
     VkImage         swapchain_image;
     VkImageView     swapchain_image_view;
 
-    GpuImageState   image_states [GPU_MAX_STATIC_IMAGES ];
-    GpuBufferState  buffer_states[GPU_MAX_STATIC_BUFFERS];
+    /* only one frame is recorded at a time, states are reset every frame_begin */
+    GpuImageState   image_states [GPU_MAX_IMAGES ];
+    GpuBufferState  buffer_states[GPU_MAX_BUFFERS];
+
+    /* images with contents surviving frames, frame_begin keeps their layout */
+    /* other images start every frame undefined but keep the stages to wait on */
+    b32             images_persistent[GPU_MAX_IMAGES];
+
+    /* resources handed over to the compute queue this frame */
+    b32             async_compute_recording;
+    b32             async_compute_submitted;
+    b32             async_compute_joined;
+    u32             async_images [GPU_MAX_IMAGES ];
+    u32             async_buffers[GPU_MAX_BUFFERS];
+    u32             async_images_count;
+    u32             async_buffers_count;
+
+    /* parallel drawing passes declared between begin_passes/end_passes */
+    b32             passes_recording;
+    GpuPass         passes[GPU_MAX_PARALLEL_PASSES];
+    u32             passes_count;
+
+    /* baked frames, bakes[swapchain_image_id + frame_id * GPU_MAX_SWAPCHAIN_IMAGES], NULL until first bake_begin */
+    GpuBake*        bakes[GPU_MAX_SWAPCHAIN_IMAGES * GPU_MAX_FRAMES_IN_FLIGHT];
+    GpuBake*        bake;
+    b32             bake_recording;
+
+    /* barriers of the frame being recorded and of the last ended one */
+    BarrierStats    barrier_stats;
+    BarrierStats    barrier_stats_last;
+
+    /* offsets of dynamic uniform buffers, late latch buffers point to the frame slot */
+    u32             dynamic_offsets[GPU_MAX_DYNAMIC_BINDINGS];
+    /* bytes handed out from frame uniforms slots by buffer slot, can go past capacity on failed allocations */
+    volatile i64    uniforms_allocated[GPU_MAX_BUFFERS];
+    /* called right before the frame is submitted */
+    GpuLatchFunc    latch_func;
+    void*           latch_user_data;
+    b32             latching;
+
+    /* bytes used in current frame upload region */
+    u64             upload_size;
+    u64             upload_flushed_size;
+    GpuUploadCopy   upload_copies[GPU_MAX_UPLOAD_COPIES];
+    u32             upload_copies_count;
 
-    u64             sync_transfer_size;
+    /* mapped writes of the frame, flushed in one call before submit */
+    GpuDirtyRange   dirty_ranges[GPU_MAX_DIRTY_RANGES];
+    u32             dirty_ranges_count;
+
+    /* two timestamps per frame slot, NULL when the adapter has none */
+    VkQueryPool     query_pool_timestamps;
+    /* milliseconds between top and bottom of the last retired frame */
+    f32             gpu_frame_time;
+    /* frame_overlap_check only */
+    GpuOverlapStats overlap_stats;
 } VulkanRender;
 
+/* transfer queue when there is one, render queue otherwise */
+typedef struct {
+    VkQueue         queue;
+    VkCommandPool   command_pool;
+    u32             src_queue_id;
+    u32             dst_queue_id;
+    VkSemaphore     semaphore_timeline;
+    /* last token signaled by a submit and last token acquired by the render queue */
+    u64             token_submitted;
+    u64             token_acquired;
+    /* byte positions in buffer_stream_ring, only growing */
+    u64             stream_head;
+    u64             stream_tail;
+    GpuUploadBatch  batches[GPU_MAX_UPLOAD_BATCHES];
+    u32             batches_first;
+    u32             batches_count;
+    /* recorded batches at the back not submitted yet, their tokens follow token_submitted */
+    u32             batches_deferred;
+} VulkanUpload;
+
+/* readbacks in ticket order */
 typedef struct {
-    void*           resources_base;
-    void*           resources_limit;
+    GpuReadback     readbacks[GPU_MAX_READBACKS];
+    u32             readbacks_first;
+    u32             readbacks_count;
+    /* byte positions in buffer_readback_ring, only growing */
+    u64             ring_head;
+    u64             ring_tail;
+    u64             ticket_counter;
+} VulkanReadback;
 
+typedef struct {
+    /* context lives at the start of the permanent arena */
+    Arena           arena_permanent;
+    Arena           arena_shaders;
+    Arena           arena_bakes;
+
+    VulkanHost      vulkan_host;
     VulkanObjects   vulkan_objects;
     VulkanDevice    vulkan_device;
     VulkanResources vulkan_resources;
     VulkanShaders   vulkan_shaders;
     VulkanRender    vulkan_render;
+    VulkanUpload    vulkan_upload;
+    VulkanReadback  vulkan_readback;
 } GpuContext;
 
 
 i32 create_swapchain(
-    VkDevice            device,
-    VkPhysicalDevice    physical_device,
-    VkSurfaceKHR        surface,
-    VkFormat            surface_format,
-    VkColorSpaceKHR     surface_color_space,
-    VkSwapchainKHR*     swapchain,
-    u32*                swapchain_images_count,
-    u32*                swapchain_x,
-    u32*                swapchain_y,
-    VkImage*            swapchain_images,
-    VkImageView*        swapchain_image_views
+    VkDevice                     device,
+    const VkAllocationCallbacks* allocator,
+    VkPhysicalDevice             physical_device,
+    VkSurfaceKHR                 surface,
+    VkFormat                     surface_format,
+    VkColorSpaceKHR              surface_color_space,
+    VkSwapchainKHR*              swapchain,
+    u32*                         swapchain_images_count,
+    u32*                         swapchain_x,
+    u32*                         swapchain_y,
+    VkImage*                     swapchain_images,
+    VkImageView*                 swapchain_image_views
+);
+
+/* resource handles, see gpu_resources.c */
+/* slot of a live handle, U32_MAX = invalid or destroyed */
+u32 resources_buffer_slot(
+    const VulkanResources* vulkan_resources,
+    u32                    buffer_id
+);
+
+u32 resources_image_slot(
+    const VulkanResources* vulkan_resources,
+    u32                    image_id
+);
+
+/* destroys retired resources whose frames completed */
+void resources_retire(
+    VulkanDevice*    vulkan_device,
+    VulkanResources* vulkan_resources,
+    u64              frame_completed
+);
+
+/* surface relative images, see gpu_resources.c */
+/* recreates them at the current swapchain size, handles stay valid, device has to be idle */
+b32 resize_surface_images(
+    GpuContext* gpu_ctx
+);
+
+/* bindings, see gpu_shaders.c */
+/* writes every binding again, views of recreated images are picked up */
+b32 shaders_rewrite_bindings(
+    GpuContext* gpu_ctx
+);
+
+/* host allocations, see gpu_memory.c */
+/* callbacks point at vulkan_host, reserves GPU_HOST_SCOPE_SIZE per scope */
+b32 host_allocator_init(
+    VulkanHost* vulkan_host
+);
+
+/* warns about allocations the driver did not free, then releases the scopes */
+void host_allocator_release(
+    VulkanHost* vulkan_host
+);
+
+/* video memory blocks, see gpu_memory.c */
+/* budget and usage of a heap, without VK_EXT_memory_budget usage counts only our blocks */
+void video_memory_heap_budget(
+    const VulkanDevice* vulkan_device,
+    u32                 heap_id,
+    u64*                budget,
+    u64*                usage
+);
+
+/* U32_MAX = out of budget or blocks */
+u32 video_memory_add_block(
+    VulkanDevice*             vulkan_device,
+    GpuVideoMemoryAllocation* allocation,
+    u64                       size
+);
+
+/* first block with room, grows by a block when none has, U32_MAX = fail */
+u32 video_memory_allocate(
+    VulkanDevice*               vulkan_device,
+    GpuVideoMemoryAllocation*   allocation,
+    u64                         size,
+    u64                         alignment,
+    u64*                        offset,
+    const GpuVideoMemoryBlock** block
+);
+
+/* blocks after the first one are freed once empty, U32_MAX is ignored */
+void video_memory_free(
+    VulkanDevice*             vulkan_device,
+    GpuVideoMemoryAllocation* allocation,
+    u32                       allocation_id
+);
+
+void video_memory_release(
+    const VulkanDevice*       vulkan_device,
+    GpuVideoMemoryAllocation* allocation
+);
+
+/* pool block size behind an allocation, includes what the pool rounded up */
+u64 video_memory_allocation_size(
+    const GpuVideoMemoryAllocation* allocation,
+    u32                             allocation_id
+);
+
+/* reports pressure to the callback */
+void video_memory_poll_budget(
+    GpuContext* gpu_ctx
+);
+
+/* memory pools, see gpu_memory.c */
+void memory_pool_init(
+    GpuMemoryPool* pool,
+    VkDeviceMemory memory,
+    u64            size
+);
+
+u32 memory_pool_allocate(
+    GpuMemoryPool* pool,
+    u64            size,
+    u64            alignment,
+    u64*           offset
+);
+
+void memory_pool_free(
+    GpuMemoryPool* pool,
+    u32            block_id
+);
+
+/* 0 = no free memory */
+u64 memory_pool_largest_free(
+    const GpuMemoryPool* pool
+);
+
+/* barrier batches, see gpu_render.c */
+void barrier_batch_reset(
+    GpuBarrierBatch* batch
+);
+
+void barrier_batch_add_image(
+    GpuBarrierBatch*             batch,
+    BarrierStats*                stats,
+    const VkImageMemoryBarrier2* barrier
+);
+
+void barrier_batch_add_buffer(
+    GpuBarrierBatch*              batch,
+    BarrierStats*                 stats,
+    const VkBufferMemoryBarrier2* barrier
+);
+
+void record_barrier_batch(
+    const VulkanDevice*    vulkan_device,
+    VkCommandBuffer        command_buffer,
+    BarrierStats*          stats,
+    const GpuBarrierBatch* batch
+);
+
+/* transitions from the tracked state and updates it */
+void barrier_batch_transit_image(
+    GpuBarrierBatch*      batch,
+    BarrierStats*         stats,
+    const GpuImage*       image,
+    GpuImageState*        state,
+    VkAccessFlags2        dst_access,
+    VkImageLayout         dst_layout,
+    VkPipelineStageFlags2 dst_stage
+);
+
+void barrier_batch_transit_buffer(
+    GpuBarrierBatch*      batch,
+    BarrierStats*         stats,
+    const GpuBuffer*      buffer,
+    GpuBufferState*       state,
+    VkAccessFlags2        dst_access,
+    VkPipelineStageFlags2 dst_stage
+);
+
+/* records batched upload ring copies, has to happen before anything reads their buffers */
+void flush_upload_copies(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanRender*          vulkan_render
+);
+
+/* background uploads, see gpu_upload.c */
+/* bytes per texel of tightly packed image data, 0 = not uploadable */
+u32 format_texel_size(
+    VkFormat format
+);
+
+b32 upload_init(
+    const VulkanDevice* vulkan_device,
+    VulkanUpload*       vulkan_upload
+);
+
+void upload_terminate(
+    const VulkanDevice* vulkan_device,
+    VulkanUpload*       vulkan_upload
+);
+
+/* TRUE while an upload to the resource slot was not acquired yet */
+b32 upload_is_pending(
+    const VulkanUpload* vulkan_upload,
+    b32                 is_image,
+    u32                 resource_id
+);
+
+/* submits deferred batches in one go, they wait for frame_value at transfer, FALSE = fail */
+b32 upload_submit_deferred(
+    const VulkanDevice* vulkan_device,
+    const VulkanRender* vulkan_render,
+    VulkanUpload*       vulkan_upload,
+    u64                 frame_value
+);
+
+/* records acquire barriers for finished uploads into the render command buffer */
+void upload_acquire(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanUpload*          vulkan_upload,
+    VulkanRender*          vulkan_render
 );
 
 #endif
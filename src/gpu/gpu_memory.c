@@ -0,0 +1,1074 @@
+#include "gpu_internal.h"
+
+#include <stdarg.h>
+
+/* TLSF, two level segregated fit over one VkDeviceMemory */
+/* block headers live outside of device memory, physical neighbours are linked for coalescing */
+/* adjacent free blocks are always merged, so free neighbours of a used block never exist */
+
+u32 memory_bit_last(
+    u64 value
+) {
+    return 63 - (u32)__builtin_clzll(value);
+}
+
+u32 memory_bit_first(
+    u64 value
+) {
+    return (u32)__builtin_ctzll(value);
+}
+
+/* first level is log2 of size, second level splits it linearly */
+void memory_pool_mapping(
+    u64  size,
+    u32* fl,
+    u32* sl
+) {
+    if(size < GPU_MEMORY_SL_COUNT) {
+        *fl = 0;
+        *sl = (u32)size;
+        return;
+    }
+
+    const u32 size_log2 = memory_bit_last(size);
+    *fl = size_log2 - GPU_MEMORY_SL_LOG2 + 1;
+    *sl = (u32)(size >> (size_log2 - GPU_MEMORY_SL_LOG2)) - GPU_MEMORY_SL_COUNT;
+}
+
+void memory_pool_insert_free(
+    GpuMemoryPool* pool,
+    u32            block_id
+) {
+    GpuMemoryBlock* block = &pool->blocks[block_id];
+
+    u32 fl = 0;
+    u32 sl = 0;
+    memory_pool_mapping(block->size, &fl, &sl);
+
+    const u32 head_id = pool->free_heads[fl][sl];
+    if(head_id != U32_MAX) {
+        pool->blocks[head_id].prev_free = block_id;
+    }
+    block->prev_free         = U32_MAX;
+    block->next_free         = head_id;
+    block->is_free           = TRUE;
+    pool->free_heads[fl][sl] = block_id;
+
+    pool->fl_bitmap      |= 1ull << fl;
+    pool->sl_bitmaps[fl] |= 1u   << sl;
+}
+
+void memory_pool_remove_free(
+    GpuMemoryPool* pool,
+    u32            block_id
+) {
+    GpuMemoryBlock* block = &pool->blocks[block_id];
+
+    u32 fl = 0;
+    u32 sl = 0;
+    memory_pool_mapping(block->size, &fl, &sl);
+
+    if(block->prev_free != U32_MAX) {
+        pool->blocks[block->prev_free].next_free = block->next_free;
+    }
+    if(block->next_free != U32_MAX) {
+        pool->blocks[block->next_free].prev_free = block->prev_free;
+    }
+    if(pool->free_heads[fl][sl] == block_id) {
+        pool->free_heads[fl][sl] = block->next_free;
+
+        if(block->next_free == U32_MAX) {
+            pool->sl_bitmaps[fl] &= ~(1u << sl);
+            if(pool->sl_bitmaps[fl] == 0) {
+                pool->fl_bitmap &= ~(1ull << fl);
+            }
+        }
+    }
+    block->is_free = FALSE;
+}
+
+/* any block of the returned list fits size, U32_MAX = none */
+u32 memory_pool_find_free(
+    const GpuMemoryPool* pool,
+    u64                  size
+) {
+    /* round up to the next list so its first block is large enough */
+    u64 search_size = size;
+    if(size >= GPU_MEMORY_SL_COUNT) {
+        search_size += (1ull << (memory_bit_last(size) - GPU_MEMORY_SL_LOG2)) - 1;
+    }
+
+    u32 fl = 0;
+    u32 sl = 0;
+    memory_pool_mapping(search_size, &fl, &sl);
+
+    u32 sl_map = pool->sl_bitmaps[fl] & (~0u << sl);
+    if(sl_map == 0) {
+        const u64 fl_map = pool->fl_bitmap & (~0ull << (fl + 1));
+        if(fl_map == 0) {
+            return U32_MAX;
+        }
+        fl     = memory_bit_first(fl_map);
+        sl_map = pool->sl_bitmaps[fl];
+    }
+    sl = memory_bit_first(sl_map);
+
+    return pool->free_heads[fl][sl];
+}
+
+/* cuts block at size, returns the tail which is not in any free list, U32_MAX = out of headers */
+u32 memory_pool_split(
+    GpuMemoryPool* pool,
+    u32            block_id,
+    u64            size
+) {
+    if(pool->unused_blocks_count == 0) {
+        return U32_MAX;
+    }
+
+    const u32       tail_id = pool->unused_blocks[--pool->unused_blocks_count];
+    GpuMemoryBlock* block   = &pool->blocks[block_id];
+
+    pool->blocks[tail_id] = (GpuMemoryBlock) {
+        .offset        = block->offset + size,
+        .size          = block->size - size,
+        .prev_physical = block_id,
+        .next_physical = block->next_physical,
+        .prev_free     = U32_MAX,
+        .next_free     = U32_MAX,
+        .is_free       = FALSE
+    };
+    if(block->next_physical != U32_MAX) {
+        pool->blocks[block->next_physical].prev_physical = tail_id;
+    }
+    block->next_physical = tail_id;
+    block->size          = size;
+
+    return tail_id;
+}
+
+/* next_id is merged into block_id and its header released */
+void memory_pool_merge(
+    GpuMemoryPool* pool,
+    u32            block_id,
+    u32            next_id
+) {
+    GpuMemoryBlock*       block = &pool->blocks[block_id];
+    const GpuMemoryBlock* next  = &pool->blocks[next_id];
+
+    block->size         += next->size;
+    block->next_physical = next->next_physical;
+    if(next->next_physical != U32_MAX) {
+        pool->blocks[next->next_physical].prev_physical = block_id;
+    }
+    pool->unused_blocks[pool->unused_blocks_count++] = next_id;
+}
+
+/* memory is only carried along, host pools have none */
+void memory_pool_init(
+    GpuMemoryPool* pool,
+    VkDeviceMemory memory,
+    u64            size
+) {
+    pool->memory              = memory;
+    pool->size                = size;
+    pool->used                = 0;
+    pool->fl_bitmap           = 0;
+    pool->unused_blocks_count = 0;
+
+    memset(pool->sl_bitmaps, 0, sizeof(pool->sl_bitmaps));
+    for(u32 i = 0; i != GPU_MEMORY_FL_COUNT; i++) {
+        for(u32 j = 0; j != GPU_MEMORY_SL_COUNT; j++) {
+            pool->free_heads[i][j] = U32_MAX;
+        }
+    }
+    for(u32 i = GPU_MEMORY_MAX_BLOCKS; i != 0; i--) {
+        pool->unused_blocks[pool->unused_blocks_count++] = i - 1;
+    }
+
+    if(size == 0) {
+        return;
+    }
+
+    /* whole memory is one free block */
+    const u32 block_id = pool->unused_blocks[--pool->unused_blocks_count];
+    pool->blocks[block_id] = (GpuMemoryBlock) {
+        .offset        = 0,
+        .size          = size,
+        .prev_physical = U32_MAX,
+        .next_physical = U32_MAX,
+        .prev_free     = U32_MAX,
+        .next_free     = U32_MAX
+    };
+    memory_pool_insert_free(pool, block_id);
+}
+
+/* returns block id to free with, U32_MAX = out of memory */
+u32 memory_pool_allocate(
+    GpuMemoryPool* pool,
+    u64            size,
+    u64            alignment,
+    u64*           offset
+) {
+    if(size == 0) {
+        goto fail;
+    }
+
+    /* worst case padding, alignment is a power of two */
+    const u64 search_size = size + (alignment > 1 ? alignment - 1 : 0);
+    u32       block_id    = memory_pool_find_free(pool, search_size);
+    if(block_id == U32_MAX) {
+        goto fail;
+    }
+    memory_pool_remove_free(pool, block_id);
+
+    /* padding goes back as a free block, its physical predecessor is used */
+    const u64 block_offset   = pool->blocks[block_id].offset;
+    const u64 aligned_offset = ALIGN(block_offset, alignment);
+    if(aligned_offset != block_offset) {
+        const u32 aligned_id = memory_pool_split(pool, block_id, aligned_offset - block_offset);
+        if(aligned_id == U32_MAX) {
+            memory_pool_insert_free(pool, block_id);
+            goto fail;
+        }
+        memory_pool_insert_free(pool, block_id);
+        block_id = aligned_id;
+    }
+
+    /* remainder goes back, without a spare header the block is used whole */
+    if(pool->blocks[block_id].size > size) {
+        const u32 tail_id = memory_pool_split(pool, block_id, size);
+        if(tail_id != U32_MAX) {
+            memory_pool_insert_free(pool, tail_id);
+        }
+    }
+
+    pool->used += pool->blocks[block_id].size;
+    *offset     = aligned_offset;
+
+    return block_id;
+
+    fail: {
+        return U32_MAX;
+    }
+}
+
+/* U32_MAX is ignored */
+void memory_pool_free(
+    GpuMemoryPool* pool,
+    u32            block_id
+) {
+    if(block_id == U32_MAX) {
+        return;
+    }
+
+    pool->used -= pool->blocks[block_id].size;
+
+    const u32 prev_id = pool->blocks[block_id].prev_physical;
+    if(prev_id != U32_MAX && pool->blocks[prev_id].is_free) {
+        memory_pool_remove_free(pool, prev_id);
+        memory_pool_merge(pool, prev_id, block_id);
+        block_id = prev_id;
+    }
+
+    const u32 next_id = pool->blocks[block_id].next_physical;
+    if(next_id != U32_MAX && pool->blocks[next_id].is_free) {
+        memory_pool_remove_free(pool, next_id);
+        memory_pool_merge(pool, block_id, next_id);
+    }
+
+    memory_pool_insert_free(pool, block_id);
+}
+
+u64 memory_pool_largest_free(
+    const GpuMemoryPool* pool
+) {
+    if(pool->fl_bitmap == 0) {
+        return 0;
+    }
+
+    /* largest block is somewhere in the highest first level */
+    const u32 fl      = memory_bit_last(pool->fl_bitmap);
+    u64       largest = 0;
+    for(u32 sl = 0; sl != GPU_MEMORY_SL_COUNT; sl++) {
+        for(u32 block_id = pool->free_heads[fl][sl]; block_id != U32_MAX; block_id = pool->blocks[block_id].next_free) {
+            largest = MAX(largest, pool->blocks[block_id].size);
+        }
+    }
+    return largest;
+}
+
+/* HOST ALLOCATIONS */
+/* driver host memory, a tlsf pool per allocation scope placed over the scope arena */
+/* pages are committed as the pool reaches them and stay committed */
+
+void* host_scope_allocate(
+    GpuHostScope* scope,
+    u32           scope_id,
+    u64           size,
+    u64           alignment
+) {
+    alignment = MAX(alignment, GPU_HOST_MIN_ALIGNMENT);
+
+    const u64 header_size = ALIGN(sizeof(GpuHostHeader), alignment);
+    u8*       base        = NULL;
+    u64       pool_offset = 0;
+
+    AcquireSRWLockExclusive(&scope->lock);
+
+    u32 block_id = memory_pool_allocate(&scope->pool, header_size + size, alignment, &pool_offset);
+    if(block_id != U32_MAX && !arena_commit(&scope->arena, pool_offset + header_size + size)) {
+        memory_pool_free(&scope->pool, block_id);
+        block_id = U32_MAX;
+    }
+
+    /* pool is out of headers or range */
+    if(block_id != U32_MAX) {
+        base = scope->arena.base + pool_offset;
+    }
+    else {
+        base = HeapAlloc(GetProcessHeap(), 0, sizeof(GpuHostHeader) + alignment + size);
+        if(base == NULL) {
+            ReleaseSRWLockExclusive(&scope->lock);
+            return NULL;
+        }
+        scope->heap_fallbacks++;
+    }
+
+    u8* pointer = (u8*)ALIGN((u64)base + sizeof(GpuHostHeader), alignment);
+    ((GpuHostHeader*)pointer)[-1] = (GpuHostHeader) {
+        .block_id = block_id,
+        .scope    = scope_id,
+        .offset   = pointer - base,
+        .size     = size
+    };
+
+    scope->used += size;
+    scope->peak  = MAX(scope->peak, scope->used);
+    scope->allocations_count++;
+    scope->allocations_total++;
+
+    ReleaseSRWLockExclusive(&scope->lock);
+
+    return pointer;
+}
+
+void host_scope_free(
+    VulkanHost* vulkan_host,
+    void*       memory
+) {
+    const GpuHostHeader header = ((const GpuHostHeader*)memory)[-1];
+    GpuHostScope*       scope  = &vulkan_host->scopes[header.scope];
+
+    AcquireSRWLockExclusive(&scope->lock);
+
+    if(header.block_id != U32_MAX) {
+        memory_pool_free(&scope->pool, header.block_id);
+    }
+    else {
+        HeapFree(GetProcessHeap(), 0, (u8*)memory - header.offset);
+    }
+    scope->used -= header.size;
+    scope->allocations_count--;
+
+    ReleaseSRWLockExclusive(&scope->lock);
+}
+
+u32 host_scope_id(
+    VkSystemAllocationScope allocation_scope
+) {
+    return ((u32)allocation_scope < GPU_HOST_SCOPE_COUNT) ? (u32)allocation_scope : GPU_HOST_SCOPE_OBJECT;
+}
+
+VKAPI_ATTR void* VKAPI_CALL host_allocation(
+    void*                   user_data,
+    size_t                  size,
+    size_t                  alignment,
+    VkSystemAllocationScope allocation_scope
+) {
+    VulkanHost* vulkan_host = (VulkanHost*)user_data;
+    const u32   scope_id    = host_scope_id(allocation_scope);
+
+    if(size == 0) {
+        return NULL;
+    }
+    return host_scope_allocate(&vulkan_host->scopes[scope_id], scope_id, size, alignment);
+}
+
+/* old memory stays valid when the new allocation fails */
+VKAPI_ATTR void* VKAPI_CALL host_reallocation(
+    void*                   user_data,
+    void*                   original,
+    size_t                  size,
+    size_t                  alignment,
+    VkSystemAllocationScope allocation_scope
+) {
+    VulkanHost* vulkan_host = (VulkanHost*)user_data;
+    const u32   scope_id    = host_scope_id(allocation_scope);
+
+    if(original == NULL) {
+        return host_allocation(user_data, size, alignment, allocation_scope);
+    }
+    if(size == 0) {
+        host_scope_free(vulkan_host, original);
+        return NULL;
+    }
+
+    void* memory = host_scope_allocate(&vulkan_host->scopes[scope_id], scope_id, size, alignment);
+    if(memory == NULL) {
+        return NULL;
+    }
+
+    const u64 original_size = ((const GpuHostHeader*)original)[-1].size;
+    memcpy(memory, original, MIN(original_size, (u64)size));
+    host_scope_free(vulkan_host, original);
+
+    return memory;
+}
+
+VKAPI_ATTR void VKAPI_CALL host_free(
+    void* user_data,
+    void* memory
+) {
+    if(memory == NULL) {
+        return;
+    }
+    host_scope_free((VulkanHost*)user_data, memory);
+}
+
+VKAPI_ATTR void VKAPI_CALL host_internal_allocation(
+    void*                    user_data,
+    size_t                   size,
+    VkInternalAllocationType allocation_type,
+    VkSystemAllocationScope  allocation_scope
+) {
+    GpuHostScope* scope = &((VulkanHost*)user_data)->scopes[host_scope_id(allocation_scope)];
+
+    AcquireSRWLockExclusive(&scope->lock);
+    scope->internal += size;
+    ReleaseSRWLockExclusive(&scope->lock);
+}
+
+VKAPI_ATTR void VKAPI_CALL host_internal_free(
+    void*                    user_data,
+    size_t                   size,
+    VkInternalAllocationType allocation_type,
+    VkSystemAllocationScope  allocation_scope
+) {
+    GpuHostScope* scope = &((VulkanHost*)user_data)->scopes[host_scope_id(allocation_scope)];
+
+    AcquireSRWLockExclusive(&scope->lock);
+    scope->internal -= size;
+    ReleaseSRWLockExclusive(&scope->lock);
+}
+
+b32 host_allocator_init(
+    VulkanHost* vulkan_host
+) {
+    for(u32 i = 0; i != GPU_HOST_SCOPE_COUNT; i++) {
+        GpuHostScope* scope = &vulkan_host->scopes[i];
+
+        *scope = (GpuHostScope){0};
+        if(!arena_create(&scope->arena, ARENA_LIFETIME_PERMANENT, GPU_HOST_SCOPE_SIZE)) {
+            LOG_ERROR("failed to create host scope arena: %u", i);
+            goto fail;
+        }
+        InitializeSRWLock(&scope->lock);
+        memory_pool_init(&scope->pool, NULL, scope->arena.reserve_size);
+    }
+
+    vulkan_host->callbacks = (VkAllocationCallbacks) {
+        .pUserData             = vulkan_host,
+        .pfnAllocation         = host_allocation,
+        .pfnReallocation       = host_reallocation,
+        .pfnFree               = host_free,
+        .pfnInternalAllocation = host_internal_allocation,
+        .pfnInternalFree       = host_internal_free
+    };
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* everything is destroyed by now, what is left leaked */
+void host_allocator_release(
+    VulkanHost* vulkan_host
+) {
+    for(u32 i = 0; i != GPU_HOST_SCOPE_COUNT; i++) {
+        GpuHostScope* scope = &vulkan_host->scopes[i];
+        if(scope->allocations_count != 0) {
+            LOG_WARNING("host allocations left scope: %u count: %u size: %llu", i, scope->allocations_count, scope->used);
+        }
+        arena_destroy(&scope->arena);
+    }
+}
+
+/* VIDEO MEMORY BLOCKS */
+
+void video_memory_heap_budget(
+    const VulkanDevice* vulkan_device,
+    u32                 heap_id,
+    u64*                budget,
+    u64*                usage
+) {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT
+    };
+    VkPhysicalDeviceMemoryProperties2         memory_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+        .pNext = vulkan_device->adapter->memory_budget ? &budget_properties : NULL
+    };
+    vkGetPhysicalDeviceMemoryProperties2(vulkan_device->adapter->physical_device, &memory_properties);
+
+    if(vulkan_device->adapter->memory_budget) {
+        *budget = budget_properties.heapBudget[heap_id];
+        *usage  = budget_properties.heapUsage[heap_id];
+        return;
+    }
+
+    /* without the extension assume most of the heap is ours and nobody else uses it */
+    const GpuVideoMemoryAllocation* allocations[] = {
+        &vulkan_device->video_memory_device_buffers,
+        &vulkan_device->video_memory_device_images,
+        &vulkan_device->video_memory_host_transfer,
+        &vulkan_device->video_memory_host_readback
+    };
+
+    *budget = memory_properties.memoryProperties.memoryHeaps[heap_id].size / 10 * 8;
+    *usage  = 0;
+    for(u32 i = 0; i != ARRAY_SIZE(allocations); i++) {
+        if(allocations[i]->heap_id != heap_id) {
+            continue;
+        }
+        for(u32 j = 0; j != allocations[i]->blocks_count; j++) {
+            *usage += allocations[i]->blocks[j].pool.size;
+        }
+    }
+}
+
+u32 video_memory_add_block(
+    VulkanDevice*             vulkan_device,
+    GpuVideoMemoryAllocation* allocation,
+    u64                       size
+) {
+    const VkDevice device = vulkan_device->device;
+
+    u32 block_id = U32_MAX;
+    for(u32 i = 0; i != GPU_MAX_VIDEO_MEMORY_BLOCKS; i++) {
+        if(allocation->blocks[i].device_memory == NULL) {
+            block_id = i;
+            break;
+        }
+    }
+    if(block_id == U32_MAX) {
+        LOG_WARNING("out of video memory blocks type: %u blocks: %u", allocation->type_id, GPU_MAX_VIDEO_MEMORY_BLOCKS);
+        goto fail;
+    }
+
+    /* driver would page to system memory past the budget instead of failing */
+    u64 heap_budget = 0;
+    u64 heap_usage  = 0;
+    video_memory_heap_budget(vulkan_device, allocation->heap_id, &heap_budget, &heap_usage);
+    if(heap_usage + size > heap_budget) {
+        LOG_WARNING("video memory heap over budget heap: %u size: %llu usage: %llu/%llu", allocation->heap_id, size, heap_usage, heap_budget);
+        goto fail;
+    }
+
+    const VkMemoryAllocateInfo alloc_info = {
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .memoryTypeIndex = allocation->type_id,
+        .allocationSize  = size
+    };
+
+    VkDeviceMemory device_memory = NULL;
+    void*          memory_map    = NULL;
+
+    if(vkAllocateMemory(device, &alloc_info, vulkan_device->allocator, &device_memory) != VK_SUCCESS) {
+        LOG_WARNING("failed to allocate video memory block type: %u size: %llu", allocation->type_id, size);
+        goto fail;
+    }
+    if(allocation->type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if(vkMapMemory(device, device_memory, 0, size, 0, &memory_map) != VK_SUCCESS) {
+            LOG_ERROR("failed to map video memory block type: %u size: %llu", allocation->type_id, size);
+            vkFreeMemory(device, device_memory, vulkan_device->allocator);
+            goto fail;
+        }
+    }
+
+    GpuVideoMemoryBlock* block = &allocation->blocks[block_id];
+    block->device_memory = device_memory;
+    block->memory_map    = memory_map;
+    memory_pool_init(&block->pool, device_memory, size);
+
+    allocation->blocks_count = MAX(allocation->blocks_count, block_id + 1);
+
+    return block_id;
+
+    fail: {
+        vulkan_device->memory_pressure_pending = TRUE;
+        return U32_MAX;
+    }
+}
+
+u32 video_memory_allocate(
+    VulkanDevice*               vulkan_device,
+    GpuVideoMemoryAllocation*   allocation,
+    u64                         size,
+    u64                         alignment,
+    u64*                        offset,
+    const GpuVideoMemoryBlock** block
+) {
+    for(u32 i = 0; i != allocation->blocks_count; i++) {
+        GpuVideoMemoryBlock* memory_block = &allocation->blocks[i];
+        if(memory_block->device_memory == NULL) {
+            continue;
+        }
+
+        const u32 pool_id = memory_pool_allocate(&memory_block->pool, size, alignment, offset);
+        if(pool_id != U32_MAX) {
+            allocation->used += memory_block->pool.blocks[pool_id].size;
+            allocation->peak  = MAX(allocation->peak, allocation->used);
+
+            *block = memory_block;
+            return (i << GPU_VIDEO_MEMORY_BLOCK_SHIFT) | pool_id;
+        }
+    }
+
+    /* grow, requests larger than a block get one of their own */
+    const u64 requested_size = ALIGN(size + alignment, 1024 * 1024);
+    const u64 block_size     = MAX(allocation->block_size, requested_size);
+    const u32 block_id       = video_memory_add_block(vulkan_device, allocation, block_size);
+    if(block_id == U32_MAX) {
+        goto fail;
+    }
+
+    GpuVideoMemoryBlock* memory_block = &allocation->blocks[block_id];
+    const u32            pool_id      = memory_pool_allocate(&memory_block->pool, size, alignment, offset);
+    if(pool_id == U32_MAX) {
+        goto fail;
+    }
+    allocation->used += memory_block->pool.blocks[pool_id].size;
+    allocation->peak  = MAX(allocation->peak, allocation->used);
+
+    *block = memory_block;
+
+    LOG_MESSAGE("video memory grown type: %u block: %u size: %llu", allocation->type_id, block_id, block_size);
+
+    return (block_id << GPU_VIDEO_MEMORY_BLOCK_SHIFT) | pool_id;
+
+    fail: {
+        LOG_ERROR(
+            "failed to allocate video memory type: %u size: %llu used: %llu peak: %llu blocks: %u",
+            allocation->type_id, size, allocation->used, allocation->peak, allocation->blocks_count
+        );
+        return U32_MAX;
+    }
+}
+
+void video_memory_free(
+    VulkanDevice*             vulkan_device,
+    GpuVideoMemoryAllocation* allocation,
+    u32                       allocation_id
+) {
+    if(allocation_id == U32_MAX) {
+        return;
+    }
+
+    const u32            block_id = allocation_id >> GPU_VIDEO_MEMORY_BLOCK_SHIFT;
+    const u32            pool_id  = allocation_id & ((1u << GPU_VIDEO_MEMORY_BLOCK_SHIFT) - 1);
+    GpuVideoMemoryBlock* block    = &allocation->blocks[block_id];
+
+    allocation->used -= block->pool.blocks[pool_id].size;
+    memory_pool_free(&block->pool, pool_id);
+
+    /* resources are retired before freeing, so an empty block is unused by the gpu too */
+    if(block_id == 0 || block->pool.used != 0) {
+        return;
+    }
+
+    if(block->memory_map != NULL) {
+        vkUnmapMemory(vulkan_device->device, block->device_memory);
+    }
+    vkFreeMemory(vulkan_device->device, block->device_memory, vulkan_device->allocator);
+    block->device_memory = NULL;
+    block->memory_map    = NULL;
+    block->pool.memory   = NULL;
+    block->pool.size     = 0;
+
+    while(allocation->blocks_count != 0 && allocation->blocks[allocation->blocks_count - 1].device_memory == NULL) {
+        allocation->blocks_count--;
+    }
+}
+
+u64 video_memory_allocation_size(
+    const GpuVideoMemoryAllocation* allocation,
+    u32                             allocation_id
+) {
+    if(allocation_id == U32_MAX) {
+        return 0;
+    }
+
+    const u32 block_id = allocation_id >> GPU_VIDEO_MEMORY_BLOCK_SHIFT;
+    const u32 pool_id  = allocation_id & ((1u << GPU_VIDEO_MEMORY_BLOCK_SHIFT) - 1);
+    return allocation->blocks[block_id].pool.blocks[pool_id].size;
+}
+
+void video_memory_release(
+    const VulkanDevice*       vulkan_device,
+    GpuVideoMemoryAllocation* allocation
+) {
+    const VkDevice device = vulkan_device->device;
+
+    for(u32 i = 0; i != allocation->blocks_count; i++) {
+        GpuVideoMemoryBlock* block = &allocation->blocks[i];
+        if(block->device_memory == NULL) {
+            continue;
+        }
+
+        if(block->memory_map != NULL) {
+            vkUnmapMemory(device, block->device_memory);
+        }
+        vkFreeMemory(device, block->device_memory, vulkan_device->allocator);
+        block->device_memory = NULL;
+        block->memory_map    = NULL;
+    }
+    allocation->blocks_count = 0;
+}
+
+void video_memory_poll_budget(
+    GpuContext* gpu_ctx
+) {
+    VulkanDevice* vulkan_device = &gpu_ctx->vulkan_device;
+
+    GpuMemoryBudget budget = (GpuMemoryBudget){0};
+    gpu_query_memory_budget((CtxHandle)gpu_ctx, &budget);
+
+    const b32 pressure =
+        budget.device_usage * 100 > budget.device_budget * GPU_MEMORY_PRESSURE_PERCENT ||
+        budget.host_usage   * 100 > budget.host_budget   * GPU_MEMORY_PRESSURE_PERCENT;
+
+    /* reported once on entering pressure and after every failed growth */
+    const b32 report = (pressure && !vulkan_device->memory_pressure) || vulkan_device->memory_pressure_pending;
+
+    vulkan_device->memory_pressure         = pressure;
+    vulkan_device->memory_pressure_pending = FALSE;
+
+    if(!report) {
+        return;
+    }
+
+    LOG_WARNING(
+        "video memory pressure device: %llu/%llu host: %llu/%llu",
+        budget.device_usage, budget.device_budget,
+        budget.host_usage,   budget.host_budget
+    );
+    if(vulkan_device->memory_pressure_func != NULL) {
+        vulkan_device->memory_pressure_func((CtxHandle)gpu_ctx, &budget, vulkan_device->memory_pressure_user_data);
+    }
+}
+
+/* */
+
+void gpu_query_memory_budget(
+    CtxHandle        ctx,
+    GpuMemoryBudget* budget
+) {
+    const GpuContext*   gpu_ctx       = (GpuContext*)ctx;
+    const VulkanDevice* vulkan_device = &gpu_ctx->vulkan_device;
+
+    /* images dominate device memory, buffers usually share their heap */
+    video_memory_heap_budget(
+        vulkan_device,
+        vulkan_device->video_memory_device_images.heap_id,
+        &budget->device_budget,
+        &budget->device_usage
+    );
+    video_memory_heap_budget(
+        vulkan_device,
+        vulkan_device->video_memory_host_transfer.heap_id,
+        &budget->host_budget,
+        &budget->host_usage
+    );
+}
+
+void gpu_set_memory_pressure_callback(
+    CtxHandle             ctx,
+    GpuMemoryPressureFunc func,
+    void*                 user_data
+) {
+    GpuContext* gpu_ctx = (GpuContext*)ctx;
+
+    gpu_ctx->vulkan_device.memory_pressure_func      = func;
+    gpu_ctx->vulkan_device.memory_pressure_user_data = user_data;
+}
+
+/* STATS */
+
+void memory_section_stats(
+    const GpuVideoMemoryAllocation* allocation,
+    GpuMemorySectionStats*          stats
+) {
+    *stats = (GpuMemorySectionStats) {
+        .used = allocation->used,
+        .peak = allocation->peak
+    };
+
+    for(u32 i = 0; i != allocation->blocks_count; i++) {
+        const GpuVideoMemoryBlock* block = &allocation->blocks[i];
+        if(block->device_memory == NULL) {
+            continue;
+        }
+
+        const u64 largest_free = memory_pool_largest_free(&block->pool);
+
+        stats->blocks_count++;
+        stats->reserved    += block->pool.size;
+        stats->largest_free = MAX(stats->largest_free, largest_free);
+    }
+
+    const u64 free_size = stats->reserved - stats->used;
+    stats->fragmentation = (free_size != 0) ? 1.0f - (f32)stats->largest_free / (f32)free_size : 0.0f;
+}
+
+/* keeps counting past buffer_size so the caller learns the required size */
+void memory_stats_write(
+    char*       buffer,
+    u64         buffer_size,
+    u64*        length,
+    const char* format,
+    ...
+) {
+    const u64 offset = *length;
+
+    va_list args;
+    va_start(args, format);
+    const i32 written = vsnprintf(
+        (offset < buffer_size) ? buffer + offset      : NULL,
+        (offset < buffer_size) ? buffer_size - offset : 0,
+        format,
+        args
+    );
+    va_end(args);
+
+    if(written > 0) {
+        *length += written;
+    }
+}
+
+void memory_stats_write_section(
+    char*                        buffer,
+    u64                          buffer_size,
+    u64*                         length,
+    const char*                  name,
+    const GpuMemorySectionStats* stats,
+    b32                          is_last
+) {
+    memory_stats_write(
+        buffer, buffer_size, length,
+        "    \"%s\": {\"blocks\": %u, \"allocations\": %u, \"reserved\": %llu, \"used\": %llu, \"peak\": %llu, "
+        "\"padding\": %llu, \"largest_free\": %llu, \"fragmentation\": %.3f}%s\n",
+        name, stats->blocks_count, stats->allocations_count, stats->reserved, stats->used, stats->peak,
+        stats->padding, stats->largest_free, (f64)stats->fragmentation, is_last ? "" : ","
+    );
+}
+
+/* */
+
+void gpu_query_memory_stats(
+    CtxHandle       ctx,
+    GpuMemoryStats* stats
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanHost*            vulkan_host      = &gpu_ctx->vulkan_host;
+
+    *stats = (GpuMemoryStats){0};
+
+    gpu_query_memory_budget(ctx, &stats->budget);
+    memory_section_stats(&vulkan_device->video_memory_device_buffers, &stats->device_buffers);
+    memory_section_stats(&vulkan_device->video_memory_device_images,  &stats->device_images );
+    memory_section_stats(&vulkan_device->video_memory_host_transfer,  &stats->host_transfer );
+    memory_section_stats(&vulkan_device->video_memory_host_readback,  &stats->host_readback );
+
+    /* buffers, late latch ones hold a slot per frame in host memory */
+    for(u32 i = 0; i != vulkan_resources->buffers_count; i++) {
+        const GpuBuffer* buffer = &vulkan_resources->buffers[i];
+        if(buffer->buffer == NULL) {
+            continue;
+        }
+
+        const b32                       is_late_latch = buffer->frame_stride != 0;
+        const GpuVideoMemoryAllocation* allocation    = is_late_latch ?
+            &vulkan_device->video_memory_host_transfer :
+            &vulkan_device->video_memory_device_buffers;
+        GpuMemorySectionStats*          section       = is_late_latch ? &stats->host_transfer : &stats->device_buffers;
+        const u64                       data_size     = is_late_latch ? buffer->used_size * vulkan_device->frames_in_flight : buffer->used_size;
+
+        section->allocations_count++;
+        section->padding += video_memory_allocation_size(allocation, buffer->allocation_id) - data_size;
+    }
+
+    /* images, requirement size is all the driver tells us, transient images share one allocation */
+    for(u32 i = 0; i != vulkan_resources->images_count; i++) {
+        const GpuImage* image = &vulkan_resources->images[i];
+        if(image->image == NULL || image->allocation_id == U32_MAX) {
+            continue;
+        }
+
+        stats->device_images.allocations_count++;
+        stats->device_images.padding += video_memory_allocation_size(&vulkan_device->video_memory_device_images, image->allocation_id) - image->allocation_size;
+    }
+    if(vulkan_resources->static_images_count != 0 && vulkan_resources->transient_allocation_id != U32_MAX) {
+        stats->device_images.allocations_count++;
+    }
+
+    /* transfer rings */
+    const GpuBuffer* rings[] = {
+        &vulkan_resources->buffer_upload_ring,
+        &vulkan_resources->buffer_stream_ring
+    };
+    for(u32 i = 0; i != ARRAY_SIZE(rings); i++) {
+        if(rings[i]->buffer == NULL) {
+            continue;
+        }
+
+        stats->host_transfer.allocations_count++;
+        stats->host_transfer.padding += video_memory_allocation_size(&vulkan_device->video_memory_host_transfer, rings[i]->allocation_id) - rings[i]->used_size;
+    }
+    if(vulkan_resources->buffer_readback_ring.buffer != NULL) {
+        const GpuBuffer* ring = &vulkan_resources->buffer_readback_ring;
+
+        stats->host_readback.allocations_count++;
+        stats->host_readback.padding += video_memory_allocation_size(&vulkan_device->video_memory_host_readback, ring->allocation_id) - ring->used_size;
+    }
+
+    /* driver host memory, the driver could be allocating right now */
+    for(u32 i = 0; i != GPU_HOST_SCOPE_COUNT; i++) {
+        GpuHostScope* scope = &vulkan_host->scopes[i];
+
+        AcquireSRWLockExclusive(&scope->lock);
+        stats->host_scopes[i] = (GpuHostScopeStats) {
+            .allocations_count = scope->allocations_count,
+            .allocations_total = scope->allocations_total,
+            .heap_fallbacks    = scope->heap_fallbacks,
+            .committed         = scope->arena.commit_size,
+            .used              = scope->used,
+            .peak              = scope->peak,
+            .internal          = scope->internal
+        };
+        ReleaseSRWLockExclusive(&scope->lock);
+    }
+}
+
+u64 gpu_dump_memory_stats(
+    CtxHandle ctx,
+    char*     buffer,
+    u64       buffer_size
+) {
+    const GpuContext*      gpu_ctx          = (GpuContext*)ctx;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+
+    GpuMemoryStats stats = (GpuMemoryStats){0};
+    gpu_query_memory_stats(ctx, &stats);
+
+    u64 length = 0;
+
+    /* heaps and sections */
+    memory_stats_write(
+        buffer, buffer_size, &length,
+        "{\n  \"budget\": {\"device_budget\": %llu, \"device_usage\": %llu, \"host_budget\": %llu, \"host_usage\": %llu},\n"
+        "  \"sections\": {\n",
+        stats.budget.device_budget, stats.budget.device_usage,
+        stats.budget.host_budget,   stats.budget.host_usage
+    );
+    memory_stats_write_section(buffer, buffer_size, &length, "device_buffers", &stats.device_buffers, FALSE);
+    memory_stats_write_section(buffer, buffer_size, &length, "device_images",  &stats.device_images,  FALSE);
+    memory_stats_write_section(buffer, buffer_size, &length, "host_transfer",  &stats.host_transfer,  FALSE);
+    memory_stats_write_section(buffer, buffer_size, &length, "host_readback",  &stats.host_readback,  TRUE );
+    memory_stats_write(buffer, buffer_size, &length, "  },\n  \"buffers\": [");
+
+    /* buffers, ids are the handles gpu_create_buffer returned */
+    b32 is_first = TRUE;
+    for(u32 i = 0; i != vulkan_resources->buffers_count; i++) {
+        const GpuBuffer* gpu_buffer = &vulkan_resources->buffers[i];
+        if(gpu_buffer->buffer == NULL) {
+            continue;
+        }
+
+        memory_stats_write(
+            buffer, buffer_size, &length,
+            "%s\n    {\"id\": %u, \"section\": \"%s\", \"size\": %llu, \"allocation_size\": %llu, \"allocation_offset\": %llu, \"block\": %u}",
+            is_first ? "" : ",",
+            i | (vulkan_resources->buffer_generations[i] << GPU_HANDLE_GENERATION_SHIFT),
+            (gpu_buffer->frame_stride != 0) ? "host_transfer" : "device_buffers",
+            gpu_buffer->used_size,
+            gpu_buffer->allocation_size,
+            gpu_buffer->allocation_offset,
+            gpu_buffer->allocation_id >> GPU_VIDEO_MEMORY_BLOCK_SHIFT
+        );
+        is_first = FALSE;
+    }
+    memory_stats_write(buffer, buffer_size, &length, "\n  ],\n  \"images\": [");
+
+    /* images, transient offsets point into the shared allocation */
+    is_first = TRUE;
+    for(u32 i = 0; i != vulkan_resources->images_count; i++) {
+        const GpuImage* image = &vulkan_resources->images[i];
+        if(image->image == NULL) {
+            continue;
+        }
+
+        const char* memory_name = 
+            (image->lazy_memory != NULL) ? "lazy"      :
+            (image->transient          ) ? "transient" : "device_images";
+
+        memory_stats_write(
+            buffer, buffer_size, &length,
+            "%s\n    {\"id\": %u, \"memory\": \"%s\", \"vk_format\": %u, \"size_x\": %u, \"size_y\": %u, "
+            "\"allocation_size\": %llu, \"allocation_offset\": %llu}",
+            is_first ? "" : ",",
+            i | (vulkan_resources->image_generations[i] << GPU_HANDLE_GENERATION_SHIFT),
+            memory_name,
+            (u32)image->format,
+            image->size_x,
+            image->size_y,
+            image->allocation_size,
+            image->allocation_offset
+        );
+        is_first = FALSE;
+    }
+    memory_stats_write(
+        buffer, buffer_size, &length,
+        "\n  ],\n  \"transfer\": [\n"
+        "    {\"name\": \"upload_ring\", \"size\": %llu, \"allocation_offset\": %llu},\n"
+        "    {\"name\": \"stream_ring\", \"size\": %llu, \"allocation_offset\": %llu}\n"
+        "  ],\n  \"host\": {\n",
+        vulkan_resources->buffer_upload_ring.allocation_size, vulkan_resources->buffer_upload_ring.allocation_offset,
+        vulkan_resources->buffer_stream_ring.allocation_size, vulkan_resources->buffer_stream_ring.allocation_offset
+    );
+
+    /* driver host memory per allocation scope */
+    const char* scope_names[GPU_HOST_SCOPE_COUNT] = {
+        [GPU_HOST_SCOPE_COMMAND ] = "command",
+        [GPU_HOST_SCOPE_OBJECT  ] = "object",
+        [GPU_HOST_SCOPE_CACHE   ] = "cache",
+        [GPU_HOST_SCOPE_DEVICE  ] = "device",
+        [GPU_HOST_SCOPE_INSTANCE] = "instance"
+    };
+    for(u32 i = 0; i != GPU_HOST_SCOPE_COUNT; i++) {
+        const GpuHostScopeStats* scope = &stats.host_scopes[i];
+        memory_stats_write(
+            buffer, buffer_size, &length,
+            "    \"%s\": {\"allocations\": %u, \"allocations_total\": %u, \"heap_fallbacks\": %u, "
+            "\"committed\": %llu, \"used\": %llu, \"peak\": %llu, \"internal\": %llu}%s\n",
+            scope_names[i], scope->allocations_count, scope->allocations_total, scope->heap_fallbacks,
+            scope->committed, scope->used, scope->peak, scope->internal, (i + 1 == GPU_HOST_SCOPE_COUNT) ? "" : ","
+        );
+    }
+    memory_stats_write(buffer, buffer_size, &length, "  }\n}\n");
+
+    return length;
+}
@@ -0,0 +1,360 @@
+#include "gpu_internal.h"
+
+/* frees ring space of released readbacks at the front */
+void readback_pop_released(
+    VulkanReadback* vulkan_readback
+) {
+    while(vulkan_readback->readbacks_count != 0) {
+        const GpuReadback* readback = &vulkan_readback->readbacks[vulkan_readback->readbacks_first];
+        if(!readback->released) {
+            break;
+        }
+        vulkan_readback->readbacks_first = (vulkan_readback->readbacks_first + 1) % GPU_MAX_READBACKS;
+        vulkan_readback->readbacks_count--;
+    }
+
+    vulkan_readback->ring_tail = (vulkan_readback->readbacks_count != 0) ?
+        vulkan_readback->readbacks[vulkan_readback->readbacks_first].ring_begin :
+        vulkan_readback->ring_head;
+}
+
+/* invalidates and marks readbacks of retired frames, host sees the copies after it */
+void readback_resolve(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanReadback*        vulkan_readback,
+    u64                    frame_completed
+) {
+    const GpuBuffer* readback_ring = &vulkan_resources->buffer_readback_ring;
+    const u64        atom_size     = vulkan_device->adapter->non_coherent_atom_size;
+
+    VkMappedMemoryRange invalidate_ranges[GPU_MAX_READBACKS];
+    u32                 invalidate_ranges_count = 0;
+
+    for(u32 i = 0; i != vulkan_readback->readbacks_count; i++) {
+        GpuReadback* readback = &vulkan_readback->readbacks[(vulkan_readback->readbacks_first + i) % GPU_MAX_READBACKS];
+
+        if(readback->resolved || readback->released || readback->frame_value > frame_completed) {
+            continue;
+        }
+        readback->resolved = TRUE;
+
+        if(readback_ring->host_coherent) {
+            continue;
+        }
+
+        const u64 memory_offset = readback_ring->allocation_offset + readback->offset;
+        const u64 range_begin   = memory_offset / atom_size * atom_size;
+        const u64 range_end     = MIN((memory_offset + readback->size + atom_size - 1) / atom_size * atom_size, readback_ring->memory_size);
+
+        invalidate_ranges[invalidate_ranges_count++] = (VkMappedMemoryRange) {
+            .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .memory = readback_ring->memory,
+            .offset = range_begin,
+            .size   = range_end - range_begin
+        };
+    }
+
+    if(invalidate_ranges_count != 0) {
+        vkInvalidateMappedMemoryRanges(vulkan_device->device, invalidate_ranges_count, invalidate_ranges);
+    }
+}
+
+/* returns offset inside buffer_readback_ring, expires the oldest resolved readbacks if the ring is full */
+/* allocations never wrap around the ring end, U64_MAX = ring is full of readbacks in flight */
+u64 readback_ring_allocate(
+    VulkanReadback* vulkan_readback,
+    u64             size,
+    u64             alignment,
+    u64*            ring_begin
+) {
+    if(size > GPU_READBACK_RING_SIZE) {
+        LOG_ERROR("exceed readback ring size: %llu/%llu", size, (u64)GPU_READBACK_RING_SIZE);
+        goto fail;
+    }
+
+    while(1) {
+        const u64 head_offset = vulkan_readback->ring_head % GPU_READBACK_RING_SIZE;
+        u64       ring_offset = ((head_offset + alignment - 1) / alignment) * alignment;
+        u64       data_begin  = vulkan_readback->ring_head + (ring_offset - head_offset);
+
+        if(ring_offset + size > GPU_READBACK_RING_SIZE) {
+            ring_offset = 0;
+            data_begin  = vulkan_readback->ring_head + (GPU_READBACK_RING_SIZE - head_offset);
+        }
+        if(
+            data_begin + size - vulkan_readback->ring_tail <= GPU_READBACK_RING_SIZE &&
+            vulkan_readback->readbacks_count != GPU_MAX_READBACKS
+        ) {
+            *ring_begin                = vulkan_readback->ring_head;
+            vulkan_readback->ring_head = data_begin + size;
+            return ring_offset;
+        }
+
+        /* data nobody polled is given up before anything waits */
+        GpuReadback* oldest = &vulkan_readback->readbacks[vulkan_readback->readbacks_first];
+        if(vulkan_readback->readbacks_count == 0 || !oldest->resolved) {
+            LOG_ERROR("readback ring is full of readbacks in flight");
+            goto fail;
+        }
+        LOG_WARNING("readback expired before it was polled ticket: %llu", oldest->ticket);
+        oldest->released = TRUE;
+        readback_pop_released(vulkan_readback);
+    }
+
+    fail: {
+        return U64_MAX;
+    }
+}
+
+u64 gpu_request_readback(
+    CtxHandle           ctx,
+    const ReadbackInfo* readback_info
+) {
+    if(ctx == NULL || readback_info == NULL) {
+        LOG_ERROR("input params are NULL");
+        goto fail;
+    }
+
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanUpload*    vulkan_upload    = &gpu_ctx->vulkan_upload;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+    VulkanReadback*        vulkan_readback  = &gpu_ctx->vulkan_readback;
+    const GpuBuffer*       readback_ring    = &vulkan_resources->buffer_readback_ring;
+
+    if(readback_ring->buffer == NULL) {
+        LOG_ERROR("readbacks are not available");
+        goto fail;
+    }
+    if(vulkan_render->async_compute_recording && vulkan_device->queue_compute != NULL) {
+        LOG_ERROR("readback inside async compute");
+        goto fail;
+    }
+    if(vulkan_render->passes_recording || vulkan_render->bake_recording || vulkan_render->latching) {
+        LOG_ERROR("readback outside frame command buffer");
+        goto fail;
+    }
+
+    /* validation */
+    const u32 resource_slot = readback_info->is_image ?
+        resources_image_slot(vulkan_resources, readback_info->resource_id) :
+        resources_buffer_slot(vulkan_resources, readback_info->resource_id);
+
+    if(resource_slot == U32_MAX) {
+        LOG_ERROR("invalid readback resource id: %u image: %u", readback_info->resource_id, readback_info->is_image);
+        goto fail;
+    }
+    if(upload_is_pending(vulkan_upload, readback_info->is_image, resource_slot)) {
+        LOG_ERROR("readback of resource with pending upload id: %u", readback_info->resource_id);
+        goto fail;
+    }
+
+    const GpuBuffer* gpu_buffer = readback_info->is_image ? NULL : &vulkan_resources->buffers[resource_slot];
+    const GpuImage*  gpu_image  = readback_info->is_image ? &vulkan_resources->images[resource_slot] : NULL;
+    u64              data_size  = 0;
+    u64              alignment  = GPU_READBACK_ALIGNMENT;
+
+    if(gpu_image != NULL) {
+        const u32 texel_size = format_texel_size(gpu_image->format);
+
+        if(texel_size == 0) {
+            LOG_ERROR("image format can't be read back id: %u format: %u", readback_info->resource_id, gpu_image->format);
+            goto fail;
+        }
+        if(
+            readback_info->size_x == 0 || readback_info->x + readback_info->size_x > gpu_image->size_x ||
+            readback_info->size_y == 0 || readback_info->y + readback_info->size_y > gpu_image->size_y
+        ) {
+            LOG_ERROR(
+                "invalid image readback rect: (%u+%u, %u+%u)/(%u, %u)",
+                readback_info->x, readback_info->size_x, readback_info->y, readback_info->size_y,
+                gpu_image->size_x, gpu_image->size_y
+            );
+            goto fail;
+        }
+        /* copy offset has to be a multiple of texel size */
+        data_size = (u64)readback_info->size_x * readback_info->size_y * texel_size;
+        alignment = (u64)GPU_READBACK_ALIGNMENT * texel_size;
+    }
+    else {
+        if(gpu_buffer->frame_stride != 0) {
+            LOG_ERROR("late latch buffers are host written id: %u", readback_info->resource_id);
+            goto fail;
+        }
+        if(readback_info->size == 0 || readback_info->offset + readback_info->size > gpu_buffer->used_size) {
+            LOG_ERROR(
+                "invalid buffer readback range: (%llu+%llu)/%llu",
+                readback_info->offset, readback_info->size, gpu_buffer->used_size
+            );
+            goto fail;
+        }
+        data_size = readback_info->size;
+    }
+
+    /* ring space, retired readbacks have to be resolved to expire */
+    readback_resolve(vulkan_device, vulkan_resources, vulkan_readback, gpu_render_frame_completed(ctx));
+
+    u64       ring_begin  = 0;
+    const u64 ring_offset = readback_ring_allocate(vulkan_readback, data_size, alignment, &ring_begin);
+    if(ring_offset == U64_MAX) {
+        goto fail;
+    }
+
+    /* batched writes land before the copy reads them */
+    flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+
+    GpuBarrierBatch source_batch;
+    barrier_batch_reset(&source_batch);
+
+    if(gpu_image != NULL) {
+        barrier_batch_transit_image(
+            &source_batch,
+            &vulkan_render->barrier_stats,
+            gpu_image,
+            &vulkan_render->image_states[resource_slot],
+            VK_ACCESS_2_TRANSFER_READ_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_PIPELINE_STAGE_2_COPY_BIT
+        );
+        record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &source_batch);
+
+        const VkBufferImageCopy image_copy = {
+            .bufferOffset      = ring_offset,
+            .bufferRowLength   = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource  = (VkImageSubresourceLayers) {
+                .aspectMask     = gpu_image->aspect,
+                .mipLevel       = 0,
+                .baseArrayLayer = 0,
+                .layerCount     = 1
+            },
+            .imageOffset       = (VkOffset3D) {
+                .x = (i32)readback_info->x,
+                .y = (i32)readback_info->y,
+                .z = 0
+            },
+            .imageExtent       = (VkExtent3D) {
+                .width  = readback_info->size_x,
+                .height = readback_info->size_y,
+                .depth  = 1
+            }
+        };
+        vkCmdCopyImageToBuffer(
+            vulkan_render->command_buffer,
+            gpu_image->image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            readback_ring->buffer,
+            1,
+            &image_copy
+        );
+    }
+    else {
+        barrier_batch_transit_buffer(
+            &source_batch,
+            &vulkan_render->barrier_stats,
+            gpu_buffer,
+            &vulkan_render->buffer_states[resource_slot],
+            VK_ACCESS_2_TRANSFER_READ_BIT,
+            VK_PIPELINE_STAGE_2_COPY_BIT
+        );
+        record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &source_batch);
+
+        const VkBufferCopy buffer_copy = {
+            .srcOffset = readback_info->offset,
+            .dstOffset = ring_offset,
+            .size      = data_size
+        };
+        vkCmdCopyBuffer(
+            vulkan_render->command_buffer,
+            gpu_buffer->buffer,
+            readback_ring->buffer,
+            1,
+            &buffer_copy
+        );
+    }
+
+    /* copy is made visible to host reads, they happen only after the frame retired */
+    const VkBufferMemoryBarrier2 host_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer              = readback_ring->buffer,
+        .offset              = ring_offset,
+        .size                = data_size,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
+        .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED
+    };
+    GpuBarrierBatch host_batch;
+    barrier_batch_reset(&host_batch);
+    barrier_batch_add_buffer(&host_batch, &vulkan_render->barrier_stats, &host_barrier);
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &host_batch);
+
+    /* queue slot was checked by the allocation */
+    const u64 ticket = ++vulkan_readback->ticket_counter;
+
+    vulkan_readback->readbacks[(vulkan_readback->readbacks_first + vulkan_readback->readbacks_count) % GPU_MAX_READBACKS] = (GpuReadback) {
+        .ticket      = ticket,
+        .frame_value = vulkan_render->frames[vulkan_render->frame_id].frame_value,
+        .ring_begin  = ring_begin,
+        .ring_end    = vulkan_readback->ring_head,
+        .offset      = ring_offset,
+        .size        = data_size
+    };
+    vulkan_readback->readbacks_count++;
+
+    return ticket;
+
+    fail: {
+        return 0;
+    }
+}
+
+/* 0 = ready
+   1 = pending
+   2 = unknown or expired ticket */
+i32 gpu_readback_poll(
+    CtxHandle ctx,
+    u64       ticket,
+    void*     data,
+    u64       data_size
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanReadback*        vulkan_readback  = &gpu_ctx->vulkan_readback;
+    const GpuBuffer*       readback_ring    = &vulkan_resources->buffer_readback_ring;
+
+    GpuReadback* readback = NULL;
+    for(u32 i = 0; i != vulkan_readback->readbacks_count; i++) {
+        GpuReadback* candidate = &vulkan_readback->readbacks[(vulkan_readback->readbacks_first + i) % GPU_MAX_READBACKS];
+        if(candidate->ticket == ticket) {
+            readback = candidate;
+            break;
+        }
+    }
+    if(readback == NULL || readback->released) {
+        return 2;
+    }
+
+    /* timeline counter is read without waiting */
+    if(!readback->resolved) {
+        readback_resolve(vulkan_device, vulkan_resources, vulkan_readback, gpu_render_frame_completed(ctx));
+        if(!readback->resolved) {
+            return 1;
+        }
+    }
+
+    memcpy(
+        data,
+        (const u8*)readback_ring->memory_map + readback_ring->allocation_offset + readback->offset,
+        MIN(readback->size, data_size)
+    );
+    readback->released = TRUE;
+    readback_pop_released(vulkan_readback);
+
+    return 0;
+}
@@ -1,5 +1,439 @@
 #include "gpu_internal.h"
 
+/* BARRIERS */
+
+/* read after read in the same layout by already synchronized stages, previous barrier made data visible */
+b32 barrier_is_redundant(
+    VkAccessFlags2        src_access,
+    VkImageLayout         src_layout,
+    VkPipelineStageFlags2 src_stage,
+    VkAccessFlags2        dst_access,
+    VkImageLayout         dst_layout,
+    VkPipelineStageFlags2 dst_stage
+) {
+    return 
+        src_access != VK_ACCESS_2_NONE                &&
+        (src_access & GPU_ACCESS_WRITE_MASK) == 0     &&
+        (dst_access & GPU_ACCESS_WRITE_MASK) == 0     &&
+        (dst_access & ~src_access) == 0               &&
+        (dst_stage  & ~src_stage ) == 0               &&
+        src_layout == dst_layout;
+}
+
+void barrier_batch_reset(
+    GpuBarrierBatch* batch
+) {
+    batch->image_barriers_count  = 0;
+    batch->buffer_barriers_count = 0;
+}
+
+/* second barrier of the same image is merged into the first one */
+void barrier_batch_add_image(
+    GpuBarrierBatch*             batch,
+    BarrierStats*                stats,
+    const VkImageMemoryBarrier2* barrier
+) {
+    for(u32 i = 0; i != batch->image_barriers_count; i++) {
+        VkImageMemoryBarrier2* merged = &batch->image_barriers[i];
+
+        if(merged->image == barrier->image) {
+            merged->dstStageMask  |= barrier->dstStageMask;
+            merged->dstAccessMask |= barrier->dstAccessMask;
+            merged->newLayout      = barrier->newLayout;
+            stats->barriers_elided++;
+            return;
+        }
+    }
+    batch->image_barriers[batch->image_barriers_count++] = *barrier;
+    stats->barriers_emitted++;
+}
+
+void barrier_batch_add_buffer(
+    GpuBarrierBatch*              batch,
+    BarrierStats*                 stats,
+    const VkBufferMemoryBarrier2* barrier
+) {
+    for(u32 i = 0; i != batch->buffer_barriers_count; i++) {
+        VkBufferMemoryBarrier2* merged = &batch->buffer_barriers[i];
+
+        if(merged->buffer == barrier->buffer) {
+            merged->dstStageMask  |= barrier->dstStageMask;
+            merged->dstAccessMask |= barrier->dstAccessMask;
+            stats->barriers_elided++;
+            return;
+        }
+    }
+    batch->buffer_barriers[batch->buffer_barriers_count++] = *barrier;
+    stats->barriers_emitted++;
+}
+
+/* aliasing barrier, discarded transient image waits for the last access to its shared memory */
+void alias_image_state(
+    const VulkanResources* vulkan_resources,
+    VulkanRender*          vulkan_render,
+    u32                    image_id
+) {
+    const GpuImage* image = &vulkan_resources->images[image_id];
+    GpuImageState*  state = &vulkan_render->image_states[image_id];
+
+    if(image->alias_mask == 0 || state->layout != VK_IMAGE_LAYOUT_UNDEFINED) {
+        return;
+    }
+    /* only static images alias */
+    for(u32 i = 0; i != vulkan_resources->static_images_count; i++) {
+        if(image->alias_mask & (0x1 << i)) {
+            state->stage  |= vulkan_render->image_states[i].stage;
+            state->access |= vulkan_render->image_states[i].access & GPU_ACCESS_WRITE_MASK;
+        }
+    }
+}
+
+/* transition from the tracked state */
+void barrier_batch_transit_image(
+    GpuBarrierBatch*      batch,
+    BarrierStats*         stats,
+    const GpuImage*       image,
+    GpuImageState*        state,
+    VkAccessFlags2        dst_access,
+    VkImageLayout         dst_layout,
+    VkPipelineStageFlags2 dst_stage
+) {
+    if(barrier_is_redundant(state->access, state->layout, state->stage, dst_access, dst_layout, dst_stage)) {
+        stats->barriers_elided++;
+        return;
+    }
+
+    const VkImageMemoryBarrier2 image_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image               = image->image,
+        .srcStageMask        = state->stage,
+        .srcAccessMask       = state->access,
+        .oldLayout           = state->layout,
+        .dstStageMask        = dst_stage,
+        .dstAccessMask       = dst_access,
+        .newLayout           = dst_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .subresourceRange    = (VkImageSubresourceRange) {
+            .aspectMask     = image->aspect,
+            .baseArrayLayer = 0,
+            .layerCount     = 1,
+            .baseMipLevel   = 0,
+            .levelCount     = 1
+        }
+    };
+    barrier_batch_add_image(batch, stats, &image_barrier);
+
+    *state = (GpuImageState) {
+        .access = dst_access,
+        .layout = dst_layout,
+        .stage  = dst_stage
+    };
+}
+
+void barrier_batch_transit_buffer(
+    GpuBarrierBatch*      batch,
+    BarrierStats*         stats,
+    const GpuBuffer*      buffer,
+    GpuBufferState*       state,
+    VkAccessFlags2        dst_access,
+    VkPipelineStageFlags2 dst_stage
+) {
+    if(barrier_is_redundant(state->access, VK_IMAGE_LAYOUT_UNDEFINED, state->stage, dst_access, VK_IMAGE_LAYOUT_UNDEFINED, dst_stage)) {
+        stats->barriers_elided++;
+        return;
+    }
+
+    const VkBufferMemoryBarrier2 buffer_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer              = buffer->buffer,
+        .size                = buffer->used_size,
+        .offset              = 0,
+        .srcStageMask        = state->stage,
+        .srcAccessMask       = state->access,
+        .dstStageMask        = dst_stage,
+        .dstAccessMask       = dst_access,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED
+    };
+    barrier_batch_add_buffer(batch, stats, &buffer_barrier);
+
+    *state = (GpuBufferState) {
+        .access = dst_access,
+        .stage  = dst_stage
+    };
+}
+
+/* all barriers of the batch in one call */
+void record_barrier_batch(
+    const VulkanDevice*    vulkan_device,
+    VkCommandBuffer        command_buffer,
+    BarrierStats*          stats,
+    const GpuBarrierBatch* batch
+) {
+    if(batch->image_barriers_count == 0 && batch->buffer_barriers_count == 0) {
+        return;
+    }
+
+    const VkDependencyInfo dependency_info = {
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = batch->buffer_barriers_count,
+        .pBufferMemoryBarriers    = batch->buffer_barriers,
+        .imageMemoryBarrierCount  = batch->image_barriers_count,
+        .pImageMemoryBarriers     = batch->image_barriers
+    };
+    vulkan_device->cmd_pipeline_barrier2_khr(command_buffer, &dependency_info);
+    stats->barrier_calls++;
+}
+
+/* records pending upload ring copies: one barrier for all targets, one copy per target buffer */
+void flush_upload_copies(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanRender*          vulkan_render
+) {
+    const u32            upload_copies_count = vulkan_render->upload_copies_count;
+    const GpuUploadCopy* upload_copies       = vulkan_render->upload_copies;
+    const GpuBuffer*     gpu_buffers         = vulkan_resources->buffers;
+    const u32            gpu_buffers_count   = vulkan_resources->buffers_count;
+    GpuBufferState*      buffer_states       = vulkan_render->buffer_states;
+
+    if(upload_copies_count == 0) {
+        return;
+    }
+
+    /* transfer barriers */
+    GpuBarrierBatch transfer_batch;
+    u32             copies_per_buffer[GPU_MAX_BUFFERS] = {0};
+
+    barrier_batch_reset(&transfer_batch);
+
+    for(u32 i = 0; i != upload_copies_count; i++) {
+        copies_per_buffer[upload_copies[i].buffer_id]++;
+    }
+    for(u32 i = 0; i != gpu_buffers_count; i++) {
+        if(copies_per_buffer[i] == 0) {
+            continue;
+        }
+        barrier_batch_transit_buffer(
+            &transfer_batch,
+            &vulkan_render->barrier_stats,
+            &gpu_buffers[i],
+            &buffer_states[i],
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COPY_BIT
+        );
+    }
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &transfer_batch);
+
+    /* batched copies */
+    VkBufferCopy buffer_copies[GPU_MAX_UPLOAD_COPIES];
+
+    for(u32 i = 0; i != gpu_buffers_count; i++) {
+        if(copies_per_buffer[i] == 0) {
+            continue;
+        }
+
+        u32 buffer_copies_count = 0;
+        for(u32 j = 0; j != upload_copies_count; j++) {
+            if(upload_copies[j].buffer_id == i) {
+                buffer_copies[buffer_copies_count++] = upload_copies[j].region;
+            }
+        }
+
+        vkCmdCopyBuffer(
+            vulkan_render->command_buffer,
+            vulkan_resources->buffer_upload_ring.buffer,
+            gpu_buffers[i].buffer,
+            buffer_copies_count,
+            buffer_copies
+        );
+    }
+
+    vulkan_render->upload_copies_count = 0;
+}
+
+/* flushes every dirty range in one call */
+void flush_dirty_ranges(
+    const VulkanDevice* vulkan_device,
+    VulkanRender*       vulkan_render
+) {
+    const GpuDirtyRange* dirty_ranges       = vulkan_render->dirty_ranges;
+    const u32            dirty_ranges_count = vulkan_render->dirty_ranges_count;
+
+    if(dirty_ranges_count == 0) {
+        return;
+    }
+
+    VkMappedMemoryRange flush_ranges[GPU_MAX_DIRTY_RANGES];
+    for(u32 i = 0; i != dirty_ranges_count; i++) {
+        flush_ranges[i] = (VkMappedMemoryRange) {
+            .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .memory = dirty_ranges[i].memory,
+            .offset = dirty_ranges[i].begin,
+            .size   = dirty_ranges[i].end - dirty_ranges[i].begin
+        };
+    }
+
+    vkFlushMappedMemoryRanges(vulkan_device->device, dirty_ranges_count, flush_ranges);
+    vulkan_render->dirty_ranges_count = 0;
+}
+
+/* marks host written bytes of a mapped buffer, offset is from the start of its memory block */
+/* range grows to the atom size and swallows every range of the block it touches */
+void mark_dirty_range(
+    const VulkanDevice* vulkan_device,
+    VulkanRender*       vulkan_render,
+    const GpuBuffer*    gpu_buffer,
+    u64                 offset,
+    u64                 size
+) {
+    if(gpu_buffer->host_coherent || size == 0) {
+        return;
+    }
+
+    GpuDirtyRange* dirty_ranges = vulkan_render->dirty_ranges;
+    const u64      atom_size    = vulkan_device->adapter->non_coherent_atom_size;
+
+    /* rounding up can pass the end of the memory, ranges reaching it may end unaligned */
+    u64 begin = offset / atom_size * atom_size;
+    u64 end   = MIN((offset + size + atom_size - 1) / atom_size * atom_size, gpu_buffer->memory_size);
+
+    for(u32 i = 0; i < vulkan_render->dirty_ranges_count;) {
+        const GpuDirtyRange range = dirty_ranges[i];
+        if(range.memory != gpu_buffer->memory || range.end < begin || end < range.begin) {
+            i++;
+            continue;
+        }
+        begin           = MIN(begin, range.begin);
+        end             = MAX(end, range.end);
+        dirty_ranges[i] = dirty_ranges[--vulkan_render->dirty_ranges_count];
+    }
+
+    if(vulkan_render->dirty_ranges_count == GPU_MAX_DIRTY_RANGES) {
+        flush_dirty_ranges(vulkan_device, vulkan_render);
+    }
+    dirty_ranges[vulkan_render->dirty_ranges_count++] = (GpuDirtyRange) {
+        .memory = gpu_buffer->memory,
+        .begin  = begin,
+        .end    = end
+    };
+}
+
+/* flushes host writes of the frame, upload ring bytes since the last flush and frame uniforms slices included */
+/* has to happen before any submit reading them */
+void flush_host_writes(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanRender*          vulkan_render
+) {
+    const GpuFrame* frame = &vulkan_render->frames[vulkan_render->frame_id];
+
+    /* record threads are done, allocated sizes don't move anymore */
+    for(u32 i = 0; i != vulkan_resources->buffers_count; i++) {
+        const GpuBuffer* gpu_buffer = &vulkan_resources->buffers[i];
+        if(!gpu_buffer->frame_uniforms || vulkan_render->uniforms_allocated[i] == 0) {
+            continue;
+        }
+        mark_dirty_range(
+            vulkan_device,
+            vulkan_render,
+            gpu_buffer,
+            gpu_buffer->allocation_offset + gpu_buffer->frame_stride * vulkan_render->frame_id,
+            MIN((u64)vulkan_render->uniforms_allocated[i], gpu_buffer->used_size)
+        );
+    }
+
+    mark_dirty_range(
+        vulkan_device,
+        vulkan_render,
+        &vulkan_resources->buffer_upload_ring,
+        vulkan_resources->buffer_upload_ring.allocation_offset + frame->upload_offset + vulkan_render->upload_flushed_size,
+        vulkan_render->upload_size - vulkan_render->upload_flushed_size
+    );
+    vulkan_render->upload_flushed_size = vulkan_render->upload_size;
+
+    flush_dirty_ranges(vulkan_device, vulkan_render);
+}
+
+/* resets, begins and binds descriptor sets */
+b32 begin_command_buffer(
+    const VulkanShaders* vulkan_shaders,
+    const u32*           dynamic_offsets,
+    VkCommandBuffer      command_buffer,
+    b32                  bind_graphics
+) {
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+    };
+    if(vkResetCommandBuffer(command_buffer, 0) != VK_SUCCESS) {
+        LOG_ERROR("failed to reset command buffer");
+        goto fail;
+    }
+    if(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS) {
+        LOG_ERROR("failed to begin command buffer");
+        goto fail;
+    }
+
+    if(bind_graphics) {
+        vkCmdBindDescriptorSets(
+            command_buffer, 
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            vulkan_shaders->pipeline_layout,
+            0,
+            GPU_DESCRIPTOR_SET_COUNT,
+            vulkan_shaders->descriptor_sets,
+            vulkan_shaders->dynamic_bindings_count,
+            dynamic_offsets
+        );
+    }
+    vkCmdBindDescriptorSets(
+        command_buffer, 
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        vulkan_shaders->pipeline_layout,
+        0,
+        GPU_DESCRIPTOR_SET_COUNT,
+        vulkan_shaders->descriptor_sets,
+        vulkan_shaders->dynamic_bindings_count,
+        dynamic_offsets
+    );
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* rebinds descriptor sets with per draw dynamic offsets, NULL keeps the bound ones */
+void bind_dynamic_offsets(
+    const VulkanShaders* vulkan_shaders,
+    const VulkanRender*  vulkan_render,
+    VkCommandBuffer      command_buffer,
+    VkPipelineBindPoint  bind_point,
+    const u32*           dynamic_offsets
+) {
+    if(dynamic_offsets == NULL || vulkan_shaders->dynamic_bindings_count == 0) {
+        return;
+    }
+
+    u32 offsets[GPU_MAX_DYNAMIC_BINDINGS];
+    for(u32 i = 0; i != vulkan_shaders->dynamic_bindings_count; i++) {
+        offsets[i] = (dynamic_offsets[i] == U32_MAX) ? vulkan_render->dynamic_offsets[i] : dynamic_offsets[i];
+    }
+
+    vkCmdBindDescriptorSets(
+        command_buffer, 
+        bind_point,
+        vulkan_shaders->pipeline_layout,
+        0,
+        GPU_DESCRIPTOR_SET_COUNT,
+        vulkan_shaders->descriptor_sets,
+        vulkan_shaders->dynamic_bindings_count,
+        offsets
+    );
+}
+
 b32 gpu_render_init(
     CtxHandle ctx
 ) {
@@ -8,50 +442,147 @@ b32 gpu_render_init(
         goto fail;
     }
 
-    GpuContext*         gpu_ctx       = (GpuContext*)ctx;
-    const VulkanDevice* vulkan_device = &gpu_ctx->vulkan_device;
-    const VkDevice      device        = vulkan_device->device;
-    VulkanRender*       vulkan_render = &gpu_ctx->vulkan_render;
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VkDevice         device           = vulkan_device->device;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+    const u32              frames_count     = vulkan_device->frames_in_flight;
 
-    /* create command buffer */
-    const VkCommandBufferAllocateInfo command_buffer_render_info = {
-        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool        = vulkan_device->command_pool_render,
-        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1
-    };
+    /* frame_begin advances the ring before recording, first frame is 0 */
+    vulkan_render->frames_count = frames_count;
+    vulkan_render->frame_id     = frames_count - 1;
 
-    if(vkAllocateCommandBuffers(device, &command_buffer_render_info, &vulkan_render->command_buffer_render) != VK_SUCCESS) {
-        LOG_ERROR("failed to create render command buffer");
-        goto fail;
+    if(vulkan_device->frame_overlap_check) {
+        LARGE_INTEGER frequency_counter = (LARGE_INTEGER){0};
+        QueryPerformanceFrequency(&frequency_counter);
+        vulkan_render->overlap_stats.counter_frequency = frequency_counter.QuadPart;
     }
 
-    /* create fences and semaphores */
-    const VkFenceCreateInfo fence_signaled_info = {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .flags = VK_FENCE_CREATE_SIGNALED_BIT
-    };
+    /* uploads mark images persistent too */
+    for(u32 i = 0; i != vulkan_resources->images_count; i++) {
+        vulkan_render->images_persistent[i] = vulkan_resources->images[i].persistent;
+    }
+
+    /* create semaphores */
     const VkSemaphoreCreateInfo semaphore_info = {
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
     };
+    const VkSemaphoreTypeCreateInfo timeline_type_info = {
+        .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue  = 0
+    };
+    const VkSemaphoreCreateInfo timeline_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timeline_type_info
+    };
 
-    VkSemaphore* semaphores_images_finished = vulkan_render->semaphores_images_finished;
-
-    if(vkCreateFence(device, &fence_signaled_info, NULL, &vulkan_render->fence_frame) != VK_SUCCESS) {
-        LOG_ERROR("failed to create frame fence");
+    if(vkCreateSemaphore(device, &timeline_info, vulkan_device->allocator, &vulkan_render->semaphore_frame_timeline) != VK_SUCCESS) {
+        LOG_ERROR("failed to create frame timeline semaphore");
         goto fail;
     }
-    if(vkCreateSemaphore(device, &semaphore_info, NULL, &vulkan_render->semaphore_image_available) != VK_SUCCESS) {
-        LOG_ERROR("failed to create image available semaphore");
+    if(vkCreateSemaphore(device, &timeline_info, vulkan_device->allocator, &vulkan_render->semaphore_compute_timeline) != VK_SUCCESS) {
+        LOG_ERROR("failed to create compute timeline semaphore");
         goto fail;
     }
+
+    /* per frame objects */
+    for(u32 i = 0; i != frames_count; i++) {
+        GpuFrame* frame = &vulkan_render->frames[i];
+
+        /* render, overlap and join */
+        const VkCommandBufferAllocateInfo command_buffer_render_info = {
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool        = vulkan_device->command_pool_render,
+            .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 3
+        };
+        VkCommandBuffer command_buffers_render[3] = {0};
+
+        if(vkAllocateCommandBuffers(device, &command_buffer_render_info, command_buffers_render) != VK_SUCCESS) {
+            LOG_ERROR("failed to create render command buffers frame: %u/%u", i, frames_count);
+            goto fail;
+        }
+        frame->command_buffer_render         = command_buffers_render[0];
+        frame->command_buffer_render_overlap = command_buffers_render[1];
+        frame->command_buffer_render_join    = command_buffers_render[2];
+
+        /* async compute */
+        if(vulkan_device->queue_compute != NULL) {
+            const VkCommandBufferAllocateInfo command_buffer_compute_info = {
+                .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool        = vulkan_device->command_pool_compute,
+                .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1
+            };
+
+            if(vkAllocateCommandBuffers(device, &command_buffer_compute_info, &frame->command_buffer_compute) != VK_SUCCESS) {
+                LOG_ERROR("failed to create compute command buffer frame: %u/%u", i, frames_count);
+                goto fail;
+            }
+        }
+        if(vkCreateSemaphore(device, &semaphore_info, vulkan_device->allocator, &frame->semaphore_image_available) != VK_SUCCESS) {
+            LOG_ERROR("failed to create image available semaphore frame: %u/%u", i, frames_count);
+            goto fail;
+        }
+
+        /* parallel passes, one pool per recording thread */
+        for(u32 j = 0; j != GPU_MAX_RECORD_THREADS; j++) {
+            GpuThreadCommands* thread_commands = &frame->thread_commands[j];
+
+            const VkCommandPoolCreateInfo thread_command_pool_info = {
+                .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .queueFamilyIndex = vulkan_device->adapter->render_queue_id,
+                .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+            };
+            if(vkCreateCommandPool(device, &thread_command_pool_info, vulkan_device->allocator, &thread_commands->command_pool) != VK_SUCCESS) {
+                LOG_ERROR("failed to create thread command pool frame: %u/%u thread: %u", i, frames_count, j);
+                goto fail;
+            }
+
+            const VkCommandBufferAllocateInfo thread_command_buffers_info = {
+                .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool        = thread_commands->command_pool,
+                .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = GPU_MAX_PARALLEL_PASSES
+            };
+            if(vkAllocateCommandBuffers(device, &thread_command_buffers_info, thread_commands->command_buffers) != VK_SUCCESS) {
+                LOG_ERROR("failed to create thread command buffers frame: %u/%u thread: %u", i, frames_count, j);
+                goto fail;
+            }
+        }
+        frame->upload_offset = (u64)i * GPU_UPLOAD_FRAME_SIZE;
+    }
+
+    VkSemaphore* semaphores_images_finished = vulkan_render->semaphores_images_finished;
+
     for(u32 i = 0; i != GPU_MAX_SWAPCHAIN_IMAGES; i++) {
-        if(vkCreateSemaphore(device, &semaphore_info, NULL, &semaphores_images_finished[i]) != VK_SUCCESS) {
+        if(vkCreateSemaphore(device, &semaphore_info, vulkan_device->allocator, &semaphores_images_finished[i]) != VK_SUCCESS) {
             LOG_ERROR("failed to create image finished semaphore id: %u/%u", i, GPU_MAX_SWAPCHAIN_IMAGES);
             goto fail;
         }
     }
 
+    /* gpu frame time, top and bottom of every frame slot */
+    if(vulkan_device->adapter->timestamp_period != 0.0f) {
+        const VkQueryPoolCreateInfo query_pool_info = {
+            .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2 * frames_count
+        };
+        if(vkCreateQueryPool(device, &query_pool_info, vulkan_device->allocator, &vulkan_render->query_pool_timestamps) != VK_SUCCESS) {
+            LOG_ERROR("failed to create timestamp query pool");
+            goto fail;
+        }
+    }
+
+    if(!upload_init(vulkan_device, &gpu_ctx->vulkan_upload)) {
+        LOG_ERROR("failed to init background uploads");
+        goto fail;
+    }
+    gpu_ctx->vulkan_readback = (VulkanReadback){0};
+
     return TRUE;
 
     fail: {
@@ -72,26 +603,150 @@ void gpu_render_terminate(
     const VkDevice      device        = vulkan_device->device;
     VulkanRender*       vulkan_render = &gpu_ctx->vulkan_render;
 
-    /* wait on pending operations */
+    /* wait on pending operations, presentation is not covered by the timelines */
     vkDeviceWaitIdle(device);
 
-    /* semaphores and fences */
+    upload_terminate(vulkan_device, &gpu_ctx->vulkan_upload);
+
+    if(vulkan_render->query_pool_timestamps != NULL) {
+        vkDestroyQueryPool(device, vulkan_render->query_pool_timestamps, vulkan_device->allocator);
+    }
+
+    /* semaphores */
+    vkDestroySemaphore(device, vulkan_render->semaphore_frame_timeline, vulkan_device->allocator);
+    vkDestroySemaphore(device, vulkan_render->semaphore_compute_timeline, vulkan_device->allocator);
+
     const VkSemaphore* semaphores_images_finished = vulkan_render->semaphores_images_finished;
 
     for(u32 i = 0; i != GPU_MAX_SWAPCHAIN_IMAGES; i++) {
-        vkDestroySemaphore(device, semaphores_images_finished[i], NULL);
+        vkDestroySemaphore(device, semaphores_images_finished[i], vulkan_device->allocator);
+    }
+
+    /* per frame objects */
+    for(u32 i = 0; i != vulkan_render->frames_count; i++) {
+        GpuFrame* frame = &vulkan_render->frames[i];
+
+        const VkCommandBuffer command_buffers_render[3] = {
+            frame->command_buffer_render,
+            frame->command_buffer_render_overlap,
+            frame->command_buffer_render_join
+        };
+
+        vkDestroySemaphore(device, frame->semaphore_image_available, vulkan_device->allocator);
+        vkFreeCommandBuffers(device, vulkan_device->command_pool_render, 3, command_buffers_render);
+
+        /* frees secondary command buffers too */
+        for(u32 j = 0; j != GPU_MAX_RECORD_THREADS; j++) {
+            vkDestroyCommandPool(device, frame->thread_commands[j].command_pool, vulkan_device->allocator);
+        }
+
+        if(vulkan_device->queue_compute != NULL) {
+            vkFreeCommandBuffers(device, vulkan_device->command_pool_compute, 1, &frame->command_buffer_compute);
+        }
     }
-    vkDestroySemaphore(device, vulkan_render->semaphore_image_available, NULL);
-    vkDestroyFence(device, vulkan_render->fence_frame, NULL);
 
-    /* command buffers */
-    vkFreeCommandBuffers(device, vulkan_device->command_pool_render, 1, &vulkan_render->command_buffer_render);
+    /* baked frames, only the used ones were allocated */
+    for(u32 i = 0; i != GPU_MAX_SWAPCHAIN_IMAGES * vulkan_render->frames_count; i++) {
+        if(vulkan_render->bakes[i] != NULL) {
+            vkFreeCommandBuffers(device, vulkan_device->command_pool_render, 1, &vulkan_render->bakes[i]->command_buffer);
+        }
+    }
+    arena_reset(&gpu_ctx->arena_bakes, 0);
 
     *vulkan_render = (VulkanRender){0};
 
     fail: {}
 }
 
+/* recording of a frame starts, the previous one being still on the gpu means they overlap */
+void overlap_record_begin(
+    CtxHandle ctx
+) {
+    GpuContext*      gpu_ctx       = (GpuContext*)ctx;
+    VulkanRender*    vulkan_render = &gpu_ctx->vulkan_render;
+    GpuOverlapStats* stats         = &vulkan_render->overlap_stats;
+
+    LARGE_INTEGER performance_counter = (LARGE_INTEGER){0};
+    QueryPerformanceCounter(&performance_counter);
+    stats->record_begin = performance_counter.QuadPart;
+
+    if(gpu_render_frame_completed(ctx) < vulkan_render->frame_submitted) {
+        stats->busy_begin_frames++;
+    }
+}
+
+/* right before submit, averages are logged and checked every GPU_OVERLAP_CHECK_FRAMES frames */
+/* FALSE = gpu bound frames never overlapped, frames in flight are not pipelined */
+b32 overlap_record_end(
+    CtxHandle ctx
+) {
+    GpuContext*      gpu_ctx       = (GpuContext*)ctx;
+    VulkanRender*    vulkan_render = &gpu_ctx->vulkan_render;
+    GpuOverlapStats* stats         = &vulkan_render->overlap_stats;
+
+    LARGE_INTEGER performance_counter = (LARGE_INTEGER){0};
+    QueryPerformanceCounter(&performance_counter);
+
+    if(gpu_render_frame_completed(ctx) < vulkan_render->frame_submitted) {
+        stats->busy_submit_frames++;
+    }
+    stats->record_time += (f64)(performance_counter.QuadPart - stats->record_begin) * 1000.0 / (f64)stats->counter_frequency;
+    stats->gpu_time    += vulkan_render->gpu_frame_time;
+    stats->frames++;
+
+    if(stats->frames != GPU_OVERLAP_CHECK_FRAMES) {
+        return TRUE;
+    }
+    LOG_MESSAGE(
+        "frame overlap: cpu record %.3f ms gpu frame %.3f ms, gpu busy at record begin %u/%u at submit %u/%u",
+        stats->record_time / stats->frames, stats->gpu_time / stats->frames,
+        stats->busy_begin_frames, stats->frames, stats->busy_submit_frames, stats->frames
+    );
+
+    /* with more frames in flight and the gpu slower than recording, the previous frame is still */
+    /* executing when the next one begins, a single frame or no timestamps can't be checked */
+    const b32 gpu_bound  = vulkan_render->frames_count > 1 && stats->gpu_time > stats->record_time;
+    const b32 overlapped = stats->busy_begin_frames != 0;
+
+    const i64 counter_frequency = stats->counter_frequency;
+    *stats = (GpuOverlapStats) {
+        .counter_frequency = counter_frequency
+    };
+
+    if(gpu_bound && !overlapped) {
+        LOG_ERROR("cpu recording never overlapped gpu execution in %u gpu bound frames", GPU_OVERLAP_CHECK_FRAMES);
+        goto fail;
+    }
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* failed frames never signal their timeline value, counter and slot fall back to the last submitted frame */
+/* readbacks recorded into the failed frame are never written, they expire */
+void frame_rollback(
+    CtxHandle ctx,
+    GpuFrame* frame
+) {
+    GpuContext*     gpu_ctx         = (GpuContext*)ctx;
+    VulkanRender*   vulkan_render   = &gpu_ctx->vulkan_render;
+    VulkanReadback* vulkan_readback = &gpu_ctx->vulkan_readback;
+
+    for(u32 i = 0; i != vulkan_readback->readbacks_count; i++) {
+        GpuReadback* readback = &vulkan_readback->readbacks[(vulkan_readback->readbacks_first + i) % GPU_MAX_READBACKS];
+
+        if(readback->frame_value > vulkan_render->frame_submitted) {
+            readback->released = TRUE;
+        }
+    }
+
+    vulkan_render->frame_counter = vulkan_render->frame_submitted;
+    frame->frame_value           = vulkan_render->frame_submitted;
+}
+
 /* 0 = success
    1 = fail
    2 = window_closed */
@@ -106,13 +761,41 @@ i32 gpu_render_frame_begin(
     const VulkanShaders* vulkan_shaders   = &gpu_ctx->vulkan_shaders;
     VulkanResources*     vulkan_resources = &gpu_ctx->vulkan_resources;
     VulkanRender*        vulkan_render    = &gpu_ctx->vulkan_render;
+    VulkanUpload*        vulkan_upload    = &gpu_ctx->vulkan_upload;
 
-    /* wait for frame fence */
-    if(vkWaitForFences(vulkan_device->device, 1, &vulkan_render->fence_frame, VK_TRUE, U64_MAX) != VK_SUCCESS) {
-        LOG_ERROR("failed to wait for frame fence");
+    /* advance frames ring, only waits when the gpu is frames_count frames behind */
+    vulkan_render->frame_id = (vulkan_render->frame_id + 1) % vulkan_render->frames_count;
+    GpuFrame* frame         = &vulkan_render->frames[vulkan_render->frame_id];
+
+    /* wait for the frame that used this slot to retire */
+    if(!gpu_render_frame_wait(ctx, frame->frame_value, U64_MAX)) {
+        LOG_ERROR("failed to wait for frame: %llu", frame->frame_value);
         goto fail;
     }
-    vkResetFences(vulkan_device->device, 1, &vulkan_render->fence_frame);
+    /* destroyed resources of retired frames */
+    resources_retire(&gpu_ctx->vulkan_device, vulkan_resources, gpu_render_frame_completed(ctx));
+    /* budget is queried from the driver, so not every frame */
+    if(vulkan_render->frame_counter % GPU_MEMORY_BUDGET_POLL_FRAMES == 0 || vulkan_device->memory_pressure_pending) {
+        video_memory_poll_budget(gpu_ctx);
+    }
+    /* timestamps of the retired frame are available without waiting */
+    if(frame->timestamps_written) {
+        u64 timestamps[2] = {0};
+        if(vkGetQueryPoolResults(
+            vulkan_device->device,
+            vulkan_render->query_pool_timestamps,
+            2 * vulkan_render->frame_id,
+            2,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(u64),
+            VK_QUERY_RESULT_64_BIT
+        ) == VK_SUCCESS) {
+            const f64 ticks = (f64)(timestamps[1] - timestamps[0]);
+            vulkan_render->gpu_frame_time = (f32)(ticks * vulkan_device->adapter->timestamp_period / 1000000.0);
+        }
+        frame->timestamps_written = FALSE;
+    }
 
     reacquire: {}
 
@@ -123,7 +806,7 @@ i32 gpu_render_frame_begin(
         vulkan_device->device,
         vulkan_resources->swapchain,
         U64_MAX,
-        vulkan_render->semaphore_image_available,
+        frame->semaphore_image_available,
         NULL,
         &swapchain_image_id
     );
@@ -134,6 +817,7 @@ i32 gpu_render_frame_begin(
 
         const i32 resize_result = create_swapchain(
             vulkan_device->device,
+            vulkan_device->allocator,
             vulkan_device->adapter->physical_device,
             vulkan_objects->surface,
             vulkan_device->adapter->surface_format,
@@ -152,6 +836,11 @@ i32 gpu_render_frame_begin(
         if(resize_result == 2) {
             goto window_closed;
         }
+        if(!resize_surface_images(gpu_ctx)) {
+            LOG_ERROR("failed to resize surface relative images");
+            goto fail;
+        }
+        gpu_render_bake_invalidate(ctx);
         goto reacquire;
     }
     else if(acquire_result != VK_SUBOPTIMAL_KHR && acquire_result != VK_SUCCESS) {
@@ -159,52 +848,107 @@ i32 gpu_render_frame_begin(
         goto fail;
     }
 
+    /* counter advances only once the frame is going to be submitted, fail rolls it back */
+    vulkan_render->frame_counter++;
+    frame->frame_value = vulkan_render->frame_counter;
+
+    if(vulkan_device->frame_overlap_check) {
+        overlap_record_begin(ctx);
+    }
+
     /* load surface image info */
-    vulkan_render->swapchain_image_id   = swapchain_image_id;
-    vulkan_render->swapchain_image      = vulkan_resources->swapchain_images[swapchain_image_id];
-    vulkan_render->swapchain_image_view = vulkan_resources->swapchain_views [swapchain_image_id];
-    vulkan_render->sync_transfer_size   = 0;
+    vulkan_render->swapchain_image_id    = swapchain_image_id;
+    vulkan_render->swapchain_image       = vulkan_resources->swapchain_images[swapchain_image_id];
+    vulkan_render->swapchain_image_view  = vulkan_resources->swapchain_views [swapchain_image_id];
+    vulkan_render->command_buffer        = frame->command_buffer_render;
+    vulkan_render->upload_size           = 0;
+    vulkan_render->upload_flushed_size   = 0;
+    vulkan_render->upload_copies_count   = 0;
+
+    vulkan_render->async_compute_recording = FALSE;
+    vulkan_render->async_compute_submitted = FALSE;
+    vulkan_render->async_compute_joined    = FALSE;
+    vulkan_render->async_images_count      = 0;
+    vulkan_render->async_buffers_count     = 0;
+    vulkan_render->passes_recording        = FALSE;
+    vulkan_render->passes_count            = 0;
+    vulkan_render->latch_func              = NULL;
+    vulkan_render->latch_user_data         = NULL;
+    vulkan_render->bake                    = NULL;
+    vulkan_render->bake_recording          = FALSE;
+    vulkan_render->barrier_stats           = (BarrierStats){0};
+
+    memset((void*)vulkan_render->uniforms_allocated, 0, sizeof(vulkan_render->uniforms_allocated));
+
+    /* late latch buffers are read from this frame slot */
+    for(u32 i = 0; i != vulkan_shaders->dynamic_bindings_count; i++) {
+        const u32 buffer_id = vulkan_shaders->dynamic_buffer_ids[i];
+
+        vulkan_render->dynamic_offsets[i] = buffer_id < vulkan_resources->buffers_count ?
+            (u32)(vulkan_resources->buffers[buffer_id].frame_stride * vulkan_render->frame_id) : 0;
+    }
+
+    /* secondary command buffers of the retired frame */
+    for(u32 i = 0; i != GPU_MAX_RECORD_THREADS; i++) {
+        vkResetCommandPool(vulkan_device->device, frame->thread_commands[i].command_pool, 0);
+        frame->thread_commands[i].command_buffers_used = 0;
+    }
 
     /* start command buffer recording */
-    const VkCommandBufferBeginInfo command_buffer_render_begin_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
-    };
-    if(vkResetCommandBuffer(vulkan_render->command_buffer_render, 0) != VK_SUCCESS) {
-        LOG_ERROR("failed to reset render command buffer");
-        goto fail;
-    }
-    if(vkBeginCommandBuffer(vulkan_render->command_buffer_render, &command_buffer_render_begin_info) != VK_SUCCESS) {
+    if(!begin_command_buffer(vulkan_shaders, vulkan_render->dynamic_offsets, vulkan_render->command_buffer, TRUE)) {
         LOG_ERROR("failed to begin render command buffer");
         goto fail;
     }
+    if(vulkan_render->query_pool_timestamps != NULL) {
+        vkCmdResetQueryPool(vulkan_render->command_buffer, vulkan_render->query_pool_timestamps, 2 * vulkan_render->frame_id, 2);
+        vkCmdWriteTimestamp(
+            vulkan_render->command_buffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            vulkan_render->query_pool_timestamps,
+            2 * vulkan_render->frame_id
+        );
+    }
 
     GpuImageState*  image_states        = vulkan_render->image_states;
     GpuBufferState* buffer_states       = vulkan_render->buffer_states;
     const u32       image_states_count  = vulkan_resources->images_count;
     const u32       buffer_states_count = vulkan_resources->buffers_count;
+    /* previous frames may still be in flight, states carry over so the first barrier */
+    /* of every resource waits only on the stages that last touched it */
+    /* reads need no memory dependency, pending writes are kept */
     for(u32 i = 0; i != image_states_count; i++) {
+        if(vulkan_render->images_persistent[i]) {
+            continue;
+        }
         image_states[i] = (GpuImageState) {
-            .access = VK_ACCESS_NONE,
+            .access = image_states[i].access & GPU_ACCESS_WRITE_MASK,
             .layout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .stage  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+            .stage  = image_states[i].stage
         };
     }
     for(u32 i = 0; i != buffer_states_count; i++) {
         buffer_states[i] = (GpuBufferState) {
-            .access = VK_ACCESS_NONE,
-            .stage  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+            .access = buffer_states[i].access & GPU_ACCESS_WRITE_MASK,
+            .stage  = buffer_states[i].stage
         };
     }
 
-    /* surface top barrier */
-    const VkImageMemoryBarrier surface_memory_barrier = {
-        .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .srcAccessMask    = VK_ACCESS_NONE,
-        .dstAccessMask    = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        .oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED,
-        .newLayout        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        .image            = vulkan_render->swapchain_image,
-        .subresourceRange = (VkImageSubresourceRange) {
+    /* background uploads finished since the last frame */
+    upload_acquire(vulkan_device, vulkan_resources, vulkan_upload, vulkan_render);
+
+    /* surface top barrier, chained to the image available wait at color output */
+    const VkImageMemoryBarrier2 surface_memory_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .srcAccessMask       = VK_ACCESS_2_NONE,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .dstAccessMask       = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout           = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image               = vulkan_render->swapchain_image,
+        .subresourceRange    = (VkImageSubresourceRange) {
             .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
             .baseMipLevel   = 0,
             .levelCount     = 1,
@@ -212,39 +956,10 @@ i32 gpu_render_frame_begin(
             .layerCount     = 1
         }
     };
-    vkCmdPipelineBarrier(
-        vulkan_render->command_buffer_render, 
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        0,
-        0,
-        NULL,
-        0,
-        NULL,
-        1,
-        &surface_memory_barrier
-    );
-
-    vkCmdBindDescriptorSets(
-        vulkan_render->command_buffer_render, 
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        vulkan_shaders->pipeline_layout,
-        0,
-        GPU_DESCRIPTOR_SET_COUNT,
-        vulkan_shaders->descriptor_sets,
-        0,
-        NULL
-    );
-    vkCmdBindDescriptorSets(
-        vulkan_render->command_buffer_render, 
-        VK_PIPELINE_BIND_POINT_COMPUTE,
-        vulkan_shaders->pipeline_layout,
-        0,
-        GPU_DESCRIPTOR_SET_COUNT,
-        vulkan_shaders->descriptor_sets,
-        0,
-        NULL
-    );
+    GpuBarrierBatch surface_batch;
+    barrier_batch_reset(&surface_batch);
+    barrier_batch_add_image(&surface_batch, &vulkan_render->barrier_stats, &surface_memory_barrier);
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &surface_batch);
 
     /* screen info */
     *screen_x = vulkan_resources->swapchain_x;
@@ -253,6 +968,7 @@ i32 gpu_render_frame_begin(
     return 0;
 
     fail: {
+        frame_rollback(ctx, frame);
         return 1;
     }
     
@@ -265,6 +981,25 @@ i32 gpu_render_frame_begin(
    1 = fail
    2 = window_closed */
 /* FIX: refactor flushing */
+/* newest data for late latch buffers, runs once right before the first submit reading them */
+/* that is end_async_compute when the render part is submitted early, frame_end otherwise */
+void run_latch(
+    CtxHandle ctx
+) {
+    GpuContext*   gpu_ctx       = (GpuContext*)ctx;
+    VulkanRender* vulkan_render = &gpu_ctx->vulkan_render;
+
+    if(vulkan_render->latch_func == NULL) {
+        return;
+    }
+    vulkan_render->latching = TRUE;
+    vulkan_render->latch_func(ctx, vulkan_render->latch_user_data);
+    vulkan_render->latching = FALSE;
+
+    vulkan_render->latch_func      = NULL;
+    vulkan_render->latch_user_data = NULL;
+}
+
 i32 gpu_render_frame_end(
     CtxHandle ctx
 ) {
@@ -273,71 +1008,131 @@ i32 gpu_render_frame_end(
     const VulkanDevice*  vulkan_device    = &gpu_ctx->vulkan_device;
     VulkanResources*     vulkan_resources = &gpu_ctx->vulkan_resources;
     VulkanRender*        vulkan_render    = &gpu_ctx->vulkan_render;
+    VulkanUpload*        vulkan_upload    = &gpu_ctx->vulkan_upload;
+    GpuFrame*            frame            = &vulkan_render->frames[vulkan_render->frame_id];
 
     const u32 swapchain_image_id = vulkan_render->swapchain_image_id;
 
-    /* surface bottom barrier */
-    const VkImageMemoryBarrier surface_memory_barrier = {
-        .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .srcAccessMask    = VK_ACCESS_NONE,
-        .dstAccessMask    = VK_ACCESS_NONE,
-        .oldLayout        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        .newLayout        = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-        .image            = vulkan_render->swapchain_image,
-        .subresourceRange = (VkImageSubresourceRange) {
-            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    if(vulkan_render->async_compute_recording) {
+        LOG_ERROR("async compute was not ended");
+        goto fail;
+    }
+    if(vulkan_render->passes_recording) {
+        LOG_ERROR("parallel passes were not ended");
+        goto fail;
+    }
+    if(vulkan_render->bake_recording) {
+        LOG_ERROR("bake was not ended");
+        goto fail;
+    }
+    /* compute results have to be back on the render queue before present */
+    gpu_render_wait_async_compute(ctx);
+
+    /* uploads nobody consumed this frame */
+    flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+
+    /* surface bottom barrier, present waits on the submit semaphore */
+    const VkImageMemoryBarrier2 surface_memory_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .srcAccessMask       = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask       = VK_ACCESS_2_NONE,
+        .oldLayout           = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .newLayout           = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image               = vulkan_render->swapchain_image,
+        .subresourceRange    = (VkImageSubresourceRange) {
+            .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
             .baseMipLevel   = 0,
             .levelCount     = 1,
             .baseArrayLayer = 0,
             .layerCount     = 1
         }
     };
-    vkCmdPipelineBarrier(
-        vulkan_render->command_buffer_render, 
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
-        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-        0,
-        0,
-        NULL,
-        0,
-        NULL,
-        1,
-        &surface_memory_barrier
-    );
+    GpuBarrierBatch surface_batch;
+    barrier_batch_reset(&surface_batch);
+    barrier_batch_add_image(&surface_batch, &vulkan_render->barrier_stats, &surface_memory_barrier);
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &surface_batch);
+
+    vulkan_render->barrier_stats_last = vulkan_render->barrier_stats;
+
+    /* bottom timestamp goes to the last submission of the frame, join after async compute */
+    if(vulkan_render->query_pool_timestamps != NULL) {
+        vkCmdWriteTimestamp(
+            vulkan_render->command_buffer,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            vulkan_render->query_pool_timestamps,
+            2 * vulkan_render->frame_id + 1
+        );
+        frame->timestamps_written = TRUE;
+    }
 
     /* end command buffer recording */
-    if(vkEndCommandBuffer(vulkan_render->command_buffer_render) != VK_SUCCESS) {
+    if(vkEndCommandBuffer(vulkan_render->command_buffer) != VK_SUCCESS) {
         LOG_ERROR("failed to end render command buffer");
         goto fail;
     }
-    
-    /* FIX: flush memory if perform transfer */
-    /* in if condition and flush range are different memory */
-    if(
-        vulkan_device->video_memory_device_buffers.memory_map == NULL && 
-        vulkan_render->sync_transfer_size                     != 0
-    ) {
-        const VkMappedMemoryRange flush_range = {
-            .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-            .offset = (vulkan_resources->buffer_sync_transfer.allocation_offset) & 0xFFFFFFFFFFFFFF00,
-            .size   = (vulkan_render->sync_transfer_size + 0xFF)                 & 0xFFFFFFFFFFFFFF00,
-            .memory = vulkan_device->video_memory_host_transfer.device_memory
-        };
 
-        vkFlushMappedMemoryRanges(vulkan_device->device, 1, &flush_range);
+    /* nothing can be recorded anymore */
+    run_latch(ctx);
+    flush_host_writes(vulkan_device, vulkan_resources, vulkan_render);
+
+    if(vulkan_device->frame_overlap_check && !overlap_record_end(ctx)) {
+        goto fail;
     }
 
-    /* submit and present frame */
-    const VkPipelineStageFlags wait_stages              = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    const VkSubmitInfo         submit_render_queue_info = {
+    /* submit and present frame, acquired uploads are already signaled */
+    const VkSemaphore                   wait_semaphores[2]       = {frame->semaphore_image_available, vulkan_upload->semaphore_timeline};
+    const VkPipelineStageFlags          wait_stages[2]           = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+    const u64                           wait_values[2]           = {0, vulkan_upload->token_acquired};
+    const VkSemaphore                   signal_semaphores[2]     = {vulkan_render->semaphores_images_finished[swapchain_image_id], vulkan_render->semaphore_frame_timeline};
+    const u64                           signal_values[2]         = {0, frame->frame_value};
+    const VkTimelineSemaphoreSubmitInfo wait_values_info         = {
+        .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount   = 2,
+        .pWaitSemaphoreValues      = wait_values,
+        .signalSemaphoreValueCount = 2,
+        .pSignalSemaphoreValues    = signal_values
+    };
+    const VkSubmitInfo                  submit_render_queue_info = {
         .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                = &wait_values_info,
         .commandBufferCount   = 1,
-        .pCommandBuffers      = &vulkan_render->command_buffer_render,
-        .waitSemaphoreCount   = 1,
-        .pWaitSemaphores      = &vulkan_render->semaphore_image_available,
-        .pWaitDstStageMask    = &wait_stages,
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores    = &vulkan_render->semaphores_images_finished[swapchain_image_id]
+        .pCommandBuffers      = &frame->command_buffer_render,
+        .waitSemaphoreCount   = 2,
+        .pWaitSemaphores      = wait_semaphores,
+        .pWaitDstStageMask    = wait_stages,
+        .signalSemaphoreCount = 2,
+        .pSignalSemaphores    = signal_semaphores
+    };
+    /* render part was submitted by end_async_compute */
+    const VkPipelineStageFlags          wait_compute_stages         = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    const VkTimelineSemaphoreSubmitInfo join_values_info            = {
+        .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount   = 1,
+        .pWaitSemaphoreValues      = &vulkan_render->compute_counter,
+        .signalSemaphoreValueCount = 2,
+        .pSignalSemaphoreValues    = signal_values
+    };
+    const VkSubmitInfo                  submit_async_queue_infos[2] = {
+        (VkSubmitInfo) {
+            .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount   = 1,
+            .pCommandBuffers      = &frame->command_buffer_render_overlap
+        },
+        (VkSubmitInfo) {
+            .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext                = &join_values_info,
+            .commandBufferCount   = 1,
+            .pCommandBuffers      = &frame->command_buffer_render_join,
+            .waitSemaphoreCount   = 1,
+            .pWaitSemaphores      = &vulkan_render->semaphore_compute_timeline,
+            .pWaitDstStageMask    = &wait_compute_stages,
+            .signalSemaphoreCount = 2,
+            .pSignalSemaphores    = signal_semaphores
+        }
     };
     const VkPresentInfoKHR present_swapchain_image_info = {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -348,8 +1143,22 @@ i32 gpu_render_frame_end(
         .pWaitSemaphores    = &vulkan_render->semaphores_images_finished[swapchain_image_id]
     };
 
-    if(vkQueueSubmit(vulkan_device->queue_render, 1, &submit_render_queue_info, vulkan_render->fence_frame) != VK_SUCCESS) {
-        LOG_ERROR("failed to submit frame to render queue");
+    if(vulkan_render->async_compute_submitted) {
+        if(vkQueueSubmit(vulkan_device->queue_render, 2, submit_async_queue_infos, NULL) != VK_SUCCESS) {
+            LOG_ERROR("failed to submit frame to render queue");
+            goto fail;
+        }
+    }
+    else {
+        if(vkQueueSubmit(vulkan_device->queue_render, 1, &submit_render_queue_info, NULL) != VK_SUCCESS) {
+            LOG_ERROR("failed to submit frame to render queue");
+            goto fail;
+        }
+    }
+    vulkan_render->frame_submitted = frame->frame_value;
+
+    /* uploads recorded during the frame, their copies wait for it to retire */
+    if(!upload_submit_deferred(vulkan_device, vulkan_render, vulkan_upload, frame->frame_value)) {
         goto fail;
     }
 
@@ -363,6 +1172,7 @@ i32 gpu_render_frame_end(
 
         const i32 resize_result = create_swapchain(
             vulkan_device->device,
+            vulkan_device->allocator,
             vulkan_device->adapter->physical_device,
             vulkan_objects->surface,
             vulkan_device->adapter->surface_format,
@@ -382,6 +1192,11 @@ i32 gpu_render_frame_end(
         if(resize_result == 2) {
             goto window_closed;
         }
+        if(!resize_surface_images(gpu_ctx)) {
+            LOG_ERROR("failed to resize surface relative images");
+            goto fail;
+        }
+        gpu_render_bake_invalidate(ctx);
     }
     else if(present_result != VK_SUCCESS) {
         LOG_ERROR("failed to present frame");
@@ -390,7 +1205,9 @@ i32 gpu_render_frame_end(
     
     return 0;
 
+    /* no-op once the frame was submitted */
     fail: {
+        frame_rollback(ctx, frame);
         return 1;
     }
 
@@ -399,25 +1216,91 @@ i32 gpu_render_frame_end(
     }
 }
 
-/* GRAPHICS */
+/* value of the frame being recorded, last submitted one outside of frame_begin/frame_end */
+u64 gpu_render_frame_counter(
+    CtxHandle ctx
+) {
+    const GpuContext* gpu_ctx = (const GpuContext*)ctx;
 
-void gpu_render_begin_drawing(
-    CtxHandle          ctx,
-    const DrawingInfo* drawing_info
+    return gpu_ctx->vulkan_render.frame_counter;
+}
+
+u64 gpu_render_frame_completed(
+    CtxHandle ctx
 ) {
-    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
-    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
-    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
-    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+    const GpuContext* gpu_ctx = (const GpuContext*)ctx;
+
+    u64 frame_completed = 0;
+    if(vkGetSemaphoreCounterValue(gpu_ctx->vulkan_device.device, gpu_ctx->vulkan_render.semaphore_frame_timeline, &frame_completed) != VK_SUCCESS) {
+        LOG_ERROR("failed to get frame timeline value");
+        goto fail;
+    }
+
+    return frame_completed;
+
+    fail: {
+        return 0;
+    }
+}
+
+f32 gpu_render_frame_gpu_time(
+    CtxHandle ctx
+) {
+    const GpuContext* gpu_ctx = (const GpuContext*)ctx;
+
+    return gpu_ctx->vulkan_render.gpu_frame_time;
+}
+
+/* FALSE on timeout or error */
+b32 gpu_render_frame_wait(
+    CtxHandle ctx,
+    u64       frame_value,
+    u64       timeout
+) {
+    const GpuContext* gpu_ctx = (const GpuContext*)ctx;
+
+    const VkSemaphoreWaitInfo wait_info = {
+        .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores    = &gpu_ctx->vulkan_render.semaphore_frame_timeline,
+        .pValues        = &frame_value
+    };
+
+    return vkWaitSemaphores(gpu_ctx->vulkan_device.device, &wait_info, timeout) == VK_SUCCESS;
+}
+
+void gpu_render_barrier_stats(
+    CtxHandle     ctx,
+    BarrierStats* stats
+) {
+    const GpuContext* gpu_ctx = (const GpuContext*)ctx;
+
+    *stats = gpu_ctx->vulkan_render.barrier_stats_last;
+}
+
+/* GRAPHICS */
 
+/* validates drawing info, generates barriers and attachments, updates resource states */
+b32 prepare_drawing_pass(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanRender*          vulkan_render,
+    const DrawingInfo*     drawing_info,
+    GpuPass*               pass
+) {
     /* resources */
-    const GpuBuffer* gpu_buffers       = vulkan_resources->buffers;
-    const GpuImage*  gpu_images        = vulkan_resources->images;
-    const u32        gpu_buffers_count = vulkan_resources->buffers_count;
-    const u32        gpu_images_count  = vulkan_resources->images_count;
+    const GpuBuffer* gpu_buffers = vulkan_resources->buffers;
+    const GpuImage*  gpu_images  = vulkan_resources->images;
 
     GpuImageState*  image_states  = vulkan_render->image_states;
     GpuBufferState* buffer_states = vulkan_render->buffer_states;
+
+    BarrierStats* stats = &vulkan_render->barrier_stats;
+
+    barrier_batch_reset(&pass->barriers);
+    pass->command_buffer = NULL;
+    pass->recording      = FALSE;
+    pass->failed         = FALSE;
     
     /* read images & read buffers barriers */ {
     const u32* read_images_ids    = drawing_info->images_read;
@@ -426,110 +1309,52 @@ void gpu_render_begin_drawing(
     const u32  read_buffers_count = drawing_info->buffers_read_count;
 
     for(u32 i = 0; i != read_images_count; i++) {
-        const u32 read_image_id = read_images_ids[i];
+        const u32 read_image_id = resources_image_slot(vulkan_resources, read_images_ids[i]);
 
-        if(read_image_id >= gpu_images_count) {
-            LOG_ERROR("invalid read image id: %u/%u", read_image_id, gpu_images_count);
+        if(read_image_id == U32_MAX) {
+            LOG_ERROR("invalid read image id: %u", read_images_ids[i]);
             goto fail;
         }
 
-        /* gnerated read image barrier */
-        const VkAccessFlags        src_access = image_states[read_image_id].access;
-        const VkImageLayout        src_layout = image_states[read_image_id].layout;
-        const VkPipelineStageFlags src_stage  = image_states[read_image_id].stage;
-            
-        const VkAccessFlags        dst_access = VK_ACCESS_SHADER_READ_BIT;
-        const VkImageLayout        dst_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
-        
-        const GpuImage*          image  = &gpu_images[read_image_id];
-
-        const VkImageMemoryBarrier read_image_barrier = {
-            .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .image            = image->image,
-            .srcAccessMask    = src_access,
-            .oldLayout        = src_layout,
-            .dstAccessMask    = dst_access,
-            .newLayout        = dst_layout,
-            .subresourceRange = (VkImageSubresourceRange) {
-                .aspectMask     = image->aspect,
-                .baseArrayLayer = 0,
-                .layerCount     = 1,
-                .baseMipLevel   = 0,
-                .levelCount     = 1
-            }
-        };
-
-        vkCmdPipelineBarrier(
-            vulkan_render->command_buffer_render, 
-            src_stage,
-            dst_stage,
-            0,
-            0,
-            NULL,
-            0,
-            NULL,
-            1,
-            &read_image_barrier
+        /* read image barrier, skipped when already readable */
+        barrier_batch_transit_image(
+            &pass->barriers,
+            stats,
+            &gpu_images[read_image_id],
+            &image_states[read_image_id],
+            VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT
         );
-
-        image_states[read_image_id] = (GpuImageState) {
-            .access = dst_access,
-            .layout = dst_layout,
-            .stage  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
-        };
     }
 
     for(u32 i = 0; i != read_buffers_count; i++) {
-        const u32 read_buffer_id = read_buffers_ids[i];
+        const u32 read_buffer_id = resources_buffer_slot(vulkan_resources, read_buffers_ids[i]);
 
-        if(read_buffer_id >= gpu_buffers_count) {
-            LOG_ERROR("invalid read buffer id: %u/%u", read_buffer_id, gpu_buffers_count);
+        if(read_buffer_id == U32_MAX) {
+            LOG_ERROR("invalid read buffer id: %u", read_buffers_ids[i]);
             goto fail;
         }
 
-        /* generate read buffer barrier */
-        const VkAccessFlags        src_access = buffer_states[read_buffer_id].access;
-        const VkPipelineStageFlags src_stage  = buffer_states[read_buffer_id].stage;
-
-        const VkAccessFlags        dst_access = VK_ACCESS_SHADER_READ_BIT;
-        const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
-
-        const VkBufferMemoryBarrier read_buffer_barrier = {
-            .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-            .srcAccessMask = src_access,
-            .dstAccessMask = dst_access,
-            .buffer        = gpu_buffers[read_buffer_id].buffer,
-            .size          = gpu_buffers[read_buffer_id].used_size,
-            .offset        = 0
-        };
-
-        vkCmdPipelineBarrier(
-            vulkan_render->command_buffer_render, 
-            src_stage,
-            dst_stage,
-            0,
-            0,
-            NULL,
-            1,
-            &read_buffer_barrier,
-            0,
-            NULL
+        /* read buffer barrier, skipped when already readable */
+        barrier_batch_transit_buffer(
+            &pass->barriers,
+            stats,
+            &gpu_buffers[read_buffer_id],
+            &buffer_states[read_buffer_id],
+            VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+            VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT
         );
-
-        buffer_states[read_buffer_id] = (GpuBufferState) {
-            .access = dst_access,
-            .stage  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
-        };
     }
     }
 
     /* generate attachments */
-    VkRenderingAttachmentInfo rendering_color_attachments[GPU_MAX_COLOR_ATTACHMENTS] = {0};
-    VkRenderingAttachmentInfo rendering_depth_attachment                             = (VkRenderingAttachmentInfo){0};
+    VkRenderingAttachmentInfo* rendering_color_attachments = pass->color_attachments;
+    VkRenderingAttachmentInfo* rendering_depth_attachment  = &pass->depth_attachment;
 
     const u32* color_attachments_ids   = drawing_info->attachments_color;
-    const u32  depth_attachment_id     = drawing_info->attachment_depth;
+    const u32  depth_attachment_id     = (drawing_info->attachment_depth == U32_MAX) ?
+        U32_MAX : resources_image_slot(vulkan_resources, drawing_info->attachment_depth);
     const u32  color_attachments_count = drawing_info->attachments_color_count; 
 
     if(color_attachments_count > GPU_MAX_COLOR_ATTACHMENTS) {
@@ -540,7 +1365,8 @@ void gpu_render_begin_drawing(
     /* color attachment */
     for(u32 i = 0; i != color_attachments_count; i++) {
 
-        const u32 color_attachment_id = color_attachments_ids[i];
+        const u32 color_attachment_id = (color_attachments_ids[i] == GPU_IMAGE_SURFACE_ID) ?
+            GPU_IMAGE_SURFACE_ID : resources_image_slot(vulkan_resources, color_attachments_ids[i]);
         /* swapchain image target */
         if(color_attachment_id == GPU_IMAGE_SURFACE_ID) {
             rendering_color_attachments[i] = (VkRenderingAttachmentInfo) {
@@ -553,53 +1379,27 @@ void gpu_render_begin_drawing(
                     .color = (VkClearColorValue){.float32 = {0.0, 0.0, 0.0, 0.0}}
                 }
             };
+            pass->color_formats[i] = vulkan_device->adapter->surface_format;
         }
         /* resource image target */
-        else if(color_attachment_id < gpu_images_count) {
-            /* transit image */
-            const VkAccessFlags        src_access = image_states[color_attachment_id].access;
-            const VkImageLayout        src_layout = image_states[color_attachment_id].layout;
-            const VkPipelineStageFlags src_stage  = image_states[color_attachment_id].stage;
-            
-            const VkAccessFlags        dst_access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            const VkImageLayout        dst_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-            const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;            
-
-            const VkImageMemoryBarrier color_attachment_barrier = {
-                .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .image            = gpu_images[color_attachment_id].image,
-                .srcAccessMask    = src_access,
-                .oldLayout        = src_layout,
-                .dstAccessMask    = dst_access,
-                .newLayout        = dst_layout,
-                .subresourceRange = (VkImageSubresourceRange) {
-                    .aspectMask     = gpu_images[color_attachment_id].aspect,
-                    .baseArrayLayer = 0,
-                    .layerCount     = 1,
-                    .baseMipLevel   = 0,
-                    .levelCount     = 1
-                }
-            };
+        else if(color_attachment_id != U32_MAX) {
+            /* transit image, cleared contents are discarded */
+            const VkImageLayout dst_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-            vkCmdPipelineBarrier(
-                vulkan_render->command_buffer_render, 
-                src_stage,
-                dst_stage,
-                0,
-                0,
-                NULL,
-                0,
-                NULL,
-                1,
-                &color_attachment_barrier
+            if(!drawing_info->do_not_clear) {
+                image_states[color_attachment_id].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+            alias_image_state(vulkan_resources, vulkan_render, color_attachment_id);
+            barrier_batch_transit_image(
+                &pass->barriers,
+                stats,
+                &gpu_images[color_attachment_id],
+                &image_states[color_attachment_id],
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | (drawing_info->do_not_clear ? VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT : VK_ACCESS_2_NONE),
+                dst_layout,
+                VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT
             );
 
-            image_states[color_attachment_id] = (GpuImageState) {
-                .access = dst_access,
-                .layout = dst_layout,
-                .stage  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-            };
-
             /* fill render attachment */
             rendering_color_attachments[i] = (VkRenderingAttachmentInfo) {
                 .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
@@ -611,64 +1411,41 @@ void gpu_render_begin_drawing(
                     .color = (VkClearColorValue){.float32 = {0.0, 0.0, 0.0, 0.0}}
                 }
             };
+            pass->color_formats[i] = gpu_images[color_attachment_id].format;
         }
         /* invalid */
         else {
-            LOG_ERROR("invalid color attachment image id: %u/%u", color_attachment_id, gpu_images_count);
+            LOG_ERROR("invalid color attachment image id: %u", color_attachments_ids[i]);
             goto fail;
         }
     }
+    pass->color_attachments_count = color_attachments_count;
 
     /* depth attachemnt */
-    if(depth_attachment_id != U32_MAX) {
+    pass->depth_format = VK_FORMAT_UNDEFINED;
+
+    if(drawing_info->attachment_depth != U32_MAX) {
         /* resource image */
-        if(depth_attachment_id < gpu_images_count) {
-            /* transit image */
-            const VkAccessFlags        src_access = image_states[depth_attachment_id].access;
-            const VkImageLayout        src_layout = image_states[depth_attachment_id].layout;
-            const VkPipelineStageFlags src_stage  = image_states[depth_attachment_id].stage;
-
-            const VkAccessFlags        dst_access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            const VkImageLayout        dst_layout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
-            const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-
-            const VkImageMemoryBarrier depth_attachment_barrier = {
-                .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .image            = gpu_images[depth_attachment_id].image,
-                .srcAccessMask    = src_access,
-                .oldLayout        = src_layout,
-                .dstAccessMask    = dst_access,
-                .newLayout        = dst_layout,
-                .subresourceRange = (VkImageSubresourceRange) {
-                    .aspectMask     = gpu_images[depth_attachment_id].aspect,
-                    .baseArrayLayer = 0,
-                    .layerCount     = 1,
-                    .baseMipLevel   = 0,
-                    .levelCount     = 1
-                }
-            };
+        if(depth_attachment_id != U32_MAX) {
+            /* transit image, cleared contents are discarded */
+            const VkImageLayout dst_layout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
 
-            vkCmdPipelineBarrier(
-                vulkan_render->command_buffer_render, 
-                src_stage,
-                dst_stage,
-                0,
-                0,
-                NULL,
-                0,
-                NULL,
-                1,
-                &depth_attachment_barrier
+            if(!drawing_info->do_not_clear) {
+                image_states[depth_attachment_id].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+            alias_image_state(vulkan_resources, vulkan_render, depth_attachment_id);
+            barrier_batch_transit_image(
+                &pass->barriers,
+                stats,
+                &gpu_images[depth_attachment_id],
+                &image_states[depth_attachment_id],
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                dst_layout,
+                VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT
             );
 
-            image_states[depth_attachment_id] = (GpuImageState) {
-                .access = dst_access,
-                .layout = dst_layout,
-                .stage  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT
-            };
-
             /* fill render depth attachment */
-            rendering_depth_attachment = (VkRenderingAttachmentInfo) {
+            *rendering_depth_attachment = (VkRenderingAttachmentInfo) {
                 .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
                 .imageView   = gpu_images[depth_attachment_id].view,
                 .imageLayout = dst_layout,
@@ -678,30 +1455,17 @@ void gpu_render_begin_drawing(
                     .depthStencil = (VkClearDepthStencilValue) {.depth = drawing_info->max_depth}
                 }
             };
+            pass->depth_format = gpu_images[depth_attachment_id].format;
         }
         /* invalid */
         else {
-            LOG_ERROR("invalid depth attachment image id: %u/%u", depth_attachment_id, gpu_images_count);
+            LOG_ERROR("invalid depth attachment image id: %u", drawing_info->attachment_depth);
             goto fail;
         }
     }
 
-    /* begin rendering */
-    const VkRenderingInfoKHR rendering_info = {
-        .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO,
-        .colorAttachmentCount = color_attachments_count,
-        .pColorAttachments    = rendering_color_attachments,
-        .pDepthAttachment     = (depth_attachment_id != U32_MAX) ? &rendering_depth_attachment : NULL,
-        .layerCount           = 1,
-        .renderArea           = (VkRect2D) {
-            .offset = {drawing_info->offset_x, drawing_info->offset_y},
-            .extent = {drawing_info->size_x  , drawing_info->size_y  }
-        }
-    };
-    vulkan_device->cmd_begin_rendering_khr(vulkan_render->command_buffer_render, &rendering_info);
-
-    /* set dynamic states */
-    const VkViewport viewport = {
+    /* dynamic states */
+    pass->viewport = (VkViewport) {
         .x        = (f32)drawing_info->offset_x,
         .y        = (f32)drawing_info->offset_y,
         .width    = (f32)drawing_info->size_x,
@@ -709,13 +1473,67 @@ void gpu_render_begin_drawing(
         .minDepth = drawing_info->min_depth,
         .maxDepth = drawing_info->max_depth
     };
-    const VkRect2D scissor = {
+    pass->render_area = (VkRect2D) {
         .offset = {drawing_info->offset_x, drawing_info->offset_y},
         .extent = {drawing_info->size_x  , drawing_info->size_y  }
     };
 
-    vkCmdSetViewport(vulkan_render->command_buffer_render, 0, 1, &viewport);
-    vkCmdSetScissor(vulkan_render->command_buffer_render, 0, 1, &scissor);
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+void begin_pass_rendering(
+    const VulkanDevice* vulkan_device,
+    VkCommandBuffer     command_buffer,
+    const GpuPass*      pass,
+    VkRenderingFlags    rendering_flags
+) {
+    const VkRenderingInfoKHR rendering_info = {
+        .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .flags                = rendering_flags,
+        .colorAttachmentCount = pass->color_attachments_count,
+        .pColorAttachments    = pass->color_attachments,
+        .pDepthAttachment     = (pass->depth_format != VK_FORMAT_UNDEFINED) ? &pass->depth_attachment : NULL,
+        .layerCount           = 1,
+        .renderArea           = pass->render_area
+    };
+    vulkan_device->cmd_begin_rendering_khr(command_buffer, &rendering_info);
+}
+
+void gpu_render_begin_drawing(
+    CtxHandle          ctx,
+    const DrawingInfo* drawing_info
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+
+    if(vulkan_render->async_compute_recording && vulkan_device->queue_compute != NULL) {
+        LOG_ERROR("drawing inside async compute");
+        goto fail;
+    }
+    if(vulkan_render->passes_recording) {
+        LOG_ERROR("drawing inside parallel passes");
+        goto fail;
+    }
+
+    /* copies can't be recorded inside rendering */
+    flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+
+    GpuPass pass;
+    if(!prepare_drawing_pass(vulkan_device, vulkan_resources, vulkan_render, drawing_info, &pass)) {
+        goto fail;
+    }
+
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &pass.barriers);
+    begin_pass_rendering(vulkan_device, vulkan_render->command_buffer, &pass, 0);
+
+    vkCmdSetViewport(vulkan_render->command_buffer, 0, 1, &pass.viewport);
+    vkCmdSetScissor(vulkan_render->command_buffer, 0, 1, &pass.render_area);
 
     fail: {}
 }
@@ -727,12 +1545,13 @@ void gpu_render_end_drawing(
     const VulkanDevice* vulkan_device    = &gpu_ctx->vulkan_device;
     const VulkanRender* vulkan_render    = &gpu_ctx->vulkan_render;
     
-    vulkan_device->cmd_end_rendering_khr(vulkan_render->command_buffer_render);
+    vulkan_device->cmd_end_rendering_khr(vulkan_render->command_buffer);
 }
 
 void gpu_render_bind_graphics_pipeline(
-    CtxHandle ctx, 
-    u32       pipeline_id
+    CtxHandle  ctx, 
+    u32        pipeline_id,
+    const u32* dynamic_offsets
 ) {
     GpuContext*          gpu_ctx        = (GpuContext*)ctx;
     const VulkanShaders* vulkan_shaders = &gpu_ctx->vulkan_shaders;
@@ -744,10 +1563,17 @@ void gpu_render_bind_graphics_pipeline(
     }
 
     vkCmdBindPipeline(
-        vulkan_render->command_buffer_render, 
+        vulkan_render->command_buffer, 
         VK_PIPELINE_BIND_POINT_GRAPHICS, 
         vulkan_shaders->pipelines[pipeline_id]
     );
+    bind_dynamic_offsets(
+        vulkan_shaders,
+        vulkan_render,
+        vulkan_render->command_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        dynamic_offsets
+    );
 
     fail: {}
 }
@@ -762,7 +1588,7 @@ void gpu_render_push_constants(
     const VulkanRender*  vulkan_render  = &gpu_ctx->vulkan_render;
 
     vkCmdPushConstants(
-        vulkan_render->command_buffer_render,
+        vulkan_render->command_buffer,
         vulkan_shaders->pipeline_layout,
         VK_SHADER_STAGE_ALL,
         0,
@@ -780,7 +1606,7 @@ void gpu_render_draw(
     const VulkanRender* vulkan_render = &gpu_ctx->vulkan_render;
 
     vkCmdDraw(
-        vulkan_render->command_buffer_render,
+        vulkan_render->command_buffer,
         vertex_count,
         instance_count,
         0,
@@ -788,333 +1614,1195 @@ void gpu_render_draw(
     );
 }
 
-/* FIX: refactor */
-void gpu_render_write_buffer(
-    CtxHandle   ctx, 
-    u32         buffer_id, 
-    const void* data, 
-    u64         offset, 
-    u64         size
+/* PARALLEL DRAWING */
+
+void gpu_render_begin_passes(
+    CtxHandle ctx
 ) {
     GpuContext*            gpu_ctx          = (GpuContext*)ctx;
     const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
     const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
     VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
 
-    /* validation */
-    const GpuBuffer* buffers               = vulkan_resources->buffers;
-    const u32        buffer_count          = vulkan_resources->buffers_count;
-
-    if(buffer_id >= buffer_count) {
-        LOG_ERROR("invalid buffer id: %u/%u", buffer_id, buffer_count);
-        goto fail;
-    }
-    if(vulkan_render->sync_transfer_size + size > GPU_SYNC_TRANSFER_SIZE) {
-        LOG_ERROR("exceed sync transfer limit: %llu/%llu", vulkan_render->sync_transfer_size + size, (u64)GPU_SYNC_TRANSFER_SIZE);
+    if(vulkan_render->async_compute_recording && vulkan_device->queue_compute != NULL) {
+        LOG_ERROR("drawing inside async compute");
         goto fail;
     }
-    if(vulkan_render->buffer_states[buffer_id].access != VK_ACCESS_NONE) {
-        LOG_ERROR("invalid buffer access id: %u/%u", buffer_id, buffer_count);
+    if(vulkan_render->passes_recording) {
+        LOG_ERROR("parallel passes already began");
         goto fail;
     }
-
-    const GpuBuffer* gpu_buffer      = &buffers[buffer_id];
-    const GpuBuffer* transfer_buffer = &vulkan_resources->buffer_sync_transfer;
-
-    if(offset + size > gpu_buffer->used_size) {
-        LOG_ERROR(
-            "trying to write size bigger than buffer: (%llu+%llu)/%llu", 
-            offset, size, gpu_buffer->used_size
-        );
+    /* pass secondaries live in per frame pools and can't be replayed */
+    if(vulkan_render->bake_recording) {
+        LOG_ERROR("parallel passes inside bake");
         goto fail;
     }
 
-    /* direct copy */
-    if(vulkan_device->video_memory_device_buffers.memory_map != NULL) {
-        /* copy and flush */
-        memcpy(
-            (u8*)vulkan_device->video_memory_device_buffers.memory_map + gpu_buffer->allocation_offset + offset, 
-            data, 
-            size
-        );
-
-        const VkMappedMemoryRange flush_range = {
-            .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-            .memory = vulkan_device->video_memory_device_buffers.device_memory,
-            .offset = (gpu_buffer->allocation_offset     ) & 0xFFFFFFFFFFFFFF00,
-            .size   = (gpu_buffer->allocation_size + 0xFF) & 0xFFFFFFFFFFFFFF00
-        };
-
-        vkFlushMappedMemoryRanges(vulkan_device->device, 1, &flush_range);
-        vulkan_render->sync_transfer_size += size;
-    }
-    /* host-device transfer */
-    else {
-        /* copy data */
-        memcpy(
-            (u8*)vulkan_device->video_memory_host_transfer.memory_map + transfer_buffer->allocation_offset + vulkan_render->sync_transfer_size, 
-            data,
-            size
-        );
-
-        /* transfer */
-        const VkBufferCopy buffer_copy = {
-            .srcOffset = vulkan_render->sync_transfer_size,
-            .dstOffset = offset,
-            .size      = size
-        };
-
-        vkCmdCopyBuffer(vulkan_render->command_buffer_render, transfer_buffer->buffer, gpu_buffer->buffer, 1, &buffer_copy);
-        vulkan_render->buffer_states[buffer_id] = (GpuBufferState) {
-            .access = VK_ACCESS_TRANSFER_WRITE_BIT,
-            .stage  = VK_PIPELINE_STAGE_TRANSFER_BIT
-        };
+    /* passes barriers are recorded only at end_passes, pending copies go first */
+    flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
 
-        vulkan_render->sync_transfer_size += size;
-    }
+    vulkan_render->passes_recording = TRUE;
+    vulkan_render->passes_count     = 0;
 
     fail: {}
 }
 
-/* COMPUTE */
-
-void gpu_render_compute_barrier(
-    CtxHandle          ctx, 
-    const ComputeInfo* compute_info
+/* U32_MAX = fail */
+u32 gpu_render_declare_pass(
+    CtxHandle          ctx,
+    const DrawingInfo* drawing_info
 ) {
     GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
     const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
     VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
 
-    /* resources */
-    const GpuImage*  gpu_images        = vulkan_resources->images;
-    const GpuBuffer* gpu_buffers       = vulkan_resources->buffers;
-    const u32        gpu_images_count  = vulkan_resources->images_count;
-    const u32        gpu_buffers_count = vulkan_resources->buffers_count;
-
-    GpuImageState*  image_states  = vulkan_render->image_states;
-    GpuBufferState* buffer_states = vulkan_render->buffer_states;
+    if(!vulkan_render->passes_recording) {
+        LOG_ERROR("parallel passes were not began");
+        goto fail;
+    }
+    if(vulkan_render->passes_count == GPU_MAX_PARALLEL_PASSES) {
+        LOG_ERROR("too many parallel passes: %u/%u", vulkan_render->passes_count, GPU_MAX_PARALLEL_PASSES);
+        goto fail;
+    }
 
-    /* read write */ {
-    const u32* read_write_images_ids    = compute_info->images_read_write;
-    const u32* read_write_buffers_ids   = compute_info->buffers_read_write;
-    const u32  read_write_images_count  = compute_info->images_read_write_count;
-    const u32  read_write_buffers_count = compute_info->buffers_read_write_count;
+    const u32 pass_id = vulkan_render->passes_count;
+    if(!prepare_drawing_pass(vulkan_device, vulkan_resources, vulkan_render, drawing_info, &vulkan_render->passes[pass_id])) {
+        goto fail;
+    }
+    vulkan_render->passes_count++;
 
-    /* read write images */
-    for(u32 i = 0; i != read_write_images_count; i++) {
-        const u32 image_id = read_write_images_ids[i];
+    return pass_id;
 
-        if(image_id >= gpu_images_count) {
-            LOG_ERROR("invalid read write image id: %u/%u", image_id, gpu_images_count);
-            goto fail;
-        }
+    fail: {
+        return U32_MAX;
+    }
+}
 
-        const VkImageAspectFlags aspect = (gpu_images[image_id].usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
-
-        /* image read write barrier */
-        const VkAccessFlags        src_access = image_states[image_id].access;
-        const VkImageLayout        src_layout = image_states[image_id].layout;
-        const VkPipelineStageFlags src_stage  = image_states[image_id].stage;
-
-        const VkAccessFlags        dst_access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-        const VkImageLayout        dst_layout = VK_IMAGE_LAYOUT_GENERAL;
-        const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-
-        const VkImageMemoryBarrier read_write_image_barrier = {
-            .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .image            = gpu_images[image_id].image,
-            .srcAccessMask    = src_access,
-            .oldLayout        = src_layout,
-            .dstAccessMask    = dst_access,
-            .newLayout        = dst_layout,
-            .subresourceRange = (VkImageSubresourceRange) {
-                .aspectMask     = aspect,
-                .baseArrayLayer = 0,
-                .layerCount     = 1,
-                .baseMipLevel   = 0,
-                .levelCount     = 1
-            }
+b32 gpu_render_end_passes(
+    CtxHandle ctx
+) {
+    GpuContext*         gpu_ctx       = (GpuContext*)ctx;
+    const VulkanDevice* vulkan_device = &gpu_ctx->vulkan_device;
+    VulkanRender*       vulkan_render = &gpu_ctx->vulkan_render;
+
+    if(!vulkan_render->passes_recording) {
+        LOG_ERROR("parallel passes were not began");
+        goto fail;
+    }
+    vulkan_render->passes_recording = FALSE;
+
+    /* stitch passes in declaration order */
+    b32 passes_failed = FALSE;
+    for(u32 i = 0; i != vulkan_render->passes_count; i++) {
+        const GpuPass* pass = &vulkan_render->passes[i];
+
+        /* never ended or failed secondaries can't be executed, barriers still keep states consistent */
+        const b32 pass_complete = !pass->recording && !pass->failed;
+        if(!pass_complete) {
+            LOG_ERROR("pass was not recorded completely id: %u", i);
+            passes_failed = TRUE;
+        }
+
+        record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &pass->barriers);
+
+        if(pass->command_buffer != NULL && pass_complete) {
+            begin_pass_rendering(vulkan_device, vulkan_render->command_buffer, pass, VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+            vkCmdExecuteCommands(vulkan_render->command_buffer, 1, &pass->command_buffer);
+        }
+        /* nothing recorded, attachments are still cleared */
+        else {
+            begin_pass_rendering(vulkan_device, vulkan_render->command_buffer, pass, 0);
+        }
+        vulkan_device->cmd_end_rendering_khr(vulkan_render->command_buffer);
+    }
+    vulkan_render->passes_count = 0;
+
+    return !passes_failed;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* GPU_INLINE_PASS_ID records where begin_drawing began rendering */
+VkCommandBuffer pass_command_buffer(
+    const VulkanRender* vulkan_render,
+    u32                 pass_id
+) {
+    if(pass_id == GPU_INLINE_PASS_ID) {
+        return vulkan_render->command_buffer;
+    }
+    return vulkan_render->passes[pass_id].command_buffer;
+}
+
+/* thread safe for different thread_id */
+b32 gpu_render_pass_begin(
+    CtxHandle ctx,
+    u32       pass_id,
+    u32       thread_id
+) {
+    GpuContext*          gpu_ctx        = (GpuContext*)ctx;
+    const VulkanShaders* vulkan_shaders = &gpu_ctx->vulkan_shaders;
+    VulkanRender*        vulkan_render  = &gpu_ctx->vulkan_render;
+
+    if(pass_id >= vulkan_render->passes_count) {
+        LOG_ERROR("invalid pass id: %u/%u", pass_id, vulkan_render->passes_count);
+        goto fail;
+    }
+    if(thread_id >= GPU_MAX_RECORD_THREADS) {
+        LOG_ERROR("invalid record thread id: %u/%u", thread_id, GPU_MAX_RECORD_THREADS);
+        goto fail;
+    }
+
+    GpuPass*           pass            = &vulkan_render->passes[pass_id];
+    GpuThreadCommands* thread_commands = &vulkan_render->frames[vulkan_render->frame_id].thread_commands[thread_id];
+
+    if(pass->command_buffer != NULL) {
+        LOG_ERROR("pass was already recorded id: %u", pass_id);
+        goto fail;
+    }
+    if(thread_commands->command_buffers_used == GPU_MAX_PARALLEL_PASSES) {
+        LOG_ERROR("thread ran out of command buffers id: %u", thread_id);
+        pass->failed = TRUE;
+        goto fail;
+    }
+
+    const VkCommandBuffer command_buffer = thread_commands->command_buffers[thread_commands->command_buffers_used++];
+
+    /* secondary inherits attachment formats of the pass */
+    const VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info = {
+        .sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount    = pass->color_attachments_count,
+        .pColorAttachmentFormats = pass->color_formats,
+        .depthAttachmentFormat   = pass->depth_format,
+        .rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT
+    };
+    const VkCommandBufferInheritanceInfo          inheritance_info           = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = &inheritance_rendering_info
+    };
+    const VkCommandBufferBeginInfo                command_buffer_begin_info  = {
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritance_info
+    };
+    if(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS) {
+        LOG_ERROR("failed to begin pass command buffer id: %u", pass_id);
+        pass->failed = TRUE;
+        goto fail;
+    }
+
+    /* nothing is inherited except rendering */
+    vkCmdBindDescriptorSets(
+        command_buffer, 
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        vulkan_shaders->pipeline_layout,
+        0,
+        GPU_DESCRIPTOR_SET_COUNT,
+        vulkan_shaders->descriptor_sets,
+        vulkan_shaders->dynamic_bindings_count,
+        vulkan_render->dynamic_offsets
+    );
+    vkCmdSetViewport(command_buffer, 0, 1, &pass->viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &pass->render_area);
+
+    pass->command_buffer = command_buffer;
+    pass->recording      = TRUE;
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+void gpu_render_pass_end(
+    CtxHandle ctx,
+    u32       pass_id
+) {
+    GpuContext*   gpu_ctx       = (GpuContext*)ctx;
+    VulkanRender* vulkan_render = &gpu_ctx->vulkan_render;
+
+    if(pass_id >= vulkan_render->passes_count) {
+        LOG_ERROR("invalid pass id: %u/%u", pass_id, vulkan_render->passes_count);
+        goto fail;
+    }
+
+    GpuPass* pass = &vulkan_render->passes[pass_id];
+
+    if(!pass->recording) {
+        LOG_ERROR("pass is not recording id: %u", pass_id);
+        goto fail;
+    }
+    pass->recording = FALSE;
+
+    if(vkEndCommandBuffer(pass->command_buffer) != VK_SUCCESS) {
+        LOG_ERROR("failed to end pass command buffer id: %u", pass_id);
+        pass->failed = TRUE;
+    }
+
+    fail: {}
+}
+
+void gpu_render_pass_bind_graphics_pipeline(
+    CtxHandle  ctx,
+    u32        pass_id,
+    u32        pipeline_id,
+    const u32* dynamic_offsets
+) {
+    GpuContext*          gpu_ctx        = (GpuContext*)ctx;
+    const VulkanShaders* vulkan_shaders = &gpu_ctx->vulkan_shaders;
+    const VulkanRender*  vulkan_render  = &gpu_ctx->vulkan_render;
+
+    if(pipeline_id >= vulkan_shaders->pipelines_count) {
+        LOG_ERROR("invalid graphics pipeline id: %u/%u", pipeline_id, vulkan_shaders->pipelines_count);
+        goto fail;
+    }
+
+    vkCmdBindPipeline(
+        pass_command_buffer(vulkan_render, pass_id), 
+        VK_PIPELINE_BIND_POINT_GRAPHICS, 
+        vulkan_shaders->pipelines[pipeline_id]
+    );
+    bind_dynamic_offsets(
+        vulkan_shaders,
+        vulkan_render,
+        pass_command_buffer(vulkan_render, pass_id),
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        dynamic_offsets
+    );
+
+    fail: {}
+}
+
+void gpu_render_pass_push_constants(
+    CtxHandle   ctx,
+    u32         pass_id,
+    const void* constants,
+    u64         size
+) {
+    GpuContext*          gpu_ctx        = (GpuContext*)ctx;
+    const VulkanShaders* vulkan_shaders = &gpu_ctx->vulkan_shaders;
+    const VulkanRender*  vulkan_render  = &gpu_ctx->vulkan_render;
+
+    vkCmdPushConstants(
+        pass_command_buffer(vulkan_render, pass_id),
+        vulkan_shaders->pipeline_layout,
+        VK_SHADER_STAGE_ALL,
+        0,
+        size,
+        constants
+    );
+}
+
+void gpu_render_pass_draw(
+    CtxHandle ctx,
+    u32       pass_id,
+    i32       instance_count,
+    i32       vertex_count
+) {
+    GpuContext*         gpu_ctx       = (GpuContext*)ctx;
+    const VulkanRender* vulkan_render = &gpu_ctx->vulkan_render;
+
+    vkCmdDraw(
+        pass_command_buffer(vulkan_render, pass_id),
+        vertex_count,
+        instance_count,
+        0,
+        0
+    );
+}
+
+/* BAKED FRAMES */
+
+/* field by field, states built by assignment leave their padding undefined */
+b32 image_states_equal(
+    const GpuImageState* states_a,
+    const GpuImageState* states_b,
+    u32                  states_count
+) {
+    for(u32 i = 0; i != states_count; i++) {
+        if(
+            states_a[i].access != states_b[i].access ||
+            states_a[i].layout != states_b[i].layout ||
+            states_a[i].stage  != states_b[i].stage
+        ) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+b32 buffer_states_equal(
+    const GpuBufferState* states_a,
+    const GpuBufferState* states_b,
+    u32                   states_count
+) {
+    for(u32 i = 0; i != states_count; i++) {
+        if(
+            states_a[i].access != states_b[i].access ||
+            states_a[i].stage  != states_b[i].stage
+        ) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+b32 gpu_render_bake_begin(
+    CtxHandle ctx
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanShaders*   vulkan_shaders   = &gpu_ctx->vulkan_shaders;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+
+    if(vulkan_render->bake != NULL) {
+        LOG_ERROR("bake is allowed once per frame");
+        goto fail;
+    }
+    if(vulkan_render->async_compute_recording || vulkan_render->passes_recording) {
+        LOG_ERROR("bake inside async compute or parallel passes");
+        goto fail;
+    }
+
+    /* pending copies stay out of the bake */
+    flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+
+    /* dynamic offsets and surface view are recorded, so bakes are per frame slot and swapchain image */
+    /* most of the GPU_MAX_SWAPCHAIN_IMAGES slots are never used, bakes are created on first use */
+    const u32 bake_id = vulkan_render->swapchain_image_id + vulkan_render->frame_id * GPU_MAX_SWAPCHAIN_IMAGES;
+
+    if(vulkan_render->bakes[bake_id] == NULL) {
+        const ArenaMarker bakes_marker = arena_marker(&gpu_ctx->arena_bakes);
+
+        GpuBake* new_bake = arena_push(&gpu_ctx->arena_bakes, sizeof(GpuBake), 0);
+        if(new_bake == NULL) {
+            LOG_ERROR("failed to allocate bake id: %u", bake_id);
+            goto fail;
+        }
+
+        const VkCommandBufferAllocateInfo bake_command_buffer_info = {
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool        = vulkan_device->command_pool_render,
+            .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1
         };
+        if(vkAllocateCommandBuffers(vulkan_device->device, &bake_command_buffer_info, &new_bake->command_buffer) != VK_SUCCESS) {
+            LOG_ERROR("failed to create bake command buffer id: %u", bake_id);
+            arena_rewind(&gpu_ctx->arena_bakes, bakes_marker);
+            goto fail;
+        }
+        vulkan_render->bakes[bake_id] = new_bake;
+    }
 
-        vkCmdPipelineBarrier(
-            vulkan_render->command_buffer_render,
-            src_stage,
-            dst_stage,
-            0,
-            0,
-            NULL,
-            0,
-            NULL,
-            1,
-            &read_write_image_barrier
+    GpuBake*  bake               = vulkan_render->bakes[bake_id];
+    const u64 image_states_size  = sizeof(GpuImageState ) * vulkan_resources->images_count;
+    const u64 buffer_states_size = sizeof(GpuBufferState) * vulkan_resources->buffers_count;
+
+    /* replay, recorded barriers are valid only for the same starting states */
+    if(
+        bake->is_valid &&
+        image_states_equal (bake->image_states_begin,  vulkan_render->image_states,  vulkan_resources->images_count ) &&
+        buffer_states_equal(bake->buffer_states_begin, vulkan_render->buffer_states, vulkan_resources->buffers_count)
+    ) {
+        vulkan_render->bake = bake;
+        return FALSE;
+    }
+
+    /* rerecord, previous use of this bake retired with its frame slot */
+    bake->is_valid = FALSE;
+
+    const VkCommandBufferInheritanceInfo inheritance_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO
+    };
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pInheritanceInfo = &inheritance_info
+    };
+    if(vkResetCommandBuffer(bake->command_buffer, 0) != VK_SUCCESS) {
+        LOG_ERROR("failed to reset bake command buffer");
+        goto fail;
+    }
+    if(vkBeginCommandBuffer(bake->command_buffer, &command_buffer_begin_info) != VK_SUCCESS) {
+        LOG_ERROR("failed to begin bake command buffer");
+        goto fail;
+    }
+
+    /* secondaries don't inherit bound descriptor sets */
+    vkCmdBindDescriptorSets(
+        bake->command_buffer, 
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        vulkan_shaders->pipeline_layout,
+        0,
+        GPU_DESCRIPTOR_SET_COUNT,
+        vulkan_shaders->descriptor_sets,
+        vulkan_shaders->dynamic_bindings_count,
+        vulkan_render->dynamic_offsets
+    );
+    vkCmdBindDescriptorSets(
+        bake->command_buffer, 
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        vulkan_shaders->pipeline_layout,
+        0,
+        GPU_DESCRIPTOR_SET_COUNT,
+        vulkan_shaders->descriptor_sets,
+        vulkan_shaders->dynamic_bindings_count,
+        vulkan_render->dynamic_offsets
+    );
+
+    memcpy(bake->image_states_begin,  vulkan_render->image_states,  image_states_size );
+    memcpy(bake->buffer_states_begin, vulkan_render->buffer_states, buffer_states_size);
+
+    vulkan_render->command_buffer = bake->command_buffer;
+    vulkan_render->bake           = bake;
+    vulkan_render->bake_recording = TRUE;
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+void gpu_render_bake_end(
+    CtxHandle ctx
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+    GpuBake*               bake             = vulkan_render->bake;
+
+    if(bake == NULL) {
+        LOG_ERROR("bake was not began");
+        goto fail;
+    }
+
+    const u64 image_states_size  = sizeof(GpuImageState ) * vulkan_resources->images_count;
+    const u64 buffer_states_size = sizeof(GpuBufferState) * vulkan_resources->buffers_count;
+
+    if(vulkan_render->bake_recording) {
+        vulkan_render->bake_recording = FALSE;
+        vulkan_render->command_buffer = vulkan_render->frames[vulkan_render->frame_id].command_buffer_render;
+
+        if(vkEndCommandBuffer(bake->command_buffer) != VK_SUCCESS) {
+            LOG_ERROR("failed to end bake command buffer");
+            goto fail;
+        }
+        memcpy(bake->image_states_end,  vulkan_render->image_states,  image_states_size );
+        memcpy(bake->buffer_states_end, vulkan_render->buffer_states, buffer_states_size);
+        bake->is_valid = TRUE;
+    }
+
+    vkCmdExecuteCommands(vulkan_render->command_buffer, 1, &bake->command_buffer);
+
+    /* continue tracking from where the bake left resources */
+    memcpy(vulkan_render->image_states,  bake->image_states_end,  image_states_size );
+    memcpy(vulkan_render->buffer_states, bake->buffer_states_end, buffer_states_size);
+
+    fail: {}
+}
+
+void gpu_render_bake_invalidate(
+    CtxHandle ctx
+) {
+    GpuContext*   gpu_ctx       = (GpuContext*)ctx;
+    VulkanRender* vulkan_render = &gpu_ctx->vulkan_render;
+
+    for(u32 i = 0; i != GPU_MAX_SWAPCHAIN_IMAGES * vulkan_render->frames_count; i++) {
+        if(vulkan_render->bakes[i] != NULL) {
+            vulkan_render->bakes[i]->is_valid = FALSE;
+        }
+    }
+}
+
+void gpu_render_write_buffer(
+    CtxHandle   ctx, 
+    u32         buffer_id, 
+    const void* data, 
+    u64         offset, 
+    u64         size
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+
+    /* validation */
+    const GpuBuffer* buffers     = vulkan_resources->buffers;
+    const u32        buffer_slot = resources_buffer_slot(vulkan_resources, buffer_id);
+
+    if(buffer_slot == U32_MAX) {
+        LOG_ERROR("invalid buffer id: %u", buffer_id);
+        goto fail;
+    }
+
+    /* frame uniforms slot belongs to slices handed out by allocate_uniforms */
+    if(buffers[buffer_slot].frame_uniforms) {
+        LOG_ERROR("frame uniforms buffer can only be written by allocate_uniforms id: %u", buffer_id);
+        goto fail;
+    }
+
+    /* late latch, frame slot is written in place, gpu reads it only after submit */
+    if(buffers[buffer_slot].frame_stride != 0) {
+        /* render part reading the slot is already on the queue */
+        if(vulkan_render->async_compute_submitted) {
+            LOG_ERROR("late latch buffer written after async compute submit id: %u", buffer_id);
+            goto fail;
+        }
+
+        const GpuBuffer* gpu_buffer  = &buffers[buffer_slot];
+        const u64        slot_offset = gpu_buffer->allocation_offset + gpu_buffer->frame_stride * vulkan_render->frame_id;
+
+        if(offset + size > gpu_buffer->used_size) {
+            LOG_ERROR(
+                "trying to write size bigger than buffer: (%llu+%llu)/%llu", 
+                offset, size, gpu_buffer->used_size
+            );
+            goto fail;
+        }
+
+        memcpy(
+            (u8*)gpu_buffer->memory_map + slot_offset + offset,
+            data,
+            size
         );
+        mark_dirty_range(vulkan_device, vulkan_render, gpu_buffer, slot_offset + offset, size);
+        return;
+    }
+    if(vulkan_render->latching) {
+        LOG_ERROR("only late latch buffers can be written by latch id: %u", buffer_id);
+        goto fail;
+    }
+    if(vulkan_render->bake_recording) {
+        LOG_ERROR("only late latch buffers can be written inside bake id: %u", buffer_id);
+        goto fail;
+    }
 
-        image_states[image_id] = (GpuImageState) {
-            .access = dst_access,
-            .layout = dst_layout,
-            .stage  = dst_stage
-        };
+    /* buffer must not be read earlier in the frame, frame_begin keeps only writes */
+    if(vulkan_render->buffer_states[buffer_slot].access & ~GPU_ACCESS_WRITE_MASK) {
+        LOG_ERROR("invalid buffer access id: %u", buffer_id);
+        goto fail;
     }
 
-    /* read write buffers */
-    for(u32 i = 0; i != read_write_buffers_count; i++) {
-        const u32 buffer_id = read_write_buffers_ids[i];
-        
-        if(buffer_id >= gpu_buffers_count) {
-            LOG_ERROR("invalid read write buffer id: %u/%u", buffer_id, gpu_buffers_count);
+    const GpuBuffer* gpu_buffer = &buffers[buffer_slot];
+
+    if(offset + size > gpu_buffer->used_size) {
+        LOG_ERROR(
+            "trying to write size bigger than buffer: (%llu+%llu)/%llu", 
+            offset, size, gpu_buffer->used_size
+        );
+        goto fail;
+    }
+
+    /* direct copy, only safe while the gpu can't be reading previous frame data */
+    if(vulkan_render->frames_count == 1 && gpu_buffer->memory_map != NULL) {
+        /* copy, flushed with the frame */
+        memcpy(
+            (u8*)gpu_buffer->memory_map + gpu_buffer->allocation_offset + offset, 
+            data, 
+            size
+        );
+        mark_dirty_range(vulkan_device, vulkan_render, gpu_buffer, gpu_buffer->allocation_offset + offset, size);
+    }
+    /* host-device transfer */
+    else {
+        /* sub allocate from frame region, region is reused only after its frame retired */
+        const u64 upload_offset = ALIGN(vulkan_render->upload_size, GPU_UPLOAD_ALIGNMENT);
+
+        if(upload_offset + size > GPU_UPLOAD_FRAME_SIZE) {
+            LOG_ERROR("exceed upload frame limit: (%llu+%llu)/%llu", upload_offset, size, (u64)GPU_UPLOAD_FRAME_SIZE);
             goto fail;
         }
+        if(vulkan_render->upload_copies_count == GPU_MAX_UPLOAD_COPIES) {
+            flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+        }
 
-        /* image read write barrier */
-        const VkAccessFlags        src_access = buffer_states[buffer_id].access;
-        const VkPipelineStageFlags src_stage  = buffer_states[buffer_id].stage;
+        const u64 ring_offset = vulkan_render->frames[vulkan_render->frame_id].upload_offset + upload_offset;
 
-        const VkAccessFlags        dst_access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-        const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        memcpy(
+            (u8*)vulkan_resources->buffer_upload_ring.memory_map + vulkan_resources->buffer_upload_ring.allocation_offset + ring_offset, 
+            data,
+            size
+        );
 
-        const VkBufferMemoryBarrier read_write_buffer_barrier = {
-            .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-            .buffer        = gpu_buffers[buffer_id].buffer,
-            .size          = gpu_buffers[buffer_id].used_size,
-            .offset        = 0,
-            .srcAccessMask = src_access,
-            .dstAccessMask = dst_access
+        vulkan_render->upload_copies[vulkan_render->upload_copies_count++] = (GpuUploadCopy) {
+            .buffer_id = buffer_slot,
+            .region    = (VkBufferCopy) {
+                .srcOffset = ring_offset,
+                .dstOffset = offset,
+                .size      = size
+            }
         };
+        vulkan_render->upload_size = upload_offset + size;
+    }
 
-        vkCmdPipelineBarrier(
-            vulkan_render->command_buffer_render,
-            src_stage,
-            dst_stage,
-            0,
-            0,
-            NULL,
-            1,
-            &read_write_buffer_barrier,
-            0,
-            NULL
+    fail: {}
+}
+
+void gpu_render_set_latch(
+    CtxHandle    ctx,
+    GpuLatchFunc func,
+    void*        user_data
+) {
+    GpuContext*   gpu_ctx       = (GpuContext*)ctx;
+    VulkanRender* vulkan_render = &gpu_ctx->vulkan_render;
+
+    /* it would run after the render part reading late latch buffers was submitted */
+    if(vulkan_render->async_compute_submitted) {
+        LOG_ERROR("latch set after async compute submit");
+        return;
+    }
+
+    vulkan_render->latch_func      = func;
+    vulkan_render->latch_user_data = user_data;
+}
+
+/* slices are uniform offset aligned, so one atomic add hands them out to every record thread */
+/* frame slot is not read by the gpu before submit and flushed with the frame */
+u32 gpu_render_allocate_uniforms(
+    CtxHandle   ctx,
+    u32         buffer_id,
+    const void* data,
+    u64         size
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+
+    const u32 buffer_slot = resources_buffer_slot(vulkan_resources, buffer_id);
+    if(buffer_slot == U32_MAX || !vulkan_resources->buffers[buffer_slot].frame_uniforms) {
+        LOG_ERROR("invalid frame uniforms buffer id: %u", buffer_id);
+        goto fail;
+    }
+    if(size == 0 || size > GPU_FRAME_UNIFORMS_RANGE) {
+        LOG_ERROR("invalid frame uniforms size: %llu/%u", size, GPU_FRAME_UNIFORMS_RANGE);
+        goto fail;
+    }
+    /* replays would read offsets of the frame they were recorded in */
+    if(vulkan_render->bake_recording) {
+        LOG_ERROR("frame uniforms can't be allocated inside bake id: %u", buffer_id);
+        goto fail;
+    }
+
+    const GpuBuffer* gpu_buffer   = &vulkan_resources->buffers[buffer_slot];
+    const u64        slice_size   = ALIGN(size, vulkan_device->adapter->uniform_offset_alignment);
+    const u64        slice_offset = (u64)InterlockedExchangeAdd64(&vulkan_render->uniforms_allocated[buffer_slot], (i64)slice_size);
+
+    if(slice_offset + slice_size > gpu_buffer->used_size) {
+        LOG_ERROR(
+            "exceed frame uniforms limit id: %u (%llu+%llu)/%llu",
+            buffer_id, slice_offset, slice_size, gpu_buffer->used_size
         );
+        goto fail;
+    }
 
-        buffer_states[buffer_id] = (GpuBufferState) {
-            .access = dst_access,
-            .stage  = dst_stage
-        };
+    const u64 dynamic_offset = gpu_buffer->frame_stride * vulkan_render->frame_id + slice_offset;
+    memcpy(
+        (u8*)gpu_buffer->memory_map + gpu_buffer->allocation_offset + dynamic_offset,
+        data,
+        size
+    );
+    return (u32)dynamic_offset;
+
+    fail: {
+        return U32_MAX;
     }
+}
+
+/* COMPUTE */
+
+/* TRUE if id was not tracked yet */
+b32 track_async_resource(
+    u32* ids,
+    u32* ids_count,
+    u32  id
+) {
+    for(u32 i = 0; i != *ids_count; i++) {
+        if(ids[i] == id) {
+            return FALSE;
+        }
     }
+    ids[(*ids_count)++] = id;
+    return TRUE;
+}
 
-    /* read only */ {
-    const u32* read_only_images_ids    = compute_info->images_read_only;
-    const u32* read_only_buffers_ids   = compute_info->buffers_read_only;
-    const u32  read_only_images_count  = compute_info->images_read_only_count;
-    const u32  read_only_buffers_count = compute_info->buffers_read_only_count;
+/* inside async compute the first use of a resource with defined contents */
+/* is released from the render queue and acquired on the compute queue */
+void transit_compute_image(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanRender*          vulkan_render,
+    GpuBarrierBatch*       release_batch,
+    GpuBarrierBatch*       acquire_batch,
+    u32                    image_id,
+    VkAccessFlags2         dst_access
+) {
+    const GpuImage* image = &vulkan_resources->images[image_id];
+    GpuImageState*  state = &vulkan_render->image_states[image_id];
+    BarrierStats*   stats = &vulkan_render->barrier_stats;
 
-    /* read write images */
-    for(u32 i = 0; i != read_only_images_count; i++) {
-        const u32 image_id = read_only_images_ids[i];
+    const VkImageLayout         dst_layout = VK_IMAGE_LAYOUT_GENERAL;
+    const VkPipelineStageFlags2 dst_stage  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
 
-        if(image_id >= gpu_images_count) {
-            LOG_ERROR("invalid read write image id: %u/%u", image_id, gpu_images_count);
-            goto fail;
+    alias_image_state(vulkan_resources, vulkan_render, image_id);
+
+    if(
+        !vulkan_render->async_compute_recording || vulkan_device->queue_compute == NULL ||
+        !track_async_resource(vulkan_render->async_images, &vulkan_render->async_images_count, image_id)
+    ) {
+        barrier_batch_transit_image(acquire_batch, stats, image, state, dst_access, dst_layout, dst_stage);
+        return;
+    }
+
+    /* contents are discarded, render queue work before is ordered by the semaphore wait of the compute submit */
+    /* tracked stages can be graphics only, invalid on the compute queue, the transition just chains to that wait */
+    if(state->layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+        state->access = VK_ACCESS_2_NONE;
+        state->stage  = dst_stage;
+        barrier_batch_transit_image(acquire_batch, stats, image, state, dst_access, dst_layout, dst_stage);
+        return;
+    }
+
+    /* queue ownership transfer, never elided, producer stages go to the render queue release only */
+    VkImageMemoryBarrier2 compute_image_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image               = image->image,
+        .srcStageMask        = state->stage,
+        .srcAccessMask       = state->access,
+        .oldLayout           = state->layout,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask       = VK_ACCESS_2_NONE,
+        .newLayout           = dst_layout,
+        .srcQueueFamilyIndex = vulkan_device->adapter->render_queue_id,
+        .dstQueueFamilyIndex = vulkan_device->adapter->compute_queue_id,
+        .subresourceRange    = (VkImageSubresourceRange) {
+            .aspectMask     = image->aspect,
+            .baseArrayLayer = 0,
+            .layerCount     = 1,
+            .baseMipLevel   = 0,
+            .levelCount     = 1
         }
+    };
+    barrier_batch_add_image(release_batch, stats, &compute_image_barrier);
+
+    compute_image_barrier.srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+    compute_image_barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    compute_image_barrier.dstStageMask  = dst_stage;
+    compute_image_barrier.dstAccessMask = dst_access;
+    barrier_batch_add_image(acquire_batch, stats, &compute_image_barrier);
+
+    *state = (GpuImageState) {
+        .access = dst_access,
+        .layout = dst_layout,
+        .stage  = dst_stage
+    };
+}
+
+void transit_compute_buffer(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanRender*          vulkan_render,
+    GpuBarrierBatch*       release_batch,
+    GpuBarrierBatch*       acquire_batch,
+    u32                    buffer_id,
+    VkAccessFlags2         dst_access
+) {
+    const GpuBuffer* buffer = &vulkan_resources->buffers[buffer_id];
+    GpuBufferState*  state  = &vulkan_render->buffer_states[buffer_id];
+    BarrierStats*    stats  = &vulkan_render->barrier_stats;
+
+    const VkPipelineStageFlags2 dst_stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+    /* buffers always keep contents */
+    if(
+        !vulkan_render->async_compute_recording || vulkan_device->queue_compute == NULL ||
+        !track_async_resource(vulkan_render->async_buffers, &vulkan_render->async_buffers_count, buffer_id)
+    ) {
+        barrier_batch_transit_buffer(acquire_batch, stats, buffer, state, dst_access, dst_stage);
+        return;
+    }
+
+    /* queue ownership transfer, never elided, producer stages go to the render queue release only */
+    VkBufferMemoryBarrier2 compute_buffer_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer              = buffer->buffer,
+        .size                = buffer->used_size,
+        .offset              = 0,
+        .srcStageMask        = state->stage,
+        .srcAccessMask       = state->access,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask       = VK_ACCESS_2_NONE,
+        .srcQueueFamilyIndex = vulkan_device->adapter->render_queue_id,
+        .dstQueueFamilyIndex = vulkan_device->adapter->compute_queue_id
+    };
+    barrier_batch_add_buffer(release_batch, stats, &compute_buffer_barrier);
+
+    compute_buffer_barrier.srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+    compute_buffer_barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    compute_buffer_barrier.dstStageMask  = dst_stage;
+    compute_buffer_barrier.dstAccessMask = dst_access;
+    barrier_batch_add_buffer(acquire_batch, stats, &compute_buffer_barrier);
+
+    *state = (GpuBufferState) {
+        .access = dst_access,
+        .stage  = dst_stage
+    };
+}
+
+void gpu_render_begin_async_compute(
+    CtxHandle ctx
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanShaders*   vulkan_shaders   = &gpu_ctx->vulkan_shaders;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+    const GpuFrame*        frame            = &vulkan_render->frames[vulkan_render->frame_id];
 
-        const VkImageAspectFlags aspect = (gpu_images[image_id].usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
-
-        /* image read write barrier */
-        const VkAccessFlags        src_access = image_states[image_id].access;
-        const VkImageLayout        src_layout = image_states[image_id].layout;
-        const VkPipelineStageFlags src_stage  = image_states[image_id].stage;
-
-        const VkAccessFlags        dst_access = VK_ACCESS_SHADER_READ_BIT;
-        const VkImageLayout        dst_layout = VK_IMAGE_LAYOUT_GENERAL;
-        const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-
-        const VkImageMemoryBarrier read_write_image_barrier = {
-            .sType            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .image            = gpu_images[image_id].image,
-            .srcAccessMask    = src_access,
-            .oldLayout        = src_layout,
-            .dstAccessMask    = dst_access,
-            .newLayout        = dst_layout,
-            .subresourceRange = (VkImageSubresourceRange) {
-                .aspectMask     = aspect,
+    if(vulkan_render->async_compute_recording || vulkan_render->async_compute_submitted) {
+        LOG_ERROR("async compute is allowed once per frame");
+        goto fail;
+    }
+    if(vulkan_render->bake_recording) {
+        LOG_ERROR("async compute inside bake");
+        goto fail;
+    }
+
+    /* uploads go to the render part */
+    flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+
+    vulkan_render->async_compute_recording = TRUE;
+    vulkan_render->async_images_count      = 0;
+    vulkan_render->async_buffers_count     = 0;
+
+    /* no dedicated compute family, record inline */
+    if(vulkan_device->queue_compute == NULL) {
+        return;
+    }
+
+    if(!begin_command_buffer(vulkan_shaders, vulkan_render->dynamic_offsets, frame->command_buffer_compute, FALSE)) {
+        LOG_ERROR("failed to begin compute command buffer");
+        goto fail;
+    }
+    vulkan_render->command_buffer = frame->command_buffer_compute;
+
+    fail: {}
+}
+
+void gpu_render_end_async_compute(
+    CtxHandle ctx
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanShaders*   vulkan_shaders   = &gpu_ctx->vulkan_shaders;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+    const VulkanUpload*    vulkan_upload    = &gpu_ctx->vulkan_upload;
+    const GpuFrame*        frame            = &vulkan_render->frames[vulkan_render->frame_id];
+
+    if(!vulkan_render->async_compute_recording) {
+        LOG_ERROR("async compute was not began");
+        goto fail;
+    }
+    vulkan_render->async_compute_recording = FALSE;
+
+    if(vulkan_device->queue_compute == NULL) {
+        return;
+    }
+
+    /* release everything back to the render queue */
+    GpuBarrierBatch release_batch;
+    barrier_batch_reset(&release_batch);
+
+    for(u32 i = 0; i != vulkan_render->async_images_count; i++) {
+        const u32            image_id = vulkan_render->async_images[i];
+        const GpuImageState* state    = &vulkan_render->image_states[image_id];
+
+        const VkImageMemoryBarrier2 release_image_barrier = {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .image               = vulkan_resources->images[image_id].image,
+            .srcStageMask        = state->stage,
+            .srcAccessMask       = state->access,
+            .oldLayout           = state->layout,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+            .dstAccessMask       = VK_ACCESS_2_NONE,
+            .newLayout           = state->layout,
+            .srcQueueFamilyIndex = vulkan_device->adapter->compute_queue_id,
+            .dstQueueFamilyIndex = vulkan_device->adapter->render_queue_id,
+            .subresourceRange    = (VkImageSubresourceRange) {
+                .aspectMask     = vulkan_resources->images[image_id].aspect,
                 .baseArrayLayer = 0,
                 .layerCount     = 1,
                 .baseMipLevel   = 0,
                 .levelCount     = 1
             }
         };
+        barrier_batch_add_image(&release_batch, &vulkan_render->barrier_stats, &release_image_barrier);
+    }
+    for(u32 i = 0; i != vulkan_render->async_buffers_count; i++) {
+        const u32             buffer_id = vulkan_render->async_buffers[i];
+        const GpuBufferState* state     = &vulkan_render->buffer_states[buffer_id];
+
+        const VkBufferMemoryBarrier2 release_buffer_barrier = {
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer              = vulkan_resources->buffers[buffer_id].buffer,
+            .size                = vulkan_resources->buffers[buffer_id].used_size,
+            .offset              = 0,
+            .srcStageMask        = state->stage,
+            .srcAccessMask       = state->access,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+            .dstAccessMask       = VK_ACCESS_2_NONE,
+            .srcQueueFamilyIndex = vulkan_device->adapter->compute_queue_id,
+            .dstQueueFamilyIndex = vulkan_device->adapter->render_queue_id
+        };
+        barrier_batch_add_buffer(&release_batch, &vulkan_render->barrier_stats, &release_buffer_barrier);
+    }
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &release_batch);
 
-        vkCmdPipelineBarrier(
-            vulkan_render->command_buffer_render,
-            src_stage,
-            dst_stage,
-            0,
-            0,
-            NULL,
-            0,
-            NULL,
-            1,
-            &read_write_image_barrier
-        );
+    if(vkEndCommandBuffer(frame->command_buffer_compute) != VK_SUCCESS) {
+        LOG_ERROR("failed to end compute command buffer");
+        goto fail;
+    }
+    if(vkEndCommandBuffer(frame->command_buffer_render) != VK_SUCCESS) {
+        LOG_ERROR("failed to end render command buffer");
+        goto fail;
+    }
 
-        image_states[image_id] = (GpuImageState) {
-            .access = dst_access,
-            .layout = dst_layout,
-            .stage  = dst_stage
-        };
+    /* render part is the first submit of the frame, late latch buffers are final from here on */
+    run_latch(ctx);
+    flush_host_writes(vulkan_device, vulkan_resources, vulkan_render);
+
+    /* render part releases resources, compute waits for it */
+    const VkSemaphore                   render_wait_semaphores[2] = {frame->semaphore_image_available, vulkan_upload->semaphore_timeline};
+    const VkPipelineStageFlags          render_wait_stages[2]     = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+    const u64                           render_wait_values[2]     = {0, vulkan_upload->token_acquired};
+    const u64                           compute_acquire_value     = vulkan_render->compute_counter + 1;
+    const u64                           compute_finished_value    = vulkan_render->compute_counter + 2;
+    const VkTimelineSemaphoreSubmitInfo render_wait_values_info   = {
+        .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount   = 2,
+        .pWaitSemaphoreValues      = render_wait_values,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues    = &compute_acquire_value
+    };
+    const VkSubmitInfo                  submit_render_info        = {
+        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                = &render_wait_values_info,
+        .commandBufferCount   = 1,
+        .pCommandBuffers      = &frame->command_buffer_render,
+        .waitSemaphoreCount   = 2,
+        .pWaitSemaphores      = render_wait_semaphores,
+        .pWaitDstStageMask    = render_wait_stages,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores    = &vulkan_render->semaphore_compute_timeline
+    };
+    const VkPipelineStageFlags          compute_wait_stages       = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    const VkTimelineSemaphoreSubmitInfo compute_values_info       = {
+        .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount   = 1,
+        .pWaitSemaphoreValues      = &compute_acquire_value,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues    = &compute_finished_value
+    };
+    const VkSubmitInfo                  submit_compute_info       = {
+        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                = &compute_values_info,
+        .commandBufferCount   = 1,
+        .pCommandBuffers      = &frame->command_buffer_compute,
+        .waitSemaphoreCount   = 1,
+        .pWaitSemaphores      = &vulkan_render->semaphore_compute_timeline,
+        .pWaitDstStageMask    = &compute_wait_stages,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores    = &vulkan_render->semaphore_compute_timeline
+    };
+
+    if(vkQueueSubmit(vulkan_device->queue_render, 1, &submit_render_info, NULL) != VK_SUCCESS) {
+        LOG_ERROR("failed to submit render part to render queue");
+        goto fail;
+    }
+    if(vkQueueSubmit(vulkan_device->queue_compute, 1, &submit_compute_info, NULL) != VK_SUCCESS) {
+        LOG_ERROR("failed to submit async compute to compute queue");
+        goto fail;
     }
+    vulkan_render->compute_counter         = compute_finished_value;
+    vulkan_render->async_compute_submitted = TRUE;
 
-    /* read write buffers */
-    for(u32 i = 0; i != read_only_buffers_count; i++) {
-        const u32 buffer_id = read_only_buffers_ids[i];
-        
-        if(buffer_id >= gpu_buffers_count) {
-            LOG_ERROR("invalid read write buffer id: %u/%u", buffer_id, gpu_buffers_count);
-            goto fail;
-        }
+    /* continue with render work overlapping compute */
+    if(!begin_command_buffer(vulkan_shaders, vulkan_render->dynamic_offsets, frame->command_buffer_render_overlap, TRUE)) {
+        LOG_ERROR("failed to begin render overlap command buffer");
+        goto fail;
+    }
+    vulkan_render->command_buffer = frame->command_buffer_render_overlap;
 
-        /* image read write barrier */
-        const VkAccessFlags        src_access = buffer_states[buffer_id].access;
-        const VkPipelineStageFlags src_stage  = buffer_states[buffer_id].stage;
+    fail: {}
+}
 
-        const VkAccessFlags        dst_access = VK_ACCESS_SHADER_READ_BIT;
-        const VkPipelineStageFlags dst_stage  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+/* following render work waits for async compute results */
+void gpu_render_wait_async_compute(
+    CtxHandle ctx
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanShaders*   vulkan_shaders   = &gpu_ctx->vulkan_shaders;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+    const GpuFrame*        frame            = &vulkan_render->frames[vulkan_render->frame_id];
+
+    if(!vulkan_render->async_compute_submitted || vulkan_render->async_compute_joined) {
+        return;
+    }
 
-        const VkBufferMemoryBarrier read_write_buffer_barrier = {
-            .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-            .buffer        = gpu_buffers[buffer_id].buffer,
-            .size          = gpu_buffers[buffer_id].used_size,
-            .offset        = 0,
-            .srcAccessMask = src_access,
-            .dstAccessMask = dst_access
+    /* overlap work may have pending uploads */
+    flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+
+    if(vkEndCommandBuffer(frame->command_buffer_render_overlap) != VK_SUCCESS) {
+        LOG_ERROR("failed to end render overlap command buffer");
+        goto fail;
+    }
+    if(!begin_command_buffer(vulkan_shaders, vulkan_render->dynamic_offsets, frame->command_buffer_render_join, TRUE)) {
+        LOG_ERROR("failed to begin render join command buffer");
+        goto fail;
+    }
+    vulkan_render->command_buffer       = frame->command_buffer_render_join;
+    vulkan_render->async_compute_joined = TRUE;
+
+    /* acquire released resources, following barriers wait on the acquire */
+    GpuBarrierBatch acquire_batch;
+    barrier_batch_reset(&acquire_batch);
+
+    for(u32 i = 0; i != vulkan_render->async_images_count; i++) {
+        const u32      image_id = vulkan_render->async_images[i];
+        GpuImageState* state    = &vulkan_render->image_states[image_id];
+
+        const VkImageMemoryBarrier2 acquire_image_barrier = {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .image               = vulkan_resources->images[image_id].image,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+            .srcAccessMask       = VK_ACCESS_2_NONE,
+            .oldLayout           = state->layout,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .dstAccessMask       = VK_ACCESS_2_NONE,
+            .newLayout           = state->layout,
+            .srcQueueFamilyIndex = vulkan_device->adapter->compute_queue_id,
+            .dstQueueFamilyIndex = vulkan_device->adapter->render_queue_id,
+            .subresourceRange    = (VkImageSubresourceRange) {
+                .aspectMask     = vulkan_resources->images[image_id].aspect,
+                .baseArrayLayer = 0,
+                .layerCount     = 1,
+                .baseMipLevel   = 0,
+                .levelCount     = 1
+            }
         };
+        barrier_batch_add_image(&acquire_batch, &vulkan_render->barrier_stats, &acquire_image_barrier);
 
-        vkCmdPipelineBarrier(
-            vulkan_render->command_buffer_render,
-            src_stage,
-            dst_stage,
-            0,
-            0,
-            NULL,
-            1,
-            &read_write_buffer_barrier,
-            0,
-            NULL
-        );
+        *state = (GpuImageState) {
+            .access = VK_ACCESS_2_NONE,
+            .layout = state->layout,
+            .stage  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+        };
+    }
+    for(u32 i = 0; i != vulkan_render->async_buffers_count; i++) {
+        const u32       buffer_id = vulkan_render->async_buffers[i];
+        GpuBufferState* state     = &vulkan_render->buffer_states[buffer_id];
+
+        const VkBufferMemoryBarrier2 acquire_buffer_barrier = {
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer              = vulkan_resources->buffers[buffer_id].buffer,
+            .size                = vulkan_resources->buffers[buffer_id].used_size,
+            .offset              = 0,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+            .srcAccessMask       = VK_ACCESS_2_NONE,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .dstAccessMask       = VK_ACCESS_2_NONE,
+            .srcQueueFamilyIndex = vulkan_device->adapter->compute_queue_id,
+            .dstQueueFamilyIndex = vulkan_device->adapter->render_queue_id
+        };
+        barrier_batch_add_buffer(&acquire_batch, &vulkan_render->barrier_stats, &acquire_buffer_barrier);
 
-        buffer_states[buffer_id] = (GpuBufferState) {
-            .access = dst_access,
-            .stage  = dst_stage
+        *state = (GpuBufferState) {
+            .access = VK_ACCESS_2_NONE,
+            .stage  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
         };
     }
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &acquire_batch);
+
+    fail: {}
+}
+
+void gpu_render_compute_barrier(
+    CtxHandle          ctx, 
+    const ComputeInfo* compute_info
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanRender*          vulkan_render    = &gpu_ctx->vulkan_render;
+
+    /* async compute requires uploads to be written before it */
+    if(!vulkan_render->async_compute_recording) {
+        flush_upload_copies(vulkan_device, vulkan_resources, vulkan_render);
+    }
+
+    /* releases go to the render part, everything else to the current command buffer */
+    GpuBarrierBatch release_batch;
+    GpuBarrierBatch acquire_batch;
+    barrier_batch_reset(&release_batch);
+    barrier_batch_reset(&acquire_batch);
+
+    /* read write */
+    for(u32 i = 0; i != compute_info->images_read_write_count; i++) {
+        const u32 image_id = resources_image_slot(vulkan_resources, compute_info->images_read_write[i]);
+
+        if(image_id == U32_MAX) {
+            LOG_ERROR("invalid read write image id: %u", compute_info->images_read_write[i]);
+            goto fail;
+        }
+        transit_compute_image(vulkan_device, vulkan_resources, vulkan_render, &release_batch, &acquire_batch, image_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+    }
+    for(u32 i = 0; i != compute_info->buffers_read_write_count; i++) {
+        const u32 buffer_id = resources_buffer_slot(vulkan_resources, compute_info->buffers_read_write[i]);
+        
+        if(buffer_id == U32_MAX) {
+            LOG_ERROR("invalid read write buffer id: %u", compute_info->buffers_read_write[i]);
+            goto fail;
+        }
+        transit_compute_buffer(vulkan_device, vulkan_resources, vulkan_render, &release_batch, &acquire_batch, buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
     }
 
+    /* read only */
+    for(u32 i = 0; i != compute_info->images_read_only_count; i++) {
+        const u32 image_id = resources_image_slot(vulkan_resources, compute_info->images_read_only[i]);
+
+        if(image_id == U32_MAX) {
+            LOG_ERROR("invalid read only image id: %u", compute_info->images_read_only[i]);
+            goto fail;
+        }
+        transit_compute_image(vulkan_device, vulkan_resources, vulkan_render, &release_batch, &acquire_batch, image_id, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+    }
+    for(u32 i = 0; i != compute_info->buffers_read_only_count; i++) {
+        const u32 buffer_id = resources_buffer_slot(vulkan_resources, compute_info->buffers_read_only[i]);
+        
+        if(buffer_id == U32_MAX) {
+            LOG_ERROR("invalid read only buffer id: %u", compute_info->buffers_read_only[i]);
+            goto fail;
+        }
+        transit_compute_buffer(vulkan_device, vulkan_resources, vulkan_render, &release_batch, &acquire_batch, buffer_id, VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+    }
+
+    record_barrier_batch(vulkan_device, vulkan_render->frames[vulkan_render->frame_id].command_buffer_render, &vulkan_render->barrier_stats, &release_batch);
+    record_barrier_batch(vulkan_device, vulkan_render->command_buffer, &vulkan_render->barrier_stats, &acquire_batch);
+
     fail: {}
 }
 
 void gpu_render_bind_compute_pipeline(
-    CtxHandle ctx, 
-    u32       pipeline_id
+    CtxHandle  ctx, 
+    u32        pipeline_id,
+    const u32* dynamic_offsets
 ) {
     GpuContext*          gpu_ctx        = (GpuContext*)ctx;
     const VulkanShaders* vulkan_shaders = &gpu_ctx->vulkan_shaders;
@@ -1126,10 +2814,17 @@ void gpu_render_bind_compute_pipeline(
     }
 
     vkCmdBindPipeline(
-        vulkan_render->command_buffer_render, 
+        vulkan_render->command_buffer, 
         VK_PIPELINE_BIND_POINT_COMPUTE, 
         vulkan_shaders->pipelines[pipeline_id]
     );
+    bind_dynamic_offsets(
+        vulkan_shaders,
+        vulkan_render,
+        vulkan_render->command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        dynamic_offsets
+    );
 
     fail: {}
 }
@@ -1143,5 +2838,5 @@ void gpu_render_dispatch(
     GpuContext*          gpu_ctx        = (GpuContext*)ctx;
     const VulkanRender*  vulkan_render  = &gpu_ctx->vulkan_render;
 
-    vkCmdDispatch(vulkan_render->command_buffer_render, groups_x, groups_y, groups_z);
+    vkCmdDispatch(vulkan_render->command_buffer, groups_x, groups_y, groups_z);
 }
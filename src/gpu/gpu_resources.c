@@ -1,5 +1,9 @@
 #include "gpu_internal.h"
 
+#if GPU_MAX_STATIC_IMAGES > 32
+    #error "image alias masks are u32"
+#endif
+
 /* note that GPU_FORMAT_SURFACE is not in the list, because its selected dynamically */
 const VkFormat format_conversion_table[GPU_FORMAT_COUNT] = {
     [GPU_FORMAT_NONE               ] = VK_FORMAT_UNDEFINED,
@@ -15,13 +19,18 @@ const VkFormat format_conversion_table[GPU_FORMAT_COUNT] = {
     [GPU_FORMAT_R8_UNORM           ] = VK_FORMAT_R8_UNORM
 };
 
+/* late latch and frame uniforms buffers go to host memory, one uniform aligned slot per frame */
+/* frame uniforms get one descriptor range of tail, so the last slice of the last slot stays in bounds */
 b32 create_buffers(
-    VkDevice          device,
-    GpuMemorySection* memory,
+    VulkanDevice*     vulkan_device,
+    u32               frames_count,
+    u64               uniform_offset_alignment,
     const BufferInfo* buffer_infos,
     u32               buffer_infos_count,
     GpuBuffer*        buffers
 ) {
+    const VkDevice device = vulkan_device->device;
+
     if(buffer_infos_count > GPU_MAX_STATIC_BUFFERS) {
         LOG_ERROR("too many static buffers: %u/%u", buffer_infos_count, GPU_MAX_STATIC_BUFFERS);
         goto fail;
@@ -44,15 +53,33 @@ b32 create_buffers(
             buffer_usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         }
 
+        const b32                 is_frame_uniforms = (buffer_infos[i].flags & GPU_BUFFER_FLAG_FRAME_UNIFORMS) != 0;
+        const b32                 is_host_frames    = (buffer_infos[i].flags & GPU_BUFFER_FLAG_LATE_LATCH) != 0 || is_frame_uniforms;
+        const u64                 frame_stride      = is_host_frames ? ALIGN(buffer_infos[i].size, uniform_offset_alignment) : 0;
+        GpuVideoMemoryAllocation* buffer_memory     = is_host_frames ?
+            &vulkan_device->video_memory_host_transfer :
+            &vulkan_device->video_memory_device_buffers;
+
+        if(is_frame_uniforms && buffer_infos[i].flags != (GPU_BUFFER_FLAG_FRAME_UNIFORMS | GPU_BUFFER_FLAG_UNIFORM_BUFFER)) {
+            LOG_ERROR("frame uniforms buffer has to be uniform buffer only id: %u/%u", i, buffer_infos_count);
+            goto fail;
+        }
+        if(is_host_frames && vulkan_device->video_memory_host_transfer.blocks_count == 0) {
+            LOG_ERROR("late latch buffer without host memory id: %u/%u", i, buffer_infos_count);
+            goto fail;
+        }
+
         /* create buffer */
         const VkBufferCreateInfo buffer_info = {
             .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
             .usage = buffer_usage,
-            .size  = buffer_infos[i].size
+            .size  = is_host_frames ?
+                frame_stride * frames_count + (is_frame_uniforms ? GPU_FRAME_UNIFORMS_RANGE : 0) :
+                buffer_infos[i].size
         };
 
         VkBuffer buffer = NULL;
-        if(vkCreateBuffer(device, &buffer_info, NULL, &buffer) != VK_SUCCESS) {
+        if(vkCreateBuffer(device, &buffer_info, vulkan_device->allocator, &buffer) != VK_SUCCESS) {
             LOG_ERROR("failed to create buffer id: %u/%u", i, buffer_infos_count);
             goto fail;
         }
@@ -61,25 +88,43 @@ b32 create_buffers(
         VkMemoryRequirements buffer_requirements = (VkMemoryRequirements){0};
         vkGetBufferMemoryRequirements(device, buffer, &buffer_requirements);
 
-        const u64 buffer_allocation_offset = ALIGN(memory->offset, buffer_requirements.alignment);
-        const u64 buffer_allocation_size   = buffer_requirements.size;
+        u64                        buffer_allocation_offset = 0;
+        const GpuVideoMemoryBlock* buffer_block             = NULL;
+        const u64                  buffer_allocation_size   = buffer_requirements.size;
+        const u32                  buffer_allocation_id     = video_memory_allocate(
+            vulkan_device,
+            buffer_memory,
+            buffer_allocation_size,
+            buffer_requirements.alignment,
+            &buffer_allocation_offset,
+            &buffer_block
+        );
 
-        if(buffer_allocation_offset + buffer_allocation_size > memory->limit) {
-            LOG_ERROR("ran out of buffers memory: %llu/%llu", buffer_allocation_offset + buffer_allocation_size, memory->limit);
+        if(buffer_allocation_id == U32_MAX) {
+            LOG_ERROR("ran out of buffers memory id: %u/%u size: %llu", i, buffer_infos_count, buffer_allocation_size);
+            vkDestroyBuffer(device, buffer, vulkan_device->allocator);
             goto fail;
         }
-        if(vkBindBufferMemory(device, buffer, memory->memory, buffer_allocation_offset) != VK_SUCCESS) {
+        if(vkBindBufferMemory(device, buffer, buffer_block->device_memory, buffer_allocation_offset) != VK_SUCCESS) {
             LOG_ERROR("failed to bind buffer memory id: %u/%u", i, buffer_infos_count);
+            video_memory_free(vulkan_device, buffer_memory, buffer_allocation_id);
+            vkDestroyBuffer(device, buffer, vulkan_device->allocator);
             goto fail;
         }
 
-        memory->offset = buffer_allocation_offset + buffer_allocation_size;
-        buffers[i]     = (GpuBuffer) {
+        buffers[i] = (GpuBuffer) {
             .usage             = buffer_usage,
+            .allocation_id     = buffer_allocation_id,
             .allocation_offset = buffer_allocation_offset,
             .allocation_size   = buffer_allocation_size,
             .used_size         = buffer_infos[i].size,
-            .buffer            = buffer
+            .frame_stride      = frame_stride,
+            .frame_uniforms    = is_frame_uniforms,
+            .buffer            = buffer,
+            .memory            = buffer_block->device_memory,
+            .memory_map        = buffer_block->memory_map,
+            .memory_size       = buffer_block->pool.size,
+            .host_coherent     = (buffer_memory->type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0
         };
     }
 
@@ -90,20 +135,59 @@ b32 create_buffers(
     }
 }
 
+/* inclusive pass ranges, unused images overlap nothing */
+b32 lifetimes_overlap(
+    const ImageInfo* image_info_a,
+    const ImageInfo* image_info_b
+) {
+    if(image_info_a->lifetime_first == U32_MAX || image_info_b->lifetime_first == U32_MAX) {
+        return FALSE;
+    }
+    return
+        image_info_a->lifetime_first <= image_info_b->lifetime_last &&
+        image_info_b->lifetime_first <= image_info_a->lifetime_last;
+}
+
+/* surface relative sizes resolved against the current swapchain */
+ImageInfo resolve_image_info(
+    const VulkanResources* vulkan_resources,
+    const ImageInfo*       image_info
+) {
+    ImageInfo resolved = *image_info;
+    if(image_info->flags & GPU_IMAGE_FLAG_SURFACE_RELATIVE) {
+        resolved.size_x = MAX(1, (u32)((u64)vulkan_resources->swapchain_x * image_info->size_x / 100));
+        resolved.size_y = MAX(1, (u32)((u64)vulkan_resources->swapchain_y * image_info->size_y / 100));
+    }
+    return resolved;
+}
+
 /* FIX: refactor critical was bug found */
+/* transient images share one block, first fit against images with overlapping lifetimes */
+/* only images in images_mask are created, the other ones are kept, transient images are created all at once */
 b32 create_images(
-    VkDevice          device,
-    GpuMemorySection* memory,
+    VulkanDevice*     vulkan_device,
     const ImageInfo*  image_infos,
     u32               image_infos_count,
-    GpuImage*         images
+    u32               images_mask,
+    GpuImage*         images,
+    u32*              transient_allocation_id
 ) {
+    const VkDevice            device              = vulkan_device->device;
+    const u32                 lazy_memory_type_id = vulkan_device->lazy_memory_type_id;
+    GpuVideoMemoryAllocation* images_memory       = &vulkan_device->video_memory_device_images;
+
+    VkMemoryRequirements image_requirements[GPU_MAX_STATIC_IMAGES];
+
     if(image_infos_count > GPU_MAX_STATIC_IMAGES) {
         LOG_ERROR("too many static images: %u/%u", image_infos_count, GPU_MAX_STATIC_IMAGES);
         goto fail;
     }
 
     for(u32 i = 0; i != image_infos_count; i++) {
+        if(!(images_mask & (0x1 << i))) {
+            continue;
+        }
+
         /* image format and usage */
         VkFormat           image_format = VK_FORMAT_UNDEFINED;
         VkImageUsageFlags  image_usage  = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
@@ -122,6 +206,20 @@ b32 create_images(
             );
             goto fail;
         }
+        if((image_infos[i].flags & GPU_IMAGE_FLAG_TRANSIENT) && (image_infos[i].flags & GPU_IMAGE_FLAG_PERSISTENT)) {
+            LOG_ERROR("image can't be transient and persistent id: %u/%u", i, image_infos_count);
+            goto fail;
+        }
+
+        const b32 is_transient = (image_infos[i].flags & GPU_IMAGE_FLAG_TRANSIENT) != 0;
+        const b32 is_lazy      = 
+            is_transient && lazy_memory_type_id != U32_MAX &&
+            (image_infos[i].flags & (GPU_IMAGE_FLAG_SAMPLED | GPU_IMAGE_FLAG_STORAGE)) == 0;
+
+        /* transient attachments allow attachment usage only */
+        if(is_lazy) {
+            image_usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        }
         if(image_infos[i].flags & GPU_IMAGE_FLAG_COLOR_ATTACHMENT) {
             image_usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
         }
@@ -153,34 +251,184 @@ b32 create_images(
         };
 
         VkImage image = NULL;
-        if(vkCreateImage(device, &image_info, NULL, &image) != VK_SUCCESS) {
+        if(vkCreateImage(device, &image_info, vulkan_device->allocator, &image) != VK_SUCCESS) {
             LOG_ERROR("failed to create image id: %u/%u", i, image_infos_count);
             goto fail;
         }
 
         /* image requirements */
-        VkMemoryRequirements image_requirements = (VkMemoryRequirements){0};
-        vkGetImageMemoryRequirements(device, image, &image_requirements);
+        image_requirements[i] = (VkMemoryRequirements){0};
+        vkGetImageMemoryRequirements(device, image, &image_requirements[i]);
+
+        /* lazily allocated memory is dedicated, tile memory backs it on adapters that have it */
+        VkDeviceMemory lazy_memory = NULL;
+        if(is_lazy && (image_requirements[i].memoryTypeBits & (0x1 << lazy_memory_type_id))) {
+            const VkMemoryAllocateInfo lazy_memory_info = {
+                .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .memoryTypeIndex = lazy_memory_type_id,
+                .allocationSize  = image_requirements[i].size
+            };
+            if(vkAllocateMemory(device, &lazy_memory_info, vulkan_device->allocator, &lazy_memory) != VK_SUCCESS) {
+                LOG_ERROR("failed to allocate lazy image memory id: %u/%u", i, image_infos_count);
+                goto fail;
+            }
+            if(vkBindImageMemory(device, image, lazy_memory, 0) != VK_SUCCESS) {
+                LOG_ERROR("failed to bind lazy image memory id: %u/%u", i, image_infos_count);
+                goto fail;
+            }
+        }
+
+        /* FIX: image aspect selection */
+        const VkImageAspectFlags image_aspect = (image_usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+
+        images[i] = (GpuImage) {
+            .usage             = image_usage,
+            .format            = image_format,
+            .allocation_id     = U32_MAX,
+            .allocation_offset = 0,
+            .allocation_size   = (lazy_memory != NULL) ? image_requirements[i].size : 0,
+            .size_x            = image_infos[i].size_x,
+            .size_y            = image_infos[i].size_y,
+            .image             = image,
+            .aspect            = image_aspect,
+            .persistent        = (image_infos[i].flags & GPU_IMAGE_FLAG_PERSISTENT) != 0,
+            .transient         = is_transient,
+            .lazy_memory       = lazy_memory
+        };
+    }
+
+    /* regular images get their own blocks */
+    for(u32 i = 0; i != image_infos_count; i++) {
+        if(!(images_mask & (0x1 << i)) || images[i].lazy_memory != NULL || images[i].transient) {
+            continue;
+        }
 
-        const u64 image_allocation_offset = ALIGN(memory->offset, image_requirements.alignment);
-        const u64 image_allocation_size   = image_requirements.size;
+        u64                        image_offset = 0;
+        const GpuVideoMemoryBlock* image_block  = NULL;
+        const u64                  image_size   = image_requirements[i].size;
+        const u32                  image_id     = video_memory_allocate(
+            vulkan_device,
+            images_memory,
+            image_size,
+            image_requirements[i].alignment,
+            &image_offset,
+            &image_block
+        );
 
-        if(image_allocation_offset + image_allocation_size > memory->limit) {
-            LOG_ERROR("ran out of images memory: %llu/%llu", image_allocation_offset + image_allocation_size, memory->limit);
+        if(image_id == U32_MAX) {
+            LOG_ERROR("ran out of images memory id: %u/%u size: %llu", i, image_infos_count, image_size);
             goto fail;
         }
-        if(vkBindImageMemory(device, image, memory->memory, image_allocation_offset) != VK_SUCCESS) {
+        images[i].allocation_id = image_id;
+
+        if(vkBindImageMemory(device, images[i].image, image_block->device_memory, image_offset) != VK_SUCCESS) {
             LOG_ERROR("failed to bind image memory id: %u/%u", i, image_infos_count);
             goto fail;
         }
 
-        /* FIX: image aspect selection */
-        /* create image view */
-        const VkImageAspectFlags    image_aspect    = (image_usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+        images[i].allocation_offset = image_offset;
+        images[i].allocation_size   = image_size;
+    }
+
+    /* transient images are laid out inside one block, relative to its start */
+    u64 transient_size      = 0;
+    u64 transient_alignment = 1;
+    u64 transient_total     = 0;
+
+    for(u32 i = 0; i != image_infos_count; i++) {
+        if(!(images_mask & (0x1 << i)) || images[i].lazy_memory != NULL || !images[i].transient) {
+            continue;
+        }
+
+        const u64 image_alignment = image_requirements[i].alignment;
+        const u64 image_size      = image_requirements[i].size;
+        u64       image_offset    = 0;
+
+        /* lowest offset not overlapping placed images that are alive at the same time */
+        b32 moved = TRUE;
+        while(moved) {
+            moved = FALSE;
+            for(u32 j = 0; j != i; j++) {
+                const b32 overlaps = 
+                    (images_mask & (0x1 << j)) &&
+                    images[j].transient && images[j].lazy_memory == NULL &&
+                    lifetimes_overlap(&image_infos[i], &image_infos[j]) &&
+                    image_offset < images[j].allocation_offset + images[j].allocation_size &&
+                    images[j].allocation_offset < image_offset + image_size;
+
+                if(overlaps) {
+                    image_offset = ALIGN(images[j].allocation_offset + images[j].allocation_size, image_alignment);
+                    moved        = TRUE;
+                }
+            }
+        }
+
+        images[i].allocation_offset = image_offset;
+        images[i].allocation_size   = image_size;
+
+        transient_size      = MAX(transient_size, image_offset + image_size);
+        transient_alignment = MAX(transient_alignment, image_alignment);
+        transient_total    += image_size;
+    }
+
+    *transient_allocation_id = U32_MAX;
+    if(transient_total != 0) {
+        u64                        transient_offset = 0;
+        const GpuVideoMemoryBlock* transient_block  = NULL;
+
+        *transient_allocation_id = video_memory_allocate(
+            vulkan_device,
+            images_memory,
+            transient_size,
+            transient_alignment,
+            &transient_offset,
+            &transient_block
+        );
+        if(*transient_allocation_id == U32_MAX) {
+            LOG_ERROR("ran out of images memory for transient images size: %llu", transient_size);
+            goto fail;
+        }
+
+        for(u32 i = 0; i != image_infos_count; i++) {
+            if(!(images_mask & (0x1 << i)) || images[i].lazy_memory != NULL || !images[i].transient) {
+                continue;
+            }
+
+            images[i].allocation_offset += transient_offset;
+            if(vkBindImageMemory(device, images[i].image, transient_block->device_memory, images[i].allocation_offset) != VK_SUCCESS) {
+                LOG_ERROR("failed to bind image memory id: %u/%u", i, image_infos_count);
+                goto fail;
+            }
+        }
+        LOG_MESSAGE("transient images: %llu bytes aliased into %llu", transient_total, transient_size);
+    }
+
+    /* images sharing memory, their first use waits for the other ones */
+    for(u32 i = 0; i != image_infos_count; i++) {
+        for(u32 j = 0; j != image_infos_count; j++) {
+            const b32 aliases =
+                i != j && (images_mask & (0x1 << i)) && (images_mask & (0x1 << j)) &&
+                images[i].transient && images[j].transient &&
+                images[i].lazy_memory == NULL && images[j].lazy_memory == NULL &&
+                images[i].allocation_offset < images[j].allocation_offset + images[j].allocation_size &&
+                images[j].allocation_offset < images[i].allocation_offset + images[i].allocation_size;
+
+            if(aliases) {
+                images[i].alias_mask |= 0x1 << j;
+            }
+        }
+    }
+
+    /* create image views */
+    for(u32 i = 0; i != image_infos_count; i++) {
+        if(!(images_mask & (0x1 << i))) {
+            continue;
+        }
+
         const VkImageViewCreateInfo image_view_info = {
             .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-            .format           = image_format,
-            .image            = image,
+            .format           = images[i].format,
+            .image            = images[i].image,
             .viewType         = VK_IMAGE_VIEW_TYPE_2D,
             .components       = (VkComponentMapping) {
                 .r = VK_COMPONENT_SWIZZLE_R,
@@ -189,7 +437,7 @@ b32 create_images(
                 .a = VK_COMPONENT_SWIZZLE_A
             },
             .subresourceRange = (VkImageSubresourceRange) {
-                .aspectMask     = image_aspect,
+                .aspectMask     = images[i].aspect,
                 .baseArrayLayer = 0,
                 .baseMipLevel   = 0,
                 .layerCount     = 1,
@@ -197,24 +445,10 @@ b32 create_images(
             }
         };
 
-        VkImageView image_view = NULL;
-        if(vkCreateImageView(device, &image_view_info, NULL, &image_view) != VK_SUCCESS) {
+        if(vkCreateImageView(device, &image_view_info, vulkan_device->allocator, &images[i].view) != VK_SUCCESS) {
             LOG_ERROR("failed to create image view id: %u/%u", i, image_infos_count);
             goto fail;
         }
-
-        memory->offset = image_allocation_offset + image_allocation_size;
-        images[i]      = (GpuImage) {
-            .usage             = image_usage,
-            .format            = image_format,
-            .allocation_offset = image_allocation_offset,
-            .allocation_size   = image_allocation_size,
-            .size_x            = image_infos[i].size_x,
-            .size_y            = image_infos[i].size_y,
-            .image             = image,
-            .view              = image_view,
-            .aspect            = image_aspect
-        };
     }
 
     return TRUE;
@@ -225,52 +459,184 @@ b32 create_images(
 }
 
 /* FIX: refactor */
+/* upload ring holds one GPU_UPLOAD_FRAME_SIZE region per frame in flight */
+/* stream ring is consumed by background uploads */
 b32 create_transfer_buffers(
-    VkDevice          device,
-    GpuMemorySection* memory,
-    GpuBuffer*        sync_transfer
+    VulkanDevice*     vulkan_device,
+    u32               frames_count,
+    GpuBuffer*        upload_ring,
+    GpuBuffer*        stream_ring
 ) {
-    const VkBufferCreateInfo sync_transfer_buffer_info = {
+    const VkDevice            device          = vulkan_device->device;
+    GpuVideoMemoryAllocation* transfer_memory = &vulkan_device->video_memory_host_transfer;
+
+    const VkBufferCreateInfo upload_ring_buffer_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .size  = (u64)GPU_UPLOAD_FRAME_SIZE * frames_count
+    };
+    const VkBufferCreateInfo stream_ring_buffer_info = {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        .size  = GPU_SYNC_TRANSFER_SIZE
+        .size  = GPU_STREAM_RING_SIZE
     };
 
-    VkBuffer sync_transfer_buffer = NULL;
+    VkBuffer upload_ring_buffer = NULL;
+    VkBuffer stream_ring_buffer = NULL;
 
-    if(vkCreateBuffer(device, &sync_transfer_buffer_info, NULL, &sync_transfer_buffer) != VK_SUCCESS) {
-        LOG_ERROR("failed to create sync transfer buffer");
+    if(vkCreateBuffer(device, &upload_ring_buffer_info, vulkan_device->allocator, &upload_ring_buffer) != VK_SUCCESS) {
+        LOG_ERROR("failed to create upload ring buffer");
+        goto fail;
+    }
+    if(vkCreateBuffer(device, &stream_ring_buffer_info, vulkan_device->allocator, &stream_ring_buffer) != VK_SUCCESS) {
+        LOG_ERROR("failed to create stream ring buffer");
         goto fail;
     }
 
-    VkMemoryRequirements sync_transfer_requirements = (VkMemoryRequirements){0};
+    VkMemoryRequirements upload_ring_requirements = (VkMemoryRequirements){0};
+    VkMemoryRequirements stream_ring_requirements = (VkMemoryRequirements){0};
+
+    vkGetBufferMemoryRequirements(device, upload_ring_buffer, &upload_ring_requirements);
+    vkGetBufferMemoryRequirements(device, stream_ring_buffer, &stream_ring_requirements);
+
+    u64                        upload_ring_offset = 0;
+    u64                        stream_ring_offset = 0;
+    const GpuVideoMemoryBlock* upload_ring_block  = NULL;
+    const GpuVideoMemoryBlock* stream_ring_block  = NULL;
+    const u64                  upload_ring_size   = upload_ring_requirements.size;
+    const u64                  stream_ring_size   = stream_ring_requirements.size;
+
+    const u32 upload_ring_id = video_memory_allocate(
+        vulkan_device,
+        transfer_memory,
+        upload_ring_size,
+        upload_ring_requirements.alignment,
+        &upload_ring_offset,
+        &upload_ring_block
+    );
+    if(upload_ring_id == U32_MAX) {
+        LOG_ERROR("ran out of transfer memory for upload ring size: %llu", upload_ring_size);
+        goto fail;
+    }
+    const u32 stream_ring_id = video_memory_allocate(
+        vulkan_device,
+        transfer_memory,
+        stream_ring_size,
+        stream_ring_requirements.alignment,
+        &stream_ring_offset,
+        &stream_ring_block
+    );
+    if(stream_ring_id == U32_MAX) {
+        LOG_ERROR("ran out of transfer memory for stream ring size: %llu", stream_ring_size);
+        video_memory_free(vulkan_device, transfer_memory, upload_ring_id);
+        goto fail;
+    }
 
-    vkGetBufferMemoryRequirements(device, sync_transfer_buffer, &sync_transfer_requirements);
+    if(vkBindBufferMemory(device, upload_ring_buffer, upload_ring_block->device_memory, upload_ring_offset) != VK_SUCCESS) {
+        LOG_ERROR("failed to bind upload ring buffer memory");
+        goto fail;
+    }
+    if(vkBindBufferMemory(device, stream_ring_buffer, stream_ring_block->device_memory, stream_ring_offset) != VK_SUCCESS) {
+        LOG_ERROR("failed to bind stream ring buffer memory");
+        goto fail;
+    }
 
-    u64 allocation_end             = memory->offset;
-    const u64 sync_transfer_offset = ALIGN(allocation_end, sync_transfer_requirements.alignment);
-    const u64 sync_transfer_size   = sync_transfer_requirements.size;
-    allocation_end                 = sync_transfer_offset + sync_transfer_size;
+    *upload_ring = (GpuBuffer) {
+        .usage             = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .buffer            = upload_ring_buffer,
+        .allocation_id     = upload_ring_id,
+        .allocation_offset = upload_ring_offset,
+        .allocation_size   = upload_ring_size,
+        .used_size         = (u64)GPU_UPLOAD_FRAME_SIZE * frames_count,
+        .memory            = upload_ring_block->device_memory,
+        .memory_map        = upload_ring_block->memory_map,
+        .memory_size       = upload_ring_block->pool.size,
+        .host_coherent     = (transfer_memory->type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0
+    };
+    *stream_ring = (GpuBuffer) {
+        .usage             = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .buffer            = stream_ring_buffer,
+        .allocation_id     = stream_ring_id,
+        .allocation_offset = stream_ring_offset,
+        .allocation_size   = stream_ring_size,
+        .used_size         = GPU_STREAM_RING_SIZE,
+        .memory            = stream_ring_block->device_memory,
+        .memory_map        = stream_ring_block->memory_map,
+        .memory_size       = stream_ring_block->pool.size,
+        .host_coherent     = (transfer_memory->type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0
+    };
 
-    if(allocation_end > memory->limit) {
-        LOG_ERROR(
-            "exceed memory limit: (%llu+%llu)/%llu", 
-            sync_transfer_offset, sync_transfer_size, memory->limit
-        );
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* readback ring is written by copies and read by the host once their frame retired */
+b32 create_readback_buffer(
+    VulkanDevice* vulkan_device,
+    GpuBuffer*    readback_ring
+) {
+    const VkDevice            device          = vulkan_device->device;
+    GpuVideoMemoryAllocation* readback_memory = &vulkan_device->video_memory_host_readback;
+
+    const VkBufferCreateInfo readback_ring_buffer_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .size  = GPU_READBACK_RING_SIZE
+    };
+
+    VkBuffer readback_ring_buffer = NULL;
+    if(vkCreateBuffer(device, &readback_ring_buffer_info, vulkan_device->allocator, &readback_ring_buffer) != VK_SUCCESS) {
+        LOG_ERROR("failed to create readback ring buffer");
         goto fail;
     }
 
-    if(vkBindBufferMemory(device, sync_transfer_buffer, memory->memory, sync_transfer_offset) != VK_SUCCESS) {
-        LOG_ERROR("failed to bind sync transfer buffer memory");
+    VkMemoryRequirements readback_ring_requirements = (VkMemoryRequirements){0};
+    vkGetBufferMemoryRequirements(device, readback_ring_buffer, &readback_ring_requirements);
+
+    u64                        readback_ring_offset = 0;
+    const GpuVideoMemoryBlock* readback_ring_block  = NULL;
+    const u64                  readback_ring_size   = readback_ring_requirements.size;
+
+    const u32 readback_ring_id = video_memory_allocate(
+        vulkan_device,
+        readback_memory,
+        readback_ring_size,
+        readback_ring_requirements.alignment,
+        &readback_ring_offset,
+        &readback_ring_block
+    );
+    if(readback_ring_id == U32_MAX) {
+        LOG_ERROR("ran out of readback memory for readback ring size: %llu", readback_ring_size);
+        vkDestroyBuffer(device, readback_ring_buffer, vulkan_device->allocator);
+        goto fail;
+    }
+    if(readback_ring_block->memory_map == NULL) {
+        LOG_ERROR("readback memory is not mapped");
+        video_memory_free(vulkan_device, readback_memory, readback_ring_id);
+        vkDestroyBuffer(device, readback_ring_buffer, vulkan_device->allocator);
+        goto fail;
+    }
+    if(vkBindBufferMemory(device, readback_ring_buffer, readback_ring_block->device_memory, readback_ring_offset) != VK_SUCCESS) {
+        LOG_ERROR("failed to bind readback ring buffer memory");
+        video_memory_free(vulkan_device, readback_memory, readback_ring_id);
+        vkDestroyBuffer(device, readback_ring_buffer, vulkan_device->allocator);
         goto fail;
     }
 
-    *sync_transfer = (GpuBuffer) {
-        .usage             = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        .buffer            = sync_transfer_buffer,
-        .allocation_offset = sync_transfer_offset,
-        .allocation_size   = sync_transfer_size,
-        .used_size         = GPU_SYNC_TRANSFER_SIZE
+    *readback_ring = (GpuBuffer) {
+        .usage             = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .buffer            = readback_ring_buffer,
+        .allocation_id     = readback_ring_id,
+        .allocation_offset = readback_ring_offset,
+        .allocation_size   = readback_ring_size,
+        .used_size         = GPU_READBACK_RING_SIZE,
+        .memory            = readback_ring_block->device_memory,
+        .memory_map        = readback_ring_block->memory_map,
+        .memory_size       = readback_ring_block->pool.size,
+        .host_coherent     = (readback_memory->type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0
     };
 
     return TRUE;
@@ -281,11 +647,12 @@ b32 create_transfer_buffers(
 }
 
 b32 create_samplers(
-    VkDevice   device,
-    VkSampler* sampler_linear_repeat,
-    VkSampler* sampler_linear_clamp,
-    VkSampler* sampler_nearest_repeat,
-    VkSampler* sampler_nearest_clamp
+    VkDevice                     device,
+    const VkAllocationCallbacks* allocator,
+    VkSampler*                   sampler_linear_repeat,
+    VkSampler*                   sampler_linear_clamp,
+    VkSampler*                   sampler_nearest_repeat,
+    VkSampler*                   sampler_nearest_clamp
 ) {
     const VkSamplerCreateInfo linear_repeat_info = {
         .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
@@ -360,19 +727,19 @@ b32 create_samplers(
         .unnormalizedCoordinates = VK_FALSE
     };
 
-    if(vkCreateSampler(device, &linear_repeat_info, NULL, sampler_linear_repeat) != VK_SUCCESS) {
+    if(vkCreateSampler(device, &linear_repeat_info, allocator, sampler_linear_repeat) != VK_SUCCESS) {
         LOG_ERROR("failed to create linear repeat sampler");
         goto fail;
     }
-    if(vkCreateSampler(device, &linear_clamp_info, NULL, sampler_linear_clamp) != VK_SUCCESS) {
+    if(vkCreateSampler(device, &linear_clamp_info, allocator, sampler_linear_clamp) != VK_SUCCESS) {
         LOG_ERROR("failed to create linear clamp sampler");
         goto fail;
     }
-    if(vkCreateSampler(device, &nearest_repeat_info, NULL, sampler_nearest_repeat) != VK_SUCCESS) {
+    if(vkCreateSampler(device, &nearest_repeat_info, allocator, sampler_nearest_repeat) != VK_SUCCESS) {
         LOG_ERROR("failed to create nearest repeat sampler");
         goto fail;
     }
-    if(vkCreateSampler(device, &nearest_clamp_info, NULL, sampler_nearest_clamp) != VK_SUCCESS) {
+    if(vkCreateSampler(device, &nearest_clamp_info, allocator, sampler_nearest_clamp) != VK_SUCCESS) {
         LOG_ERROR("failed to create nearest clamp sampler");
         goto fail;
     }
@@ -388,17 +755,18 @@ b32 create_samplers(
     1 = fail
     2 = window_closed */
 i32 create_swapchain(
-    VkDevice            device,
-    VkPhysicalDevice    physical_device,
-    VkSurfaceKHR        surface,
-    VkFormat            surface_format,
-    VkColorSpaceKHR     surface_color_space,
-    VkSwapchainKHR*     swapchain,
-    u32*                swapchain_images_count,
-    u32*                swapchain_x,
-    u32*                swapchain_y,
-    VkImage*            swapchain_images,
-    VkImageView*        swapchain_image_views
+    VkDevice                     device,
+    const VkAllocationCallbacks* allocator,
+    VkPhysicalDevice             physical_device,
+    VkSurfaceKHR                 surface,
+    VkFormat                     surface_format,
+    VkColorSpaceKHR              surface_color_space,
+    VkSwapchainKHR*              swapchain,
+    u32*                         swapchain_images_count,
+    u32*                         swapchain_x,
+    u32*                         swapchain_y,
+    VkImage*                     swapchain_images,
+    VkImageView*                 swapchain_image_views
 ) {
     VkSurfaceCapabilitiesKHR surface_capabilities = (VkSurfaceCapabilitiesKHR){0}; 
     while(1) {
@@ -427,7 +795,7 @@ i32 create_swapchain(
     const VkSwapchainKHR old_swapchain              = *swapchain;
     const u32            swapchain_old_images_count = *swapchain_images_count;
     for(u32 i = 0; i != swapchain_old_images_count; i++) {
-        vkDestroyImageView(device, swapchain_image_views[i], NULL);
+        vkDestroyImageView(device, swapchain_image_views[i], allocator);
         swapchain_images[i]      = NULL;
         swapchain_image_views[i] = NULL;
     }
@@ -452,13 +820,13 @@ i32 create_swapchain(
         }
     };
 
-    if(vkCreateSwapchainKHR(device, &swapchain_info, NULL, swapchain) != VK_SUCCESS) {
+    if(vkCreateSwapchainKHR(device, &swapchain_info, allocator, swapchain) != VK_SUCCESS) {
         LOG_ERROR("failed to create swapchain");
         goto fail;
     }
 
     if(old_swapchain != NULL) {
-        vkDestroySwapchainKHR(device, old_swapchain, NULL);
+        vkDestroySwapchainKHR(device, old_swapchain, allocator);
     }
 
     /* get swapchain images */
@@ -501,7 +869,7 @@ i32 create_swapchain(
             }
         };
 
-        if(vkCreateImageView(device, &image_view_info, NULL, &swapchain_image_views[i]) != VK_SUCCESS) {
+        if(vkCreateImageView(device, &image_view_info, allocator, &swapchain_image_views[i]) != VK_SUCCESS) {
             LOG_ERROR("failed to create vulkan swapchain image view %u/%u", i, swapchain_new_image_count);
         }
     }
@@ -519,6 +887,281 @@ i32 create_swapchain(
 
 /* GLOBAL INTERFACE */
 
+/* RESOURCE HANDLES */
+
+/* generation 0 is left to static resources */
+u32 next_generation(
+    u32 generation
+) {
+    const u32 next = (generation + 1) & GPU_HANDLE_SLOT_MASK;
+    return (next == 0) ? 1 : next;
+}
+
+u32 resources_buffer_slot(
+    const VulkanResources* vulkan_resources,
+    u32                    buffer_id
+) {
+    const u32 slot       = buffer_id & GPU_HANDLE_SLOT_MASK;
+    const u32 generation = buffer_id >> GPU_HANDLE_GENERATION_SHIFT;
+
+    if(
+        slot >= vulkan_resources->buffers_count ||
+        vulkan_resources->buffers[slot].buffer == NULL ||
+        vulkan_resources->buffer_generations[slot] != generation
+    ) {
+        return U32_MAX;
+    }
+    return slot;
+}
+
+u32 resources_image_slot(
+    const VulkanResources* vulkan_resources,
+    u32                    image_id
+) {
+    const u32 slot       = image_id & GPU_HANDLE_SLOT_MASK;
+    const u32 generation = image_id >> GPU_HANDLE_GENERATION_SHIFT;
+
+    if(
+        slot >= vulkan_resources->images_count ||
+        vulkan_resources->images[slot].image == NULL ||
+        vulkan_resources->image_generations[slot] != generation
+    ) {
+        return U32_MAX;
+    }
+    return slot;
+}
+
+/* late latch buffers live in host memory */
+void destroy_gpu_buffer(
+    VulkanDevice* vulkan_device,
+    GpuBuffer*    buffer
+) {
+    GpuVideoMemoryAllocation* buffer_memory = (buffer->frame_stride != 0) ?
+        &vulkan_device->video_memory_host_transfer :
+        &vulkan_device->video_memory_device_buffers;
+
+    vkDestroyBuffer(vulkan_device->device, buffer->buffer, vulkan_device->allocator);
+    video_memory_free(vulkan_device, buffer_memory, buffer->allocation_id);
+
+    *buffer = (GpuBuffer){0};
+}
+
+/* transient images are freed with their shared block */
+void destroy_gpu_image(
+    VulkanDevice* vulkan_device,
+    GpuImage*     image
+) {
+    vkDestroyImageView(vulkan_device->device, image->view, vulkan_device->allocator);
+    vkDestroyImage(vulkan_device->device, image->image, vulkan_device->allocator);
+    if(image->lazy_memory != NULL) {
+        vkFreeMemory(vulkan_device->device, image->lazy_memory, vulkan_device->allocator);
+    }
+    video_memory_free(vulkan_device, &vulkan_device->video_memory_device_images, image->allocation_id);
+
+    *image = (GpuImage){0};
+}
+
+void resources_retire(
+    VulkanDevice*    vulkan_device,
+    VulkanResources* vulkan_resources,
+    u64              frame_completed
+) {
+    u32 retired_count = 0;
+
+    /* kept in destroy order, so the oldest stays first */
+    for(u32 i = 0; i != vulkan_resources->retired_count; i++) {
+        const GpuRetiredResource retired = vulkan_resources->retired[i];
+
+        if(retired.frame_value > frame_completed) {
+            vulkan_resources->retired[retired_count++] = retired;
+            continue;
+        }
+        if(retired.is_image) {
+            destroy_gpu_image(vulkan_device, &vulkan_resources->images[retired.slot]);
+        }
+        else {
+            destroy_gpu_buffer(vulkan_device, &vulkan_resources->buffers[retired.slot]);
+        }
+    }
+    vulkan_resources->retired_count = retired_count;
+}
+
+/* slot stays taken until the frames that could use it retired, handle goes stale right away */
+b32 retire_resource(
+    GpuContext* gpu_ctx,
+    b32         is_image,
+    u32         slot
+) {
+    VulkanDevice*       vulkan_device    = &gpu_ctx->vulkan_device;
+    VulkanResources*    vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanRender* vulkan_render    = &gpu_ctx->vulkan_render;
+
+    /* without render nothing can be in flight */
+    if(vulkan_render->semaphore_frame_timeline == NULL) {
+        if(is_image) {
+            destroy_gpu_image(vulkan_device, &vulkan_resources->images[slot]);
+        }
+        else {
+            destroy_gpu_buffer(vulkan_device, &vulkan_resources->buffers[slot]);
+        }
+    }
+    else {
+        if(vulkan_resources->retired_count == GPU_MAX_RETIRED_RESOURCES) {
+            resources_retire(vulkan_device, vulkan_resources, gpu_render_frame_completed((CtxHandle)gpu_ctx));
+        }
+        if(vulkan_resources->retired_count == GPU_MAX_RETIRED_RESOURCES) {
+            LOG_ERROR("too many resources waiting for retire: %u/%u", vulkan_resources->retired_count, GPU_MAX_RETIRED_RESOURCES);
+            goto fail;
+        }
+
+        /* current frame is the last one that could have used it */
+        vulkan_resources->retired[vulkan_resources->retired_count++] = (GpuRetiredResource) {
+            .frame_value = vulkan_render->frame_counter,
+            .is_image    = is_image,
+            .slot        = slot
+        };
+    }
+
+    if(is_image) {
+        vulkan_resources->image_generations[slot] = next_generation(vulkan_resources->image_generations[slot]);
+    }
+    else {
+        vulkan_resources->buffer_generations[slot] = next_generation(vulkan_resources->buffer_generations[slot]);
+    }
+
+    /* bakes could have recorded it */
+    gpu_render_bake_invalidate((CtxHandle)gpu_ctx);
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* transient images are laid out again when one of them changes size, their block is replaced */
+b32 resize_surface_images(
+    GpuContext* gpu_ctx
+) {
+    VulkanDevice*    vulkan_device       = &gpu_ctx->vulkan_device;
+    VulkanResources* vulkan_resources    = &gpu_ctx->vulkan_resources;
+    VulkanRender*    vulkan_render       = &gpu_ctx->vulkan_render;
+    GpuImage*        images              = vulkan_resources->images;
+    const u32        static_images_count = vulkan_resources->static_images_count;
+
+    ImageInfo image_infos[GPU_MAX_STATIC_IMAGES];
+    u32       images_mask      = 0;
+    b32       resize_transient = FALSE;
+    u32       resized_count    = 0;
+
+    /* static images, only surface relative ones change size */
+    for(u32 i = 0; i != static_images_count; i++) {
+        image_infos[i] = resolve_image_info(vulkan_resources, &vulkan_resources->image_infos[i]);
+        if(image_infos[i].size_x != images[i].size_x || image_infos[i].size_y != images[i].size_y) {
+            images_mask     |= 0x1 << i;
+            resize_transient = resize_transient || images[i].transient;
+        }
+    }
+    if(resize_transient) {
+        for(u32 i = 0; i != static_images_count; i++) {
+            if(images[i].transient) {
+                images_mask |= 0x1 << i;
+            }
+        }
+    }
+
+    if(images_mask != 0) {
+        for(u32 i = 0; i != static_images_count; i++) {
+            if(images_mask & (0x1 << i)) {
+                destroy_gpu_image(vulkan_device, &images[i]);
+                resized_count++;
+            }
+        }
+        if(resize_transient) {
+            video_memory_free(vulkan_device, &vulkan_device->video_memory_device_images, vulkan_resources->transient_allocation_id);
+            vulkan_resources->transient_allocation_id = U32_MAX;
+        }
+
+        u32 transient_allocation_id = U32_MAX;
+        if(!create_images(
+            vulkan_device,
+            image_infos,
+            static_images_count,
+            images_mask,
+            images,
+            &transient_allocation_id
+        )) {
+            LOG_ERROR("failed to recreate surface relative images");
+            goto fail;
+        }
+        if(resize_transient) {
+            vulkan_resources->transient_allocation_id = transient_allocation_id;
+        }
+
+        for(u32 i = 0; i != static_images_count; i++) {
+            if(images_mask & (0x1 << i)) {
+                vulkan_render->image_states[i] = (GpuImageState) {
+                    .access = VK_ACCESS_2_NONE,
+                    .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    .stage  = VK_PIPELINE_STAGE_2_NONE
+                };
+            }
+        }
+    }
+
+    /* runtime images */
+    for(u32 i = static_images_count; i != vulkan_resources->images_count; i++) {
+        if(images[i].image == NULL) {
+            continue;
+        }
+
+        const ImageInfo image_info = resolve_image_info(vulkan_resources, &vulkan_resources->image_infos[i]);
+        if(image_info.size_x == images[i].size_x && image_info.size_y == images[i].size_y) {
+            continue;
+        }
+
+        destroy_gpu_image(vulkan_device, &images[i]);
+
+        u32 transient_allocation_id = U32_MAX;
+        if(!create_images(
+            vulkan_device,
+            &image_info,
+            1,
+            0x1,
+            &images[i],
+            &transient_allocation_id
+        )) {
+            LOG_ERROR("failed to recreate surface relative image id: %u", i);
+            goto fail;
+        }
+
+        vulkan_render->image_states[i] = (GpuImageState) {
+            .access = VK_ACCESS_2_NONE,
+            .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .stage  = VK_PIPELINE_STAGE_2_NONE
+        };
+        resized_count++;
+    }
+
+    /* descriptors still point to the destroyed views */
+    if(resized_count != 0) {
+        if(!shaders_rewrite_bindings(gpu_ctx)) {
+            LOG_ERROR("failed to rewrite bindings of surface relative images");
+            goto fail;
+        }
+        LOG_MESSAGE(
+            "surface relative images recreated: %u size: %ux%u", 
+            resized_count, vulkan_resources->swapchain_x, vulkan_resources->swapchain_y
+        );
+    }
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
 b32 gpu_allocate_resources(
     CtxHandle            ctx, 
     const ResourcesInfo* resources_info
@@ -530,12 +1173,15 @@ b32 gpu_allocate_resources(
 
     GpuContext*          gpu_ctx          = (GpuContext*)ctx;
     const VulkanObjects* vulkan_objects   = &gpu_ctx->vulkan_objects;
-    const VulkanDevice*  vulkan_device    = &gpu_ctx->vulkan_device;
+    VulkanDevice*        vulkan_device    = &gpu_ctx->vulkan_device;
     VulkanResources*     vulkan_resources = &gpu_ctx->vulkan_resources;
 
+    vulkan_resources->transient_allocation_id = U32_MAX;
+
     /* swapchain */
     if(create_swapchain(
         vulkan_device->device,
+        vulkan_device->allocator,
         vulkan_device->adapter->physical_device,
         vulkan_objects->surface,
         vulkan_device->adapter->surface_format,
@@ -551,29 +1197,14 @@ b32 gpu_allocate_resources(
         goto fail;
     }
 
-    /* memory sections */
-    GpuMemorySection device_buffers_memory = (GpuMemorySection) {
-        .memory = vulkan_device->video_memory_device_buffers.device_memory,
-        .offset = 0,
-        .limit  = VRAM_SIZE_DEVICE_BUFFERS
-    };
-    GpuMemorySection device_images_memory = (GpuMemorySection) {
-        .memory = vulkan_device->video_memory_device_images.device_memory,
-        .offset = 0,
-        .limit  = VRAM_SIZE_DEVICE_IMAGES
-    };
-    GpuMemorySection host_transfer_memory = (GpuMemorySection) {
-        .memory = vulkan_device->video_memory_host_transfer.device_memory,
-        .offset = 0,
-        .limit  = VRAM_SIZE_HOST_TRANSFER
-    };
-
     /* buffers */
     if(resources_info->buffer_infos_count != 0) {
-        vulkan_resources->buffers_count = resources_info->buffer_infos_count;
+        vulkan_resources->buffers_count        = resources_info->buffer_infos_count;
+        vulkan_resources->static_buffers_count = resources_info->buffer_infos_count;
         if(!create_buffers(
-            vulkan_device->device, 
-            &device_buffers_memory, 
+            vulkan_device, 
+            vulkan_device->frames_in_flight,
+            vulkan_device->adapter->uniform_offset_alignment,
             resources_info->buffer_infos, 
             resources_info->buffer_infos_count, 
             vulkan_resources->buffers
@@ -584,31 +1215,54 @@ b32 gpu_allocate_resources(
     }
     /* images */
     if(resources_info->image_infos_count != 0) {
-        vulkan_resources->images_count = resources_info->image_infos_count;
+        if(resources_info->image_infos_count > GPU_MAX_STATIC_IMAGES) {
+            LOG_ERROR("too many static images: %u/%u", resources_info->image_infos_count, GPU_MAX_STATIC_IMAGES);
+            goto fail;
+        }
+
+        vulkan_resources->images_count        = resources_info->image_infos_count;
+        vulkan_resources->static_images_count = resources_info->image_infos_count;
+
+        ImageInfo image_infos[GPU_MAX_STATIC_IMAGES];
+        for(u32 i = 0; i != resources_info->image_infos_count; i++) {
+            vulkan_resources->image_infos[i] = resources_info->image_infos[i];
+            image_infos[i]                   = resolve_image_info(vulkan_resources, &resources_info->image_infos[i]);
+        }
+
         if(!create_images(
-            vulkan_device->device,
-            &device_images_memory,
-            resources_info->image_infos,
+            vulkan_device,
+            image_infos,
             resources_info->image_infos_count,
-            vulkan_resources->images
+            U32_MAX,
+            vulkan_resources->images,
+            &vulkan_resources->transient_allocation_id
         )) {
             LOG_ERROR("failed to create images");
             goto fail;
         }
     }
     /* FIX: transfer */
-    if(vulkan_device->video_memory_host_transfer.device_memory != NULL) {
+    if(vulkan_device->video_memory_host_transfer.blocks_count != 0) {
         if(!create_transfer_buffers(
-            vulkan_device->device,
-            &host_transfer_memory,
-            &vulkan_resources->buffer_sync_transfer
+            vulkan_device,
+            vulkan_device->frames_in_flight,
+            &vulkan_resources->buffer_upload_ring,
+            &vulkan_resources->buffer_stream_ring
         )) {
             LOG_ERROR("failed to create transfer buffers");
+            goto fail;
+        }
+    }
+    if(vulkan_device->video_memory_host_readback.blocks_count != 0) {
+        if(!create_readback_buffer(vulkan_device, &vulkan_resources->buffer_readback_ring)) {
+            LOG_ERROR("failed to create readback buffer");
+            goto fail;
         }
     }
     /* samplers */
     if(!create_samplers(
         vulkan_device->device,
+        vulkan_device->allocator,
         &vulkan_resources->sampler_linear_repeat,
         &vulkan_resources->sampler_linear_clamp,
         &vulkan_resources->sampler_nearest_repeat,
@@ -633,45 +1287,254 @@ void gpu_release_resources(
         goto fail;
     }
 
-    GpuContext*          gpu_ctx          = (GpuContext*)ctx;
-    VulkanResources*     vulkan_resources = &gpu_ctx->vulkan_resources;
-    const VkDevice       device           = gpu_ctx->vulkan_device.device;
+    GpuContext*               gpu_ctx          = (GpuContext*)ctx;
+    VulkanDevice*             vulkan_device    = &gpu_ctx->vulkan_device;
+    VulkanResources*          vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VkDevice            device           = vulkan_device->device;
+    GpuVideoMemoryAllocation* images_memory    = &vulkan_device->video_memory_device_images;
+    GpuVideoMemoryAllocation* transfer_memory  = &vulkan_device->video_memory_host_transfer;
 
     /* samplers */
-    vkDestroySampler(device, vulkan_resources->sampler_linear_repeat , NULL);
-    vkDestroySampler(device, vulkan_resources->sampler_linear_clamp  , NULL);
-    vkDestroySampler(device, vulkan_resources->sampler_nearest_repeat, NULL);
-    vkDestroySampler(device, vulkan_resources->sampler_nearest_clamp , NULL);
+    vkDestroySampler(device, vulkan_resources->sampler_linear_repeat , vulkan_device->allocator);
+    vkDestroySampler(device, vulkan_resources->sampler_linear_clamp  , vulkan_device->allocator);
+    vkDestroySampler(device, vulkan_resources->sampler_nearest_repeat, vulkan_device->allocator);
+    vkDestroySampler(device, vulkan_resources->sampler_nearest_clamp , vulkan_device->allocator);
 
     /* transfer buffers */
-    if(vulkan_resources->buffer_sync_transfer.buffer != NULL) {
-        vkDestroyBuffer(device, vulkan_resources->buffer_sync_transfer.buffer, NULL);
+    if(vulkan_resources->buffer_upload_ring.buffer != NULL) {
+        vkDestroyBuffer(device, vulkan_resources->buffer_upload_ring.buffer, vulkan_device->allocator);
+        video_memory_free(vulkan_device, transfer_memory, vulkan_resources->buffer_upload_ring.allocation_id);
+    }
+    if(vulkan_resources->buffer_stream_ring.buffer != NULL) {
+        vkDestroyBuffer(device, vulkan_resources->buffer_stream_ring.buffer, vulkan_device->allocator);
+        video_memory_free(vulkan_device, transfer_memory, vulkan_resources->buffer_stream_ring.allocation_id);
+    }
+    if(vulkan_resources->buffer_readback_ring.buffer != NULL) {
+        vkDestroyBuffer(device, vulkan_resources->buffer_readback_ring.buffer, vulkan_device->allocator);
+        video_memory_free(vulkan_device, &vulkan_device->video_memory_host_readback, vulkan_resources->buffer_readback_ring.allocation_id);
     }
 
-    /* buffers */
-    const GpuBuffer* buffers       = vulkan_resources->buffers;
-    const u32        buffers_count = vulkan_resources->buffers_count;
+    /* buffers, retired ones still hold their slots */
+    GpuBuffer* buffers       = vulkan_resources->buffers;
+    const u32  buffers_count = vulkan_resources->buffers_count;
     for(u32 i = 0; i != buffers_count; i++) {
-        vkDestroyBuffer(device, buffers[i].buffer, NULL);
+        if(buffers[i].buffer != NULL) {
+            destroy_gpu_buffer(vulkan_device, &buffers[i]);
+        }
     }
 
     /* images */
-    const GpuImage* images       = vulkan_resources->images;
-    const u32       images_count = vulkan_resources->images_count;
+    GpuImage* images       = vulkan_resources->images;
+    const u32 images_count = vulkan_resources->images_count;
     for(u32 i = 0; i != images_count; i++) {
-        vkDestroyImageView(device, images[i].view, NULL);
-        vkDestroyImage(device, images[i].image, NULL);
+        if(images[i].image != NULL) {
+            destroy_gpu_image(vulkan_device, &images[i]);
+        }
+    }
+    if(vulkan_resources->static_images_count != 0) {
+        video_memory_free(vulkan_device, images_memory, vulkan_resources->transient_allocation_id);
     }
 
     /* swapchain */
     const VkImageView* swapchain_image_views       = vulkan_resources->swapchain_views;
     const u32          swapchain_image_views_count = vulkan_resources->swapchain_images_count;
     for(u32 i = 0; i != swapchain_image_views_count; i++) {
-        vkDestroyImageView(device, swapchain_image_views[i], NULL);
+        vkDestroyImageView(device, swapchain_image_views[i], vulkan_device->allocator);
     }
-    vkDestroySwapchainKHR(device, vulkan_resources->swapchain, NULL);
+    vkDestroySwapchainKHR(device, vulkan_resources->swapchain, vulkan_device->allocator);
 
     *vulkan_resources = (VulkanResources){0};
 
     fail: {};
 }
+
+u32 gpu_create_buffer(
+    CtxHandle         ctx,
+    const BufferInfo* buffer_info
+) {
+    if(ctx == NULL || buffer_info == NULL) {
+        LOG_ERROR("input params are NULL");
+        goto fail;
+    }
+
+    GpuContext*      gpu_ctx          = (GpuContext*)ctx;
+    VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanRender*    vulkan_render    = &gpu_ctx->vulkan_render;
+
+    /* first free runtime slot */
+    u32 slot = U32_MAX;
+    for(u32 i = vulkan_resources->static_buffers_count; i != GPU_MAX_BUFFERS; i++) {
+        if(vulkan_resources->buffers[i].buffer == NULL) {
+            slot = i;
+            break;
+        }
+    }
+    if(slot == U32_MAX) {
+        LOG_ERROR("too many buffers: %u/%u", GPU_MAX_BUFFERS, GPU_MAX_BUFFERS);
+        goto fail;
+    }
+
+    if(!create_buffers(
+        vulkan_device,
+        vulkan_device->frames_in_flight,
+        vulkan_device->adapter->uniform_offset_alignment,
+        buffer_info,
+        1,
+        &vulkan_resources->buffers[slot]
+    )) {
+        LOG_ERROR("failed to create buffer");
+        goto fail;
+    }
+
+    const u32 generation = next_generation(vulkan_resources->buffer_generations[slot]);
+
+    vulkan_resources->buffer_generations[slot] = generation;
+    vulkan_resources->buffers_count            = MAX(vulkan_resources->buffers_count, slot + 1);
+    /* previous owner of the slot retired, there is nothing to wait on */
+    vulkan_render->buffer_states[slot]         = (GpuBufferState){0};
+
+    return slot | (generation << GPU_HANDLE_GENERATION_SHIFT);
+
+    fail: {
+        return U32_MAX;
+    }
+}
+
+u32 gpu_create_image(
+    CtxHandle        ctx,
+    const ImageInfo* image_info
+) {
+    if(ctx == NULL || image_info == NULL) {
+        LOG_ERROR("input params are NULL");
+        goto fail;
+    }
+
+    GpuContext*      gpu_ctx          = (GpuContext*)ctx;
+    VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    VulkanRender*    vulkan_render    = &gpu_ctx->vulkan_render;
+
+    /* aliasing is planned over the static frame only */
+    if(image_info->flags & GPU_IMAGE_FLAG_TRANSIENT) {
+        LOG_ERROR("runtime images can't be transient");
+        goto fail;
+    }
+
+    /* first free runtime slot */
+    u32 slot = U32_MAX;
+    for(u32 i = vulkan_resources->static_images_count; i != GPU_MAX_IMAGES; i++) {
+        if(vulkan_resources->images[i].image == NULL) {
+            slot = i;
+            break;
+        }
+    }
+    if(slot == U32_MAX) {
+        LOG_ERROR("too many images: %u/%u", GPU_MAX_IMAGES, GPU_MAX_IMAGES);
+        goto fail;
+    }
+
+    u32             transient_allocation_id = U32_MAX;
+    const ImageInfo resolved_image_info     = resolve_image_info(vulkan_resources, image_info);
+    if(!create_images(
+        vulkan_device,
+        &resolved_image_info,
+        1,
+        0x1,
+        &vulkan_resources->images[slot],
+        &transient_allocation_id
+    )) {
+        LOG_ERROR("failed to create image");
+        if(vulkan_resources->images[slot].image != NULL) {
+            destroy_gpu_image(vulkan_device, &vulkan_resources->images[slot]);
+        }
+        goto fail;
+    }
+
+    const u32 generation = next_generation(vulkan_resources->image_generations[slot]);
+
+    vulkan_resources->image_generations[slot] = generation;
+    vulkan_resources->image_infos[slot]       = *image_info;
+    vulkan_resources->images_count            = MAX(vulkan_resources->images_count, slot + 1);
+    /* contents start undefined, previous owner of the slot retired */
+    vulkan_render->image_states[slot]         = (GpuImageState) {
+        .access = VK_ACCESS_2_NONE,
+        .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .stage  = VK_PIPELINE_STAGE_2_NONE
+    };
+    vulkan_render->images_persistent[slot]    = vulkan_resources->images[slot].persistent;
+
+    return slot | (generation << GPU_HANDLE_GENERATION_SHIFT);
+
+    fail: {
+        return U32_MAX;
+    }
+}
+
+void gpu_destroy_buffer(
+    CtxHandle ctx,
+    u32       buffer_id
+) {
+    if(ctx == NULL) {
+        LOG_ERROR("input params are NULL");
+        goto fail;
+    }
+
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanUpload*    vulkan_upload    = &gpu_ctx->vulkan_upload;
+
+    const u32 slot = resources_buffer_slot(vulkan_resources, buffer_id);
+    if(slot == U32_MAX) {
+        LOG_ERROR("invalid buffer id: %u", buffer_id);
+        goto fail;
+    }
+    if(slot < vulkan_resources->static_buffers_count) {
+        LOG_ERROR("static buffers are freed with resources id: %u", buffer_id);
+        goto fail;
+    }
+    if(upload_is_pending(vulkan_upload, FALSE, slot)) {
+        LOG_ERROR("buffer has pending uploads id: %u", buffer_id);
+        goto fail;
+    }
+    if(!retire_resource(gpu_ctx, FALSE, slot)) {
+        LOG_ERROR("failed to destroy buffer id: %u", buffer_id);
+        goto fail;
+    }
+
+    fail: {}
+}
+
+void gpu_destroy_image(
+    CtxHandle ctx,
+    u32       image_id
+) {
+    if(ctx == NULL) {
+        LOG_ERROR("input params are NULL");
+        goto fail;
+    }
+
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanUpload*    vulkan_upload    = &gpu_ctx->vulkan_upload;
+
+    const u32 slot = resources_image_slot(vulkan_resources, image_id);
+    if(slot == U32_MAX) {
+        LOG_ERROR("invalid image id: %u", image_id);
+        goto fail;
+    }
+    if(slot < vulkan_resources->static_images_count) {
+        LOG_ERROR("static images are freed with resources id: %u", image_id);
+        goto fail;
+    }
+    if(upload_is_pending(vulkan_upload, TRUE, slot)) {
+        LOG_ERROR("image has pending uploads id: %u", image_id);
+        goto fail;
+    }
+    if(!retire_resource(gpu_ctx, TRUE, slot)) {
+        LOG_ERROR("failed to destroy image id: %u", image_id);
+        goto fail;
+    }
+
+    fail: {}
+}
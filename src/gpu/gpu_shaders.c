@@ -3,31 +3,34 @@
 extern const VkFormat format_conversion_table[GPU_FORMAT_COUNT];
 
 const VkDescriptorPoolSize descriptor_pool_sizes[] = {
-    {VK_DESCRIPTOR_TYPE_SAMPLER       , GPU_DESCRIPTOR_SET_COUNT + 4},
-    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GPU_MAX_STATIC_BUFFERS      },
-    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GPU_MAX_STATIC_BUFFERS      },
-    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  GPU_MAX_STATIC_IMAGES       },
-    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  GPU_MAX_STATIC_IMAGES       }
+    {VK_DESCRIPTOR_TYPE_SAMPLER               , GPU_DESCRIPTOR_SET_COUNT + 4},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER        , GPU_MAX_STATIC_BUFFERS      },
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER        , GPU_MAX_STATIC_BUFFERS      },
+    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE         , GPU_MAX_STATIC_IMAGES       },
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE         , GPU_MAX_STATIC_IMAGES       },
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, GPU_MAX_DYNAMIC_BINDINGS    }
 };
 
 const VkDescriptorType descriptor_type_conversion_table[GPU_DESCRIPTOR_TYPE_COUNT] = {
-    [GPU_DESCRIPTOR_TYPE_NONE          ] = VK_DESCRIPTOR_TYPE_MAX_ENUM,
-    [GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER] = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    [GPU_DESCRIPTOR_TYPE_STORAGE_BUFFER] = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-    [GPU_DESCRIPTOR_TYPE_SAMPLED_IMAGE ] = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-    [GPU_DESCRIPTOR_TYPE_STORAGE_IMAGE ] = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-    [GPU_DESCRIPTOR_TYPE_SAMPLER       ] = VK_DESCRIPTOR_TYPE_SAMPLER
+    [GPU_DESCRIPTOR_TYPE_NONE                  ] = VK_DESCRIPTOR_TYPE_MAX_ENUM,
+    [GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER        ] = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+    [GPU_DESCRIPTOR_TYPE_STORAGE_BUFFER        ] = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    [GPU_DESCRIPTOR_TYPE_SAMPLED_IMAGE         ] = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    [GPU_DESCRIPTOR_TYPE_STORAGE_IMAGE         ] = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+    [GPU_DESCRIPTOR_TYPE_SAMPLER               ] = VK_DESCRIPTOR_TYPE_SAMPLER,
+    [GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC] = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
 };
 
 VkPipeline create_grpahics_pipeline(
-    VkDevice         device,
-    VkFormat         surface_format,
-    VkPipelineLayout pipeline_layout,
-    VkShaderModule   module_vertex,
-    VkShaderModule   module_fragment,
-    const GpuFormat* color_formats,
-    u32              color_formats_count,
-    GpuFormat        depth_format
+    VkDevice                     device,
+    const VkAllocationCallbacks* allocator,
+    VkFormat                     surface_format,
+    VkPipelineLayout             pipeline_layout,
+    VkShaderModule               module_vertex,
+    VkShaderModule               module_fragment,
+    const GpuFormat*             color_formats,
+    u32                          color_formats_count,
+    GpuFormat                    depth_format
 ) {
     /* convert attachment formats */
     VkFormat  attachments_color[GPU_MAX_COLOR_ATTACHMENTS] = {0};
@@ -180,7 +183,7 @@ VkPipeline create_grpahics_pipeline(
 
     VkPipeline graphics_pipeline = NULL;
 
-    if(vkCreateGraphicsPipelines(device, NULL, 1, &graphics_pipeline_info, NULL, &graphics_pipeline) != VK_SUCCESS) {
+    if(vkCreateGraphicsPipelines(device, NULL, 1, &graphics_pipeline_info, allocator, &graphics_pipeline) != VK_SUCCESS) {
         LOG_ERROR("failed to create graphics pipeline");
         goto fail;
     }
@@ -193,9 +196,10 @@ VkPipeline create_grpahics_pipeline(
 }
 
 VkPipeline create_compute_pipeline(
-    VkDevice         device,
-    VkPipelineLayout pipeline_layout,
-    VkShaderModule   module_compute
+    VkDevice                     device,
+    const VkAllocationCallbacks* allocator,
+    VkPipelineLayout             pipeline_layout,
+    VkShaderModule               module_compute
 ) {
     const VkComputePipelineCreateInfo compute_pipeline_info = {
         .sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -212,7 +216,7 @@ VkPipeline create_compute_pipeline(
 
     VkPipeline compute_pipeline = NULL;
 
-    if(vkCreateComputePipelines(device, NULL, 1, &compute_pipeline_info, NULL, &compute_pipeline) != VK_SUCCESS) {
+    if(vkCreateComputePipelines(device, NULL, 1, &compute_pipeline_info, allocator, &compute_pipeline) != VK_SUCCESS) {
         LOG_ERROR("failed to create compute pipeline");
         goto fail;
     }
@@ -225,12 +229,13 @@ VkPipeline create_compute_pipeline(
 }
 
 b32 create_pipelines(
-    VkDevice            device,
-    VkFormat            surface_format,
-    VkPipelineLayout    pipeline_layout,
-    const PipelineInfo* pipeline_infos,
-    u32                 pipeline_infos_count,
-    VkPipeline*         pipelines
+    VkDevice                     device,
+    const VkAllocationCallbacks* allocator,
+    VkFormat                     surface_format,
+    VkPipelineLayout             pipeline_layout,
+    const PipelineInfo*          pipeline_infos,
+    u32                          pipeline_infos_count,
+    VkPipeline*                  pipelines
 ) {
     for(u32 i = 0; i != pipeline_infos_count; i++) {
         /* graphics pipeline */
@@ -264,11 +269,11 @@ b32 create_pipelines(
             VkShaderModule module_vertex   = NULL;
             VkShaderModule module_fragment = NULL;
 
-            if(vkCreateShaderModule(device, &module_vertex_info, NULL, &module_vertex) != VK_SUCCESS) {
+            if(vkCreateShaderModule(device, &module_vertex_info, allocator, &module_vertex) != VK_SUCCESS) {
                 LOG_ERROR("failed to create vertex shader module id: %u/%u", i, pipeline_infos_count);
                 goto fail;
             }
-            if(vkCreateShaderModule(device, &module_fragment_info, NULL, &module_fragment) != VK_SUCCESS) {
+            if(vkCreateShaderModule(device, &module_fragment_info, allocator, &module_fragment) != VK_SUCCESS) {
                 LOG_ERROR("failed to create fragment shader module id: %u/%u", i, pipeline_infos_count);
                 goto fail;
             }
@@ -276,6 +281,7 @@ b32 create_pipelines(
             /* create pipeline */
             pipelines[i] = create_grpahics_pipeline(
                 device,
+                allocator,
                 surface_format,
                 pipeline_layout,
                 module_vertex,
@@ -289,8 +295,8 @@ b32 create_pipelines(
                 goto fail;
             }
 
-            vkDestroyShaderModule(device, module_vertex  , NULL);
-            vkDestroyShaderModule(device, module_fragment, NULL);
+            vkDestroyShaderModule(device, module_vertex  , allocator);
+            vkDestroyShaderModule(device, module_fragment, allocator);
         }
         /* compute pipeline */
         if(pipeline_infos[i].type == GPU_PIPELINE_TYPE_COMPUTE) {
@@ -317,7 +323,7 @@ b32 create_pipelines(
             
             VkShaderModule module_compute = NULL;
 
-            if(vkCreateShaderModule(device, &module_compute_info, NULL, &module_compute) != VK_SUCCESS) {
+            if(vkCreateShaderModule(device, &module_compute_info, allocator, &module_compute) != VK_SUCCESS) {
                 LOG_ERROR("failed to create compute shader module id: %u/%u", i, pipeline_infos_count);
                 goto fail;
             }
@@ -325,6 +331,7 @@ b32 create_pipelines(
             /* create pipeline */
             pipelines[i] = create_compute_pipeline(
                 device,
+                allocator,
                 pipeline_layout,
                 module_compute
             );
@@ -333,7 +340,7 @@ b32 create_pipelines(
                 goto fail;
             }
 
-            vkDestroyShaderModule(device, module_compute, NULL);
+            vkDestroyShaderModule(device, module_compute, allocator);
         }
     }
 
@@ -345,13 +352,16 @@ b32 create_pipelines(
 }
 
 b32 create_descriptors(
-    VkDevice                  device,
-    const DescriptorSetInfo*  descriptor_set_infos,
-    VkDescriptorPool*         descriptor_pool,
-    VkDescriptorSet*          descriptor_sets,
-    VkDescriptorSetLayout*    descriptor_set_layouts,
-    VkDescriptorType*         descriptor_types,
-    VkPipelineLayout*         pipeline_layout
+    VkDevice                     device,
+    const VkAllocationCallbacks* allocator,
+    const DescriptorSetInfo*     descriptor_set_infos,
+    VkDescriptorPool*            descriptor_pool,
+    VkDescriptorSet*             descriptor_sets,
+    VkDescriptorSetLayout*       descriptor_set_layouts,
+    VkDescriptorType*            descriptor_types,
+    u32*                         dynamic_bindings,
+    u32*                         dynamic_bindings_count,
+    VkPipelineLayout*            pipeline_layout
 ) {
     /* create descriptor pool */
     const VkDescriptorPoolCreateInfo descriptor_pool_info = {
@@ -361,7 +371,7 @@ b32 create_descriptors(
         .pPoolSizes    = descriptor_pool_sizes
     };
 
-    if(vkCreateDescriptorPool(device, &descriptor_pool_info, NULL, descriptor_pool) != VK_SUCCESS) {
+    if(vkCreateDescriptorPool(device, &descriptor_pool_info, allocator, descriptor_pool) != VK_SUCCESS) {
         LOG_ERROR("failed to create descriptor pool");
         goto fail;
     }
@@ -370,6 +380,7 @@ b32 create_descriptors(
     for(u32 i = 0; i != GPU_DESCRIPTOR_SET_COUNT * GPU_MAX_BINDINGS_PER_DESCRIPTOR; i++) {
         descriptor_types[i] = VK_DESCRIPTOR_TYPE_MAX_ENUM;
     }
+    *dynamic_bindings_count = 0;
 
     /* create descriptor set layouts */
     for(u32 i = 0; i != GPU_DESCRIPTOR_SET_COUNT; i++) {
@@ -411,6 +422,15 @@ b32 create_descriptors(
                     };
 
                     descriptor_types[j + i * GPU_MAX_BINDINGS_PER_DESCRIPTOR] = type;
+
+                    /* sets and bindings are walked in the order dynamic offsets are consumed */
+                    if(type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+                        if(*dynamic_bindings_count == GPU_MAX_DYNAMIC_BINDINGS) {
+                            LOG_ERROR("too many dynamic bindings set id: %u binding id: %u", i, j);
+                            goto fail;
+                        }
+                        dynamic_bindings[(*dynamic_bindings_count)++] = j + i * GPU_MAX_BINDINGS_PER_DESCRIPTOR;
+                    }
                 } 
                 else {
                     LOG_ERROR(
@@ -429,7 +449,7 @@ b32 create_descriptors(
             .bindingCount = bindings_count
         };
 
-        if(vkCreateDescriptorSetLayout(device, &set_layout_info, NULL, &descriptor_set_layouts[i]) != VK_SUCCESS) {
+        if(vkCreateDescriptorSetLayout(device, &set_layout_info, allocator, &descriptor_set_layouts[i]) != VK_SUCCESS) {
             LOG_ERROR("failed to create descriptor set layout id: %u/%u", i, GPU_DESCRIPTOR_SET_COUNT);
             goto fail;
         }
@@ -462,7 +482,7 @@ b32 create_descriptors(
         .setLayoutCount         = GPU_DESCRIPTOR_SET_COUNT
     };
 
-    if(vkCreatePipelineLayout(device, &pipeline_layout_info, NULL, pipeline_layout) != VK_SUCCESS) {
+    if(vkCreatePipelineLayout(device, &pipeline_layout_info, allocator, pipeline_layout) != VK_SUCCESS) {
         LOG_ERROR("failed to create pipeline layout");
         goto fail;
     }
@@ -494,38 +514,40 @@ b32 gpu_compile_shaders(
     const VulkanDevice*  vulkan_device  = &gpu_ctx->vulkan_device;
     VulkanShaders*       vulkan_shaders = &gpu_ctx->vulkan_shaders;
 
-    /* commit resource memory */
-    void*       commit_base = gpu_ctx->resources_base + GPU_VIRTUAL_SHADERS_BASE;
-    const u64   commit_size = ALIGN(shaders_info->pipeline_infos_count * sizeof(VkPipeline), 0x1000);
-
-    if(commit_size > GPU_VIRTUAL_SHADERS_LIMIT - GPU_VIRTUAL_SHADERS_BASE) {
+    /* pipeline handles live until gpu_release_shaders */
+    VkPipeline* pipelines = arena_push(&gpu_ctx->arena_shaders, shaders_info->pipeline_infos_count * sizeof(VkPipeline), 0);
+    if(pipelines == NULL) {
         LOG_ERROR("exceed shaders virtual space");
         goto fail;
     }
-    if(VirtualAlloc(commit_base, commit_size, MEM_COMMIT, PAGE_READWRITE) == NULL) {
-        LOG_ERROR("failed to commit shaders memory");
-    }
 
-    vulkan_shaders->pipelines       = commit_base;
+    vulkan_shaders->pipelines       = pipelines;
     vulkan_shaders->pipelines_count = shaders_info->pipeline_infos_count;
 
     /* create descriptors and pipeline layout */
     if(!create_descriptors(
         vulkan_device->device,
+        vulkan_device->allocator,
         shaders_info->descriptor_set_infos,
         &vulkan_shaders->descriptor_pool,
         vulkan_shaders->descriptor_sets,
         vulkan_shaders->descriptor_layouts,
         vulkan_shaders->descriptor_types,
+        vulkan_shaders->dynamic_bindings,
+        &vulkan_shaders->dynamic_bindings_count,
         &vulkan_shaders->pipeline_layout
     )) {
         LOG_ERROR("failed to create descriptors");
         goto fail;
     }
+    for(u32 i = 0; i != GPU_DESCRIPTOR_SET_COUNT * GPU_MAX_BINDINGS_PER_DESCRIPTOR; i++) {
+        vulkan_shaders->binding_resources[i] = U32_MAX;
+    }
 
     /* create pipelines */
     if(!create_pipelines(
         vulkan_device->device,
+        vulkan_device->allocator,
         vulkan_device->adapter->surface_format,
         vulkan_shaders->pipeline_layout,
         shaders_info->pipeline_infos,
@@ -551,32 +573,32 @@ void gpu_release_shaders(
         goto fail;
     }
 
-    GpuContext*    gpu_ctx        = (GpuContext*)ctx;
-    VulkanShaders* vulkan_shaders = &gpu_ctx->vulkan_shaders;
-    const VkDevice device         = gpu_ctx->vulkan_device.device;
+    GpuContext*                  gpu_ctx        = (GpuContext*)ctx;
+    VulkanShaders*               vulkan_shaders = &gpu_ctx->vulkan_shaders;
+    const VkDevice               device         = gpu_ctx->vulkan_device.device;
+    const VkAllocationCallbacks* allocator      = gpu_ctx->vulkan_device.allocator;
 
     /* pipelines */
     const VkPipeline* pipelines       = vulkan_shaders->pipelines;
     const u32         pipelines_count = vulkan_shaders->pipelines_count;
     for(u32 i = 0; i != pipelines_count; i++) {
-        vkDestroyPipeline(device, pipelines[i], NULL);
+        vkDestroyPipeline(device, pipelines[i], allocator);
     }
 
     /* pipeline layout */
-    vkDestroyPipelineLayout(device, vulkan_shaders->pipeline_layout, NULL);
+    vkDestroyPipelineLayout(device, vulkan_shaders->pipeline_layout, allocator);
 
     /* descriptors */
     const VkDescriptorSetLayout* descriptor_set_layouts = vulkan_shaders->descriptor_layouts;
 
-    vkDestroyDescriptorPool(device, vulkan_shaders->descriptor_pool, NULL);
+    vkDestroyDescriptorPool(device, vulkan_shaders->descriptor_pool, allocator);
     
     for(u32 i = 0; i != GPU_DESCRIPTOR_SET_COUNT; i++) {
-        vkDestroyDescriptorSetLayout(device, descriptor_set_layouts[i], NULL);    
+        vkDestroyDescriptorSetLayout(device, descriptor_set_layouts[i], allocator);    
     }
 
     *vulkan_shaders = (VulkanShaders){0};
-
-    /* FIX: may be decommit memory? */
+    arena_reset(&gpu_ctx->arena_shaders, 0);
 
     fail: {}
 }
@@ -596,8 +618,11 @@ b32 gpu_write_bindings(
     const VkDescriptorType* descriptor_types       = vulkan_shaders->descriptor_types;
     const GpuBuffer*        resource_buffers       = vulkan_resources->buffers;
     const GpuImage*         resource_images        = vulkan_resources->images;
-    const u32               resource_buffers_count = vulkan_resources->buffers_count;
-    const u32               resource_images_count  = vulkan_resources->images_count;
+
+    /* buffers behind dynamic bindings, offsets are resolved every frame */
+    for(u32 i = 0; i != vulkan_shaders->dynamic_bindings_count; i++) {
+        vulkan_shaders->dynamic_buffer_ids[i] = U32_MAX;
+    }
 
     /* fill descriptor write infos */
     VkWriteDescriptorSet   descriptor_writes[GPU_DESCRIPTOR_SET_COUNT * GPU_MAX_BINDINGS_PER_DESCRIPTOR] = {0};
@@ -623,18 +648,36 @@ b32 gpu_write_bindings(
         /* buffer */
         if(
             binding_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
-            binding_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER 
+            binding_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+            binding_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
         ) {
-            if(resource_id >= resource_buffers_count) {
-                LOG_ERROR("invalid buffer id: %u/%u", resource_id, resource_buffers_count);
+            const u32 buffer_slot = resources_buffer_slot(vulkan_resources, resource_id);
+            if(buffer_slot == U32_MAX) {
+                LOG_ERROR("invalid buffer id: %u", resource_id);
+                goto fail;
+            }
+
+            /* dynamic range is one slot or one frame uniforms slice, the offset moves it */
+            const b32 is_dynamic = binding_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
+            if(is_dynamic) {
+                for(u32 j = 0; j != vulkan_shaders->dynamic_bindings_count; j++) {
+                    if(vulkan_shaders->dynamic_bindings[j] == binding_id + set_id * GPU_MAX_BINDINGS_PER_DESCRIPTOR) {
+                        vulkan_shaders->dynamic_buffer_ids[j] = buffer_slot;
+                    }
+                }
+            }
+            if(!is_dynamic && resource_buffers[buffer_slot].frame_stride != 0) {
+                LOG_ERROR("late latch and frame uniforms buffers have to be bound as dynamic uniform buffer id: %u", resource_id);
                 goto fail;
             }
 
             /* write infos */
             buffer_infos[i] = (VkDescriptorBufferInfo) {
-                .buffer = resource_buffers[resource_id].buffer,
+                .buffer = resource_buffers[buffer_slot].buffer,
                 .offset = 0,
-                .range  = VK_WHOLE_SIZE
+                .range  = !is_dynamic ? VK_WHOLE_SIZE :
+                    resource_buffers[buffer_slot].frame_uniforms ? GPU_FRAME_UNIFORMS_RANGE : resource_buffers[buffer_slot].used_size
             };
             descriptor_writes[i] = (VkWriteDescriptorSet) {
                 .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -651,8 +694,9 @@ b32 gpu_write_bindings(
             binding_type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
             binding_type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
         ) {
-            if(resource_id >= resource_images_count) {
-                LOG_ERROR("invalid image id: %u/%u", resource_id, resource_images_count);
+            const u32 image_slot = resources_image_slot(vulkan_resources, resource_id);
+            if(image_slot == U32_MAX) {
+                LOG_ERROR("invalid image id: %u", resource_id);
                 goto fail;
             }
 
@@ -669,7 +713,7 @@ b32 gpu_write_bindings(
             /* write infos */
             image_infos[i] = (VkDescriptorImageInfo) {
                 .imageLayout = image_layout,
-                .imageView   = resource_images[resource_id].view
+                .imageView   = resource_images[image_slot].view
             };
             descriptor_writes[i] = (VkWriteDescriptorSet) {
                 .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -728,9 +772,45 @@ b32 gpu_write_bindings(
 
     vkUpdateDescriptorSets(vulkan_device->device, binding_infos_count, descriptor_writes, 0, NULL);
 
+    /* kept for rewrites after surface relative images were recreated */
+    for(u32 i = 0; i != binding_infos_count; i++) {
+        const u32 binding_slot = binding_infos[i].binding_id + binding_infos[i].set_id * GPU_MAX_BINDINGS_PER_DESCRIPTOR;
+        vulkan_shaders->binding_resources[binding_slot] = binding_infos[i].resource_id;
+    }
+
     return TRUE;
 
     fail: {
         return FALSE;
     }
 }
+
+b32 shaders_rewrite_bindings(
+    GpuContext* gpu_ctx
+) {
+    const VulkanShaders* vulkan_shaders = &gpu_ctx->vulkan_shaders;
+
+    BindingInfo binding_infos[GPU_DESCRIPTOR_SET_COUNT * GPU_MAX_BINDINGS_PER_DESCRIPTOR];
+    u32         binding_infos_count = 0;
+
+    /* shaders not compiled, nothing was written */
+    if(vulkan_shaders->descriptor_pool == NULL) {
+        return TRUE;
+    }
+
+    for(u32 i = 0; i != GPU_DESCRIPTOR_SET_COUNT * GPU_MAX_BINDINGS_PER_DESCRIPTOR; i++) {
+        if(vulkan_shaders->binding_resources[i] == U32_MAX) {
+            continue;
+        }
+        binding_infos[binding_infos_count++] = (BindingInfo) {
+            .set_id      = i / GPU_MAX_BINDINGS_PER_DESCRIPTOR,
+            .binding_id  = i % GPU_MAX_BINDINGS_PER_DESCRIPTOR,
+            .resource_id = vulkan_shaders->binding_resources[i]
+        };
+    }
+    if(binding_infos_count == 0) {
+        return TRUE;
+    }
+
+    return gpu_write_bindings((CtxHandle)gpu_ctx, binding_infos, binding_infos_count);
+}
@@ -0,0 +1,714 @@
+#include "gpu_internal.h"
+
+/* bytes per texel of tightly packed image data, 0 = not uploadable */
+u32 format_texel_size(
+    VkFormat format
+) {
+    switch(format) {
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+        case VK_FORMAT_R32G32_SFLOAT:       return 8;
+        case VK_FORMAT_R32_SFLOAT:          return 4;
+        case VK_FORMAT_D32_SFLOAT:          return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+        case VK_FORMAT_R16G16_SFLOAT:       return 4;
+        case VK_FORMAT_R16_SFLOAT:          return 2;
+        case VK_FORMAT_R8G8B8_UNORM:        return 3;
+        case VK_FORMAT_R8G8_UNORM:          return 2;
+        case VK_FORMAT_R8_UNORM:            return 1;
+        default:                            return 0;
+    }
+}
+
+/* frees stream ring space of batches the upload queue finished */
+void upload_reclaim(
+    VulkanUpload* vulkan_upload,
+    u64           token_completed
+) {
+    for(u32 i = 0; i != vulkan_upload->batches_count; i++) {
+        const GpuUploadBatch* batch = &vulkan_upload->batches[(vulkan_upload->batches_first + i) % GPU_MAX_UPLOAD_BATCHES];
+
+        if(batch->token > token_completed) {
+            break;
+        }
+        vulkan_upload->stream_tail = batch->stream_end;
+    }
+}
+
+/* returns offset inside buffer_stream_ring, waits for the oldest batches if the ring is full */
+/* allocations never wrap around the ring end, U64_MAX = fail */
+u64 upload_stream_allocate(
+    const VulkanDevice* vulkan_device,
+    VulkanUpload*       vulkan_upload,
+    u64                 size,
+    u64                 alignment
+) {
+    if(size > GPU_STREAM_RING_SIZE) {
+        LOG_ERROR("exceed stream ring size: %llu/%llu", size, (u64)GPU_STREAM_RING_SIZE);
+        goto fail;
+    }
+
+    while(1) {
+        const u64 head_offset   = vulkan_upload->stream_head % GPU_STREAM_RING_SIZE;
+        u64       stream_offset = ((head_offset + alignment - 1) / alignment) * alignment;
+        u64       stream_begin  = vulkan_upload->stream_head + (stream_offset - head_offset);
+
+        if(stream_offset + size > GPU_STREAM_RING_SIZE) {
+            stream_offset = 0;
+            stream_begin  = vulkan_upload->stream_head + (GPU_STREAM_RING_SIZE - head_offset);
+        }
+        if(stream_begin + size - vulkan_upload->stream_tail <= GPU_STREAM_RING_SIZE) {
+            vulkan_upload->stream_head = stream_begin + size;
+            return stream_offset;
+        }
+
+        /* wait for the oldest batch still holding ring space */
+        u64 token_wait = 0;
+        for(u32 i = 0; i != vulkan_upload->batches_count; i++) {
+            const GpuUploadBatch* batch = &vulkan_upload->batches[(vulkan_upload->batches_first + i) % GPU_MAX_UPLOAD_BATCHES];
+            if(batch->stream_end > vulkan_upload->stream_tail) {
+                token_wait = batch->token;
+                break;
+            }
+        }
+        if(token_wait == 0) {
+            LOG_ERROR("stream ring has no pending batches to wait for");
+            goto fail;
+        }
+        /* deferred batches are submitted by frame_end, waiting here would never return */
+        if(token_wait > vulkan_upload->token_submitted) {
+            LOG_ERROR("stream ring is held by uploads waiting for frame_end, token: %llu", token_wait);
+            goto fail;
+        }
+
+        const VkSemaphoreWaitInfo wait_info = {
+            .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores    = &vulkan_upload->semaphore_timeline,
+            .pValues        = &token_wait
+        };
+        if(vkWaitSemaphores(vulkan_device->device, &wait_info, U64_MAX) != VK_SUCCESS) {
+            LOG_ERROR("failed to wait for upload token: %llu", token_wait);
+            goto fail;
+        }
+        upload_reclaim(vulkan_upload, token_wait);
+    }
+
+    fail: {
+        return U64_MAX;
+    }
+}
+
+/* copies data into the stream ring and flushes it, returns ring offset, U64_MAX = fail */
+u64 upload_stream_write(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanUpload*          vulkan_upload,
+    const void*            data,
+    u64                    size,
+    u64                    alignment
+) {
+    const u64 stream_offset = upload_stream_allocate(vulkan_device, vulkan_upload, size, alignment);
+    if(stream_offset == U64_MAX) {
+        goto fail;
+    }
+
+    const u64 memory_offset = vulkan_resources->buffer_stream_ring.allocation_offset + stream_offset;
+
+    memcpy((u8*)vulkan_resources->buffer_stream_ring.memory_map + memory_offset, data, size);
+
+    /* batch is submitted right after, nothing to coalesce with */
+    if(!vulkan_resources->buffer_stream_ring.host_coherent) {
+        const u64 atom_size   = vulkan_device->adapter->non_coherent_atom_size;
+        const u64 flush_begin = memory_offset / atom_size * atom_size;
+        const u64 flush_end   = MIN((memory_offset + size + atom_size - 1) / atom_size * atom_size, vulkan_resources->buffer_stream_ring.memory_size);
+
+        const VkMappedMemoryRange flush_range = {
+            .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .offset = flush_begin,
+            .size   = flush_end - flush_begin,
+            .memory = vulkan_resources->buffer_stream_ring.memory
+        };
+        vkFlushMappedMemoryRanges(vulkan_device->device, 1, &flush_range);
+    }
+
+    return stream_offset;
+
+    fail: {
+        return U64_MAX;
+    }
+}
+
+/* takes next batch slot and begins its command buffer, NULL = fail */
+GpuUploadBatch* upload_begin_batch(
+    VulkanUpload* vulkan_upload
+) {
+    if(vulkan_upload->batches_count == GPU_MAX_UPLOAD_BATCHES) {
+        LOG_ERROR("too many uploads waiting for acquire: %u/%u", vulkan_upload->batches_count, GPU_MAX_UPLOAD_BATCHES);
+        goto fail;
+    }
+
+    GpuUploadBatch* batch = &vulkan_upload->batches[(vulkan_upload->batches_first + vulkan_upload->batches_count) % GPU_MAX_UPLOAD_BATCHES];
+
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+    if(vkResetCommandBuffer(batch->command_buffer, 0) != VK_SUCCESS) {
+        LOG_ERROR("failed to reset upload command buffer");
+        goto fail;
+    }
+    if(vkBeginCommandBuffer(batch->command_buffer, &command_buffer_begin_info) != VK_SUCCESS) {
+        LOG_ERROR("failed to begin upload command buffer");
+        goto fail;
+    }
+
+    return batch;
+
+    fail: {
+        return NULL;
+    }
+}
+
+b32 upload_submit_deferred(
+    const VulkanDevice* vulkan_device,
+    const VulkanRender* vulkan_render,
+    VulkanUpload*       vulkan_upload,
+    u64                 frame_value
+) {
+    if(vulkan_upload->batches_deferred == 0) {
+        return TRUE;
+    }
+
+    VkCommandBuffer command_buffers[GPU_MAX_UPLOAD_BATCHES];
+    const u32       batches_submitted = vulkan_upload->batches_count - vulkan_upload->batches_deferred;
+    for(u32 i = 0; i != vulkan_upload->batches_deferred; i++) {
+        command_buffers[i] = vulkan_upload->batches[(vulkan_upload->batches_first + batches_submitted + i) % GPU_MAX_UPLOAD_BATCHES].command_buffer;
+    }
+
+    /* the last token covers every batch of the submit */
+    const u64 token      = vulkan_upload->token_submitted + vulkan_upload->batches_deferred;
+    const b32 frame_wait = vulkan_render->semaphore_frame_timeline != NULL && frame_value != 0;
+
+    const VkPipelineStageFlags          wait_stage           = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    const VkTimelineSemaphoreSubmitInfo timeline_submit_info = {
+        .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount   = frame_wait ? 1 : 0,
+        .pWaitSemaphoreValues      = &frame_value,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues    = &token
+    };
+    const VkSubmitInfo                  submit_info          = {
+        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                = &timeline_submit_info,
+        .commandBufferCount   = vulkan_upload->batches_deferred,
+        .pCommandBuffers      = command_buffers,
+        .waitSemaphoreCount   = frame_wait ? 1 : 0,
+        .pWaitSemaphores      = &vulkan_render->semaphore_frame_timeline,
+        .pWaitDstStageMask    = &wait_stage,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores    = &vulkan_upload->semaphore_timeline
+    };
+    if(vkQueueSubmit(vulkan_upload->queue, 1, &submit_info, NULL) != VK_SUCCESS) {
+        LOG_ERROR("failed to submit upload token: %llu", token);
+        goto fail;
+    }
+
+    vulkan_upload->token_submitted  = token;
+    vulkan_upload->batches_deferred = 0;
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* ends batch and hands out the next token, 0 = fail */
+/* the frame being recorded may read the destination, batches recorded during it are submitted by frame_end */
+/* outside of frames they are submitted right away, copies always wait for the frames before them to retire */
+u64 upload_submit_batch(
+    const VulkanDevice* vulkan_device,
+    const VulkanRender* vulkan_render,
+    VulkanUpload*       vulkan_upload,
+    GpuUploadBatch*     batch
+) {
+    if(vkEndCommandBuffer(batch->command_buffer) != VK_SUCCESS) {
+        LOG_ERROR("failed to end upload command buffer");
+        goto fail;
+    }
+
+    const u64 token = vulkan_upload->token_submitted + vulkan_upload->batches_deferred + 1;
+
+    batch->token      = token;
+    batch->stream_end = vulkan_upload->stream_head;
+    vulkan_upload->batches_deferred++;
+    vulkan_upload->batches_count++;
+
+    /* counter is ahead of the submitted frame only between frame_begin and frame_end */
+    if(vulkan_render->frame_counter != vulkan_render->frame_submitted) {
+        return token;
+    }
+    if(!upload_submit_deferred(vulkan_device, vulkan_render, vulkan_upload, vulkan_render->frame_submitted)) {
+        /* batch is the last one, earlier deferred batches stay for the next try */
+        vulkan_upload->batches_deferred--;
+        vulkan_upload->batches_count--;
+        goto fail;
+    }
+
+    return token;
+
+    fail: {
+        return 0;
+    }
+}
+
+b32 upload_init(
+    const VulkanDevice* vulkan_device,
+    VulkanUpload*       vulkan_upload
+) {
+    const VkDevice device = vulkan_device->device;
+
+    /* ownership moves to the render queue only from a dedicated transfer queue */
+    if(vulkan_device->queue_transfer != NULL) {
+        vulkan_upload->queue        = vulkan_device->queue_transfer;
+        vulkan_upload->command_pool = vulkan_device->command_pool_transfer;
+        vulkan_upload->src_queue_id = vulkan_device->adapter->transfer_queue_id;
+        vulkan_upload->dst_queue_id = vulkan_device->adapter->render_queue_id;
+    }
+    else {
+        vulkan_upload->queue        = vulkan_device->queue_render;
+        vulkan_upload->command_pool = vulkan_device->command_pool_render;
+        vulkan_upload->src_queue_id = VK_QUEUE_FAMILY_IGNORED;
+        vulkan_upload->dst_queue_id = VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    const VkSemaphoreTypeCreateInfo semaphore_type_info = {
+        .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue  = 0
+    };
+    const VkSemaphoreCreateInfo semaphore_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &semaphore_type_info
+    };
+    if(vkCreateSemaphore(device, &semaphore_info, vulkan_device->allocator, &vulkan_upload->semaphore_timeline) != VK_SUCCESS) {
+        LOG_ERROR("failed to create upload timeline semaphore");
+        goto fail;
+    }
+
+    VkCommandBuffer command_buffers[GPU_MAX_UPLOAD_BATCHES] = {0};
+
+    const VkCommandBufferAllocateInfo command_buffers_info = {
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool        = vulkan_upload->command_pool,
+        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = GPU_MAX_UPLOAD_BATCHES
+    };
+    if(vkAllocateCommandBuffers(device, &command_buffers_info, command_buffers) != VK_SUCCESS) {
+        LOG_ERROR("failed to allocate upload command buffers");
+        goto fail;
+    }
+    for(u32 i = 0; i != GPU_MAX_UPLOAD_BATCHES; i++) {
+        vulkan_upload->batches[i].command_buffer = command_buffers[i];
+    }
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+void upload_terminate(
+    const VulkanDevice* vulkan_device,
+    VulkanUpload*       vulkan_upload
+) {
+    const VkDevice device = vulkan_device->device;
+
+    if(vulkan_upload->batches[0].command_buffer != NULL) {
+        VkCommandBuffer command_buffers[GPU_MAX_UPLOAD_BATCHES];
+        for(u32 i = 0; i != GPU_MAX_UPLOAD_BATCHES; i++) {
+            command_buffers[i] = vulkan_upload->batches[i].command_buffer;
+        }
+        vkFreeCommandBuffers(device, vulkan_upload->command_pool, GPU_MAX_UPLOAD_BATCHES, command_buffers);
+    }
+    vkDestroySemaphore(device, vulkan_upload->semaphore_timeline, vulkan_device->allocator);
+
+    *vulkan_upload = (VulkanUpload){0};
+}
+
+b32 upload_is_pending(
+    const VulkanUpload* vulkan_upload,
+    b32                 is_image,
+    u32                 resource_id
+) {
+    for(u32 i = 0; i != vulkan_upload->batches_count; i++) {
+        const GpuUploadBatch* batch = &vulkan_upload->batches[(vulkan_upload->batches_first + i) % GPU_MAX_UPLOAD_BATCHES];
+
+        if(batch->is_image == is_image && batch->resource_id == resource_id) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+void upload_acquire(
+    const VulkanDevice*    vulkan_device,
+    const VulkanResources* vulkan_resources,
+    VulkanUpload*          vulkan_upload,
+    VulkanRender*          vulkan_render
+) {
+    if(vulkan_upload->batches_count == 0) {
+        return;
+    }
+
+    u64 token_completed = 0;
+    if(vkGetSemaphoreCounterValue(vulkan_device->device, vulkan_upload->semaphore_timeline, &token_completed) != VK_SUCCESS) {
+        LOG_ERROR("failed to get upload timeline value");
+        return;
+    }
+    upload_reclaim(vulkan_upload, token_completed);
+
+    /* acquire barriers */
+    VkImageMemoryBarrier2  acquire_image_barriers [GPU_MAX_IMAGES];
+    VkBufferMemoryBarrier2 acquire_buffer_barriers[GPU_MAX_UPLOAD_BATCHES];
+    u32                    acquire_images_count  = 0;
+    u32                    acquire_buffers_count = 0;
+
+    while(vulkan_upload->batches_count != 0) {
+        const GpuUploadBatch* batch = &vulkan_upload->batches[vulkan_upload->batches_first];
+
+        if(batch->token > token_completed) {
+            break;
+        }
+        /* one image barrier per frame is enough, later uploads of it are acquired next frame */
+        if(batch->is_image) {
+            b32 image_acquired = FALSE;
+            for(u32 i = 0; i != acquire_images_count; i++) {
+                image_acquired |= acquire_image_barriers[i].image == vulkan_resources->images[batch->resource_id].image;
+            }
+            if(image_acquired || acquire_images_count == GPU_MAX_IMAGES) {
+                break;
+            }
+        }
+
+        if(batch->is_image) {
+            const GpuImage* image = &vulkan_resources->images[batch->resource_id];
+
+            acquire_image_barriers[acquire_images_count++] = (VkImageMemoryBarrier2) {
+                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .image               = image->image,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+                .srcAccessMask       = VK_ACCESS_2_NONE,
+                .oldLayout           = batch->layout,
+                .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                .dstAccessMask       = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+                .newLayout           = batch->layout,
+                .srcQueueFamilyIndex = vulkan_upload->src_queue_id,
+                .dstQueueFamilyIndex = vulkan_upload->dst_queue_id,
+                .subresourceRange    = (VkImageSubresourceRange) {
+                    .aspectMask     = image->aspect,
+                    .baseArrayLayer = 0,
+                    .layerCount     = 1,
+                    .baseMipLevel   = 0,
+                    .levelCount     = 1
+                }
+            };
+            vulkan_render->image_states[batch->resource_id] = (GpuImageState) {
+                .access = VK_ACCESS_2_NONE,
+                .layout = batch->layout,
+                .stage  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+            };
+            vulkan_render->images_persistent[batch->resource_id] = TRUE;
+        }
+        else {
+            /* ranges of one buffer may differ per batch, so these don't go through a merging batch */
+            acquire_buffer_barriers[acquire_buffers_count++] = (VkBufferMemoryBarrier2) {
+                .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                .buffer              = vulkan_resources->buffers[batch->resource_id].buffer,
+                .offset              = batch->offset,
+                .size                = batch->size,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+                .srcAccessMask       = VK_ACCESS_2_NONE,
+                .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                .dstAccessMask       = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+                .srcQueueFamilyIndex = vulkan_upload->src_queue_id,
+                .dstQueueFamilyIndex = vulkan_upload->dst_queue_id
+            };
+            vulkan_render->buffer_states[batch->resource_id] = (GpuBufferState) {
+                .access = VK_ACCESS_2_NONE,
+                .stage  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+            };
+        }
+
+        vulkan_upload->token_acquired = batch->token;
+        vulkan_upload->batches_first  = (vulkan_upload->batches_first + 1) % GPU_MAX_UPLOAD_BATCHES;
+        vulkan_upload->batches_count--;
+    }
+
+    if(acquire_images_count == 0 && acquire_buffers_count == 0) {
+        return;
+    }
+
+    /* render submit waits for token_acquired at all commands, already signaled so it never stalls */
+    const VkDependencyInfo dependency_info = {
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = acquire_buffers_count,
+        .pBufferMemoryBarriers    = acquire_buffer_barriers,
+        .imageMemoryBarrierCount  = acquire_images_count,
+        .pImageMemoryBarriers     = acquire_image_barriers
+    };
+    vulkan_device->cmd_pipeline_barrier2_khr(vulkan_render->command_buffer, &dependency_info);
+    vulkan_render->barrier_stats.barrier_calls++;
+    vulkan_render->barrier_stats.barriers_emitted += acquire_buffers_count + acquire_images_count;
+}
+
+/* API */
+
+u64 gpu_upload_buffer_async(
+    CtxHandle   ctx,
+    u32         buffer_id,
+    const void* data,
+    u64         offset,
+    u64         size
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanRender*    vulkan_render    = &gpu_ctx->vulkan_render;
+    VulkanUpload*          vulkan_upload    = &gpu_ctx->vulkan_upload;
+
+    /* validation, batches keep the slot */
+    const u32 buffer_slot = resources_buffer_slot(vulkan_resources, buffer_id);
+    if(buffer_slot == U32_MAX) {
+        LOG_ERROR("invalid buffer id: %u", buffer_id);
+        goto fail;
+    }
+
+    const GpuBuffer* gpu_buffer = &vulkan_resources->buffers[buffer_slot];
+
+    /* host frame slots are written in place, not through transfers */
+    if(gpu_buffer->frame_stride != 0) {
+        LOG_ERROR("late latch and frame uniforms buffers can't be uploaded id: %u", buffer_id);
+        goto fail;
+    }
+
+    if(size == 0 || offset + size > gpu_buffer->used_size) {
+        LOG_ERROR(
+            "trying to upload size bigger than buffer: (%llu+%llu)/%llu",
+            offset, size, gpu_buffer->used_size
+        );
+        goto fail;
+    }
+
+    GpuUploadBatch* batch = upload_begin_batch(vulkan_upload);
+    if(batch == NULL) {
+        goto fail;
+    }
+
+    const u64 stream_offset = upload_stream_write(
+        vulkan_device,
+        vulkan_resources,
+        vulkan_upload,
+        data,
+        size,
+        GPU_UPLOAD_ALIGNMENT
+    );
+    if(stream_offset == U64_MAX) {
+        goto fail;
+    }
+
+    /* copy and release to the render queue */
+    const VkBufferCopy buffer_copy = {
+        .srcOffset = stream_offset,
+        .dstOffset = offset,
+        .size      = size
+    };
+    vkCmdCopyBuffer(
+        batch->command_buffer,
+        vulkan_resources->buffer_stream_ring.buffer,
+        gpu_buffer->buffer,
+        1,
+        &buffer_copy
+    );
+
+    const VkBufferMemoryBarrier2 release_buffer_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer              = gpu_buffer->buffer,
+        .offset              = offset,
+        .size                = size,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask       = VK_ACCESS_2_NONE,
+        .srcQueueFamilyIndex = vulkan_upload->src_queue_id,
+        .dstQueueFamilyIndex = vulkan_upload->dst_queue_id
+    };
+    const VkDependencyInfo       release_dependency     = {
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers    = &release_buffer_barrier
+    };
+    vulkan_device->cmd_pipeline_barrier2_khr(batch->command_buffer, &release_dependency);
+
+    batch->is_image    = FALSE;
+    batch->resource_id = buffer_slot;
+    batch->offset      = offset;
+    batch->size        = size;
+
+    return upload_submit_batch(vulkan_device, vulkan_render, vulkan_upload, batch);
+
+    fail: {
+        return 0;
+    }
+}
+
+u64 gpu_upload_image_async(
+    CtxHandle   ctx,
+    u32         image_id,
+    const void* data,
+    u64         size
+) {
+    GpuContext*            gpu_ctx          = (GpuContext*)ctx;
+    const VulkanDevice*    vulkan_device    = &gpu_ctx->vulkan_device;
+    const VulkanResources* vulkan_resources = &gpu_ctx->vulkan_resources;
+    const VulkanRender*    vulkan_render    = &gpu_ctx->vulkan_render;
+    VulkanUpload*          vulkan_upload    = &gpu_ctx->vulkan_upload;
+
+    /* validation, batches keep the slot */
+    const u32 image_slot = resources_image_slot(vulkan_resources, image_id);
+    if(image_slot == U32_MAX) {
+        LOG_ERROR("invalid image id: %u", image_id);
+        goto fail;
+    }
+
+    const GpuImage* gpu_image  = &vulkan_resources->images[image_slot];
+    const u32       texel_size = format_texel_size(gpu_image->format);
+
+    if(texel_size == 0) {
+        LOG_ERROR("image format can't be uploaded id: %u format: %u", image_id, gpu_image->format);
+        goto fail;
+    }
+    if(size != (u64)gpu_image->size_x * gpu_image->size_y * texel_size) {
+        LOG_ERROR(
+            "invalid image upload size: %llu/%llu",
+            size, (u64)gpu_image->size_x * gpu_image->size_y * texel_size
+        );
+        goto fail;
+    }
+
+    GpuUploadBatch* batch = upload_begin_batch(vulkan_upload);
+    if(batch == NULL) {
+        goto fail;
+    }
+
+    /* copy offset has to be a multiple of texel size */
+    const u64 stream_offset = upload_stream_write(
+        vulkan_device,
+        vulkan_resources,
+        vulkan_upload,
+        data,
+        size,
+        (u64)GPU_UPLOAD_ALIGNMENT * texel_size
+    );
+    if(stream_offset == U64_MAX) {
+        goto fail;
+    }
+
+    /* previous contents are discarded, the transition is chained to the frame wait at transfer */
+    const VkImageLayout             dst_layout       = (gpu_image->usage & VK_IMAGE_USAGE_SAMPLED_BIT) ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+    const VkImageSubresourceRange   image_range      = {
+        .aspectMask     = gpu_image->aspect,
+        .baseArrayLayer = 0,
+        .layerCount     = 1,
+        .baseMipLevel   = 0,
+        .levelCount     = 1
+    };
+    const VkImageMemoryBarrier2     transfer_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image               = gpu_image->image,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        .srcAccessMask       = VK_ACCESS_2_NONE,
+        .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .subresourceRange    = image_range
+    };
+    const VkDependencyInfo          transfer_dependency = {
+        .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .imageMemoryBarrierCount = 1,
+        .pImageMemoryBarriers    = &transfer_barrier
+    };
+    vulkan_device->cmd_pipeline_barrier2_khr(batch->command_buffer, &transfer_dependency);
+
+    const VkBufferImageCopy image_copy = {
+        .bufferOffset      = stream_offset,
+        .bufferRowLength   = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource  = (VkImageSubresourceLayers) {
+            .aspectMask     = gpu_image->aspect,
+            .mipLevel       = 0,
+            .baseArrayLayer = 0,
+            .layerCount     = 1
+        },
+        .imageOffset       = (VkOffset3D) {0, 0, 0},
+        .imageExtent       = (VkExtent3D) {
+            .width  = gpu_image->size_x,
+            .height = gpu_image->size_y,
+            .depth  = 1
+        }
+    };
+    vkCmdCopyBufferToImage(
+        batch->command_buffer,
+        vulkan_resources->buffer_stream_ring.buffer,
+        gpu_image->image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &image_copy
+    );
+
+    /* release to the render queue, the layout transition happens once between release and acquire */
+    const VkImageMemoryBarrier2 release_barrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image               = gpu_image->image,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask       = VK_ACCESS_2_NONE,
+        .newLayout           = dst_layout,
+        .srcQueueFamilyIndex = vulkan_upload->src_queue_id,
+        .dstQueueFamilyIndex = vulkan_upload->dst_queue_id,
+        .subresourceRange    = image_range
+    };
+    const VkDependencyInfo      release_dependency = {
+        .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .imageMemoryBarrierCount = 1,
+        .pImageMemoryBarriers    = &release_barrier
+    };
+    vulkan_device->cmd_pipeline_barrier2_khr(batch->command_buffer, &release_dependency);
+
+    batch->is_image    = TRUE;
+    batch->resource_id = image_slot;
+    batch->offset      = 0;
+    batch->size        = size;
+    batch->layout      = dst_layout;
+
+    return upload_submit_batch(vulkan_device, vulkan_render, vulkan_upload, batch);
+
+    fail: {
+        return 0;
+    }
+}
+
+b32 gpu_upload_is_complete(
+    CtxHandle ctx,
+    u64       token
+) {
+    const GpuContext* gpu_ctx = (const GpuContext*)ctx;
+
+    return token != 0 && token <= gpu_ctx->vulkan_upload.token_acquired;
+}
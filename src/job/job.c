@@ -0,0 +1,395 @@
+#include "job.h"
+#include <windows.h>
+
+typedef struct {
+    JobFunc           func;
+    void*             data;
+    JobCounter*       counter;
+    const JobCounter* dependency;
+} Job;
+
+/* chase-lev deque: owner pushes and pops at bottom, thieves take from top */
+typedef struct {
+    volatile i64 top;
+    u8           top_padding[56];
+    volatile i64 bottom;
+    u8           bottom_padding[56];
+    Job          jobs[JOB_DEQUE_SIZE];
+} JobDeque;
+
+typedef struct JobContext JobContext;
+
+typedef struct {
+    JobContext* context;
+    u32         worker_id;
+    HANDLE      thread;
+} JobWorker;
+
+struct JobContext {
+    JobDeque      deques [JOB_MAX_WORKERS];
+    JobWorker     workers[JOB_MAX_WORKERS];
+    u32           workers_count;
+    /* blocked jobs, released by the last decrement of their dependency */
+    SRWLOCK       parked_lock;
+    Job           parked[JOB_MAX_PARKED];
+    u32           parked_count;
+    /* worker_id + 1 of the calling thread, 0 = not a worker */
+    DWORD         tls_worker;
+    HANDLE        semaphore_wake;
+    volatile i32x sleeping_count;
+    volatile i32x running;
+};
+
+/* DEQUE */
+
+b32 deque_push(
+    JobDeque*  deque,
+    const Job* job
+) {
+    const i64 bottom = deque->bottom;
+    const i64 top    = deque->top;
+
+    if(bottom - top >= JOB_DEQUE_SIZE) {
+        return FALSE;
+    }
+    deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)] = *job;
+    /* publishes the job before the new bottom */
+    InterlockedExchange64(&deque->bottom, bottom + 1);
+
+    return TRUE;
+}
+
+b32 deque_pop(
+    JobDeque* deque,
+    Job*      job
+) {
+    const i64 bottom = deque->bottom - 1;
+    /* bottom has to be visible to thieves before top is read */
+    InterlockedExchange64(&deque->bottom, bottom);
+    const i64 top = deque->top;
+
+    if(top > bottom) {
+        deque->bottom = bottom + 1;
+        return FALSE;
+    }
+
+    *job = deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)];
+    if(top != bottom) {
+        return TRUE;
+    }
+
+    /* last job, race against thieves */
+    const b32 won = InterlockedCompareExchange64(&deque->top, top + 1, top) == top;
+    deque->bottom = bottom + 1;
+
+    return won;
+}
+
+b32 deque_steal(
+    JobDeque* deque,
+    Job*      job
+) {
+    const i64 top = deque->top;
+    MemoryBarrier();
+    const i64 bottom = deque->bottom;
+
+    if(top >= bottom) {
+        return FALSE;
+    }
+
+    *job = deque->jobs[top & (JOB_DEQUE_SIZE - 1)];
+    return InterlockedCompareExchange64(&deque->top, top + 1, top) == top;
+}
+
+/* WORKERS */
+
+b32 find_job(
+    JobContext* context,
+    u32         worker_id,
+    Job*        job
+) {
+    if(deque_pop(&context->deques[worker_id], job)) {
+        return TRUE;
+    }
+    for(u32 i = 1; i != context->workers_count; i++) {
+        const u32 victim_id = (worker_id + i) % context->workers_count;
+        if(deque_steal(&context->deques[victim_id], job)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+b32 has_jobs(
+    const JobContext* context
+) {
+    for(u32 i = 0; i != context->workers_count; i++) {
+        if(context->deques[i].bottom > context->deques[i].top) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* pending is read under the lock, so the last decrement either happened before or will find the job */
+b32 park_job(
+    JobContext* context,
+    const Job*  job
+) {
+    b32 parked = FALSE;
+
+    AcquireSRWLockExclusive(&context->parked_lock);
+    if(job->dependency->pending != 0 && context->parked_count != JOB_MAX_PARKED) {
+        context->parked[context->parked_count++] = *job;
+        parked = TRUE;
+    }
+    ReleaseSRWLockExclusive(&context->parked_lock);
+
+    return parked;
+}
+
+/* moves jobs waiting for counter to the owner deque */
+/* TRUE with overflow set when the deque is full, caller runs it in place and releases again */
+b32 release_parked(
+    JobContext*       context,
+    u32               worker_id,
+    const JobCounter* counter,
+    Job*              overflow
+) {
+    b32 full = FALSE;
+
+    AcquireSRWLockExclusive(&context->parked_lock);
+    for(u32 i = 0; i < context->parked_count;) {
+        if(context->parked[i].dependency != counter) {
+            i++;
+            continue;
+        }
+        const Job job = context->parked[i];
+        context->parked[i] = context->parked[--context->parked_count];
+
+        if(!deque_push(&context->deques[worker_id], &job)) {
+            *overflow = job;
+            full      = TRUE;
+            break;
+        }
+    }
+    ReleaseSRWLockExclusive(&context->parked_lock);
+
+    if(context->sleeping_count != 0) {
+        ReleaseSemaphore(context->semaphore_wake, 1, NULL);
+    }
+    return full;
+}
+
+void run_job(
+    JobContext* context,
+    u32         worker_id,
+    const Job*  job
+) {
+    /* not ready, parked until the dependency is done */
+    if(job->dependency != NULL && job->dependency->pending != 0) {
+        if(park_job(context, job)) {
+            return;
+        }
+        /* parked list is full, help out until it is done */
+        job_wait(context, (JobCounter*)job->dependency);
+    }
+
+    job->func(job->data, worker_id);
+
+    if(job->counter != NULL && InterlockedDecrement(&job->counter->pending) == 0) {
+        Job overflow;
+        while(release_parked(context, worker_id, job->counter, &overflow)) {
+            run_job(context, worker_id, &overflow);
+        }
+    }
+}
+
+DWORD WINAPI job_worker_main(
+    LPVOID param
+) {
+    JobWorker*  worker    = (JobWorker*)param;
+    JobContext* context   = worker->context;
+    const u32   worker_id = worker->worker_id;
+
+    TlsSetValue(context->tls_worker, (LPVOID)(u64)(worker_id + 1));
+
+    while(context->running) {
+        Job job;
+        if(find_job(context, worker_id, &job)) {
+            run_job(context, worker_id, &job);
+            continue;
+        }
+
+        /* submit wakes sleepers after pushing, recheck closes the gap */
+        InterlockedIncrement(&context->sleeping_count);
+        if(context->running && !has_jobs(context)) {
+            WaitForSingleObject(context->semaphore_wake, INFINITE);
+        }
+        InterlockedDecrement(&context->sleeping_count);
+    }
+
+    return 0;
+}
+
+/* API */
+
+CtxHandle job_start(
+    u32 workers_count
+) {
+    if(workers_count == 0) {
+        SYSTEM_INFO system_info = (SYSTEM_INFO){0};
+        GetSystemInfo(&system_info);
+        workers_count = system_info.dwNumberOfProcessors;
+    }
+    workers_count = CLAMP(1, JOB_MAX_WORKERS, workers_count);
+
+    const u64 context_size = ALIGN(sizeof(JobContext), 0x1000);
+
+    JobContext* context = VirtualAlloc(NULL, context_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if(context == NULL) {
+        LOG_ERROR("failed to allocate job context memory");
+        goto fail;
+    }
+
+    context->workers_count = workers_count;
+    context->running       = TRUE;
+    InitializeSRWLock(&context->parked_lock);
+    context->tls_worker    = TlsAlloc();
+    if(context->tls_worker == TLS_OUT_OF_INDEXES) {
+        LOG_ERROR("failed to allocate job thread local storage");
+        goto fail;
+    }
+    context->semaphore_wake = CreateSemaphoreA(NULL, 0, JOB_MAX_WORKERS * JOB_DEQUE_SIZE, NULL);
+    if(context->semaphore_wake == NULL) {
+        LOG_ERROR("failed to create job wake semaphore");
+        goto fail;
+    }
+
+    /* calling thread is worker 0 */
+    context->workers[0] = (JobWorker) {
+        .context   = context,
+        .worker_id = 0
+    };
+    TlsSetValue(context->tls_worker, (LPVOID)(u64)1);
+
+    for(u32 i = 1; i != workers_count; i++) {
+        context->workers[i] = (JobWorker) {
+            .context   = context,
+            .worker_id = i
+        };
+        context->workers[i].thread = CreateThread(NULL, 0, job_worker_main, &context->workers[i], 0, NULL);
+        if(context->workers[i].thread == NULL) {
+            LOG_ERROR("failed to create job worker: %u/%u", i, workers_count);
+            goto fail;
+        }
+    }
+
+    return context;
+
+    fail: {
+        if(context != NULL) {
+            job_stop(context);
+        }
+        return NULL;
+    }
+}
+
+void job_stop(
+    CtxHandle ctx
+) {
+    JobContext* context = (JobContext*)ctx;
+
+    InterlockedExchange(&context->running, FALSE);
+
+    for(u32 i = 1; i != context->workers_count; i++) {
+        if(context->workers[i].thread == NULL) {
+            continue;
+        }
+        ReleaseSemaphore(context->semaphore_wake, 1, NULL);
+    }
+    for(u32 i = 1; i != context->workers_count; i++) {
+        if(context->workers[i].thread == NULL) {
+            continue;
+        }
+        WaitForSingleObject(context->workers[i].thread, INFINITE);
+        CloseHandle(context->workers[i].thread);
+    }
+
+    if(context->semaphore_wake != NULL) {
+        CloseHandle(context->semaphore_wake);
+    }
+    if(context->tls_worker != TLS_OUT_OF_INDEXES) {
+        TlsFree(context->tls_worker);
+    }
+    if(!VirtualFree(context, 0, MEM_RELEASE)) {
+        LOG_ERROR("failed to free job context memory");
+    }
+}
+
+u32 job_workers_count(
+    CtxHandle ctx
+) {
+    const JobContext* context = (const JobContext*)ctx;
+
+    return context->workers_count;
+}
+
+void job_submit(
+    CtxHandle         ctx,
+    JobFunc           func,
+    void*             data,
+    JobCounter*       counter,
+    const JobCounter* dependency
+) {
+    JobContext* context = (JobContext*)ctx;
+
+    const u32 worker_tls = (u32)(u64)TlsGetValue(context->tls_worker);
+    if(worker_tls == 0) {
+        LOG_ERROR("job submitted from non worker thread");
+        goto fail;
+    }
+    const u32 worker_id = worker_tls - 1;
+
+    const Job job = {
+        .func       = func,
+        .data       = data,
+        .counter    = counter,
+        .dependency = dependency
+    };
+
+    if(counter != NULL) {
+        InterlockedIncrement(&counter->pending);
+    }
+
+    /* deque is full, run in place */
+    if(!deque_push(&context->deques[worker_id], &job)) {
+        run_job(context, worker_id, &job);
+        return;
+    }
+
+    if(context->sleeping_count != 0) {
+        ReleaseSemaphore(context->semaphore_wake, 1, NULL);
+    }
+
+    fail: {}
+}
+
+void job_wait(
+    CtxHandle   ctx,
+    JobCounter* counter
+) {
+    JobContext* context = (JobContext*)ctx;
+
+    const u32 worker_tls = (u32)(u64)TlsGetValue(context->tls_worker);
+
+    while(counter->pending != 0) {
+        Job job;
+        if(worker_tls != 0 && find_job(context, worker_tls - 1, &job)) {
+            run_job(context, worker_tls - 1, &job);
+        }
+        else {
+            YieldProcessor();
+        }
+    }
+}
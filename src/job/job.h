@@ -0,0 +1,31 @@
+#ifndef _JOB_INCLUDED
+#define _JOB_INCLUDED
+
+#include "../base.h"
+
+/* main thread is worker 0, worker_id can be used to index per thread data */
+#define JOB_MAX_WORKERS    (8)
+/* per worker, power of two */
+#define JOB_DEQUE_SIZE     (1024)
+/* jobs waiting for their dependency, shared by all workers */
+#define JOB_MAX_PARKED     (1024)
+
+typedef void (*JobFunc)(void* data, u32 worker_id);
+
+/* number of unfinished jobs, zero initialized */
+typedef struct {
+    volatile i32x pending;
+} JobCounter;
+
+/* workers_count includes main thread, 0 = one per logical core */
+CtxHandle job_start(u32 workers_count);
+void      job_stop(CtxHandle ctx);
+u32       job_workers_count(CtxHandle ctx);
+
+/* only from main thread or inside jobs, counter and dependency may be NULL */
+/* job does not start before dependency counter reaches zero */
+void job_submit(CtxHandle ctx, JobFunc func, void* data, JobCounter* counter, const JobCounter* dependency);
+/* executes other jobs until counter reaches zero */
+void job_wait(CtxHandle ctx, JobCounter* counter);
+
+#endif
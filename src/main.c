@@ -2,57 +2,249 @@
 
 #include "gpu/gpu.h"
 #include "res/res.h"
+#include "job/job.h"
 #include "usr/graphics/graphics.h"
 #include "usr/level.h"
 
-i32 main(i32 argc, char** argv) {
-    /* startup */
-    const GpuInfo gpu_info = {
-        .window_name          = "Wreck",
-        .frame_buffer_x       = 1920,
-        .frame_buffer_y       = 1080,
-        .pci_vendor_id        = 0x1002, /* 0x1002 0x10DE */
-        .pci_device_id        = 0x1638, /* 0x1638 0x25E0 */
-        .vulkan_debug_enabled = FALSE
+#include <windows.h>
+
+/* simulation rate when rendering runs on its own thread */
+#define MAIN_SIM_TICK_RATE    (120.0)
+/* ticks simulated at once before the simulation gives up catching up */
+#define MAIN_SIM_MAX_CATCH_UP (8)
+
+/* immutable simulation result, render thread interpolates previous -> current */
+typedef struct {
+    vec4   camera_position;
+    versor camera_rotation;
+    vec4   camera_position_prev;
+    versor camera_rotation_prev;
+    f64    time;
+    /* performance counter when the snapshot was published */
+    i64    publish_counter;
+} SimSnapshot;
+
+#define SNAPSHOT_FRESH_BIT (4)
+
+/* lock-free triple buffer, writer and reader own a slot each, the third is exchanged */
+typedef struct {
+    SimSnapshot   slots[3];
+    /* exchanged slot id, SNAPSHOT_FRESH_BIT set until the reader takes it */
+    volatile i32x shared_id;
+    u32           write_id;
+    u32           read_id;
+    b32           has_read;
+} SnapshotBuffer;
+
+typedef struct {
+    CtxHandle      gpu_ctx;
+    SnapshotBuffer snapshots;
+    i64            counter_frequency;
+    i64            tick_counts;
+    /* cleared by main to stop, cleared by the thread when it stops itself */
+    volatile i32x  running;
+    /* graphics_render_frame result that stopped the thread */
+    volatile i32x  result;
+} RenderThread;
+
+/* owns the storage FrameData points to */
+typedef struct {
+    mat4 camera_vp;
+    mat4 camera_inv_vp;
+    mat4 camera_inv_v;
+    vec4 camera_position;
+    vec4 sun_direction;
+} FrameState;
+
+/* render thread frame, latch resamples the camera into frame_state */
+typedef struct {
+    RenderThread* render_thread;
+    FrameState*   frame_state;
+} RenderLatch;
+
+void snapshot_publish(
+    SnapshotBuffer*    buffer,
+    const SimSnapshot* snapshot
+) {
+    buffer->slots[buffer->write_id] = *snapshot;
+    /* full barrier, slot contents are visible before the id */
+    const i32x old_id = InterlockedExchange(&buffer->shared_id, buffer->write_id | SNAPSHOT_FRESH_BIT);
+    buffer->write_id  = old_id & 3;
+}
+
+/* newest snapshot, NULL until the first one is published */
+SimSnapshot* snapshot_consume(
+    SnapshotBuffer* buffer
+) {
+    if(buffer->shared_id & SNAPSHOT_FRESH_BIT) {
+        const i32x old_id = InterlockedExchange(&buffer->shared_id, buffer->read_id);
+        buffer->read_id   = old_id & 3;
+        buffer->has_read  = TRUE;
+    }
+    return buffer->has_read ? &buffer->slots[buffer->read_id] : NULL;
+}
+
+void write_frame_camera(
+    vec4        camera_position,
+    versor      camera_rotation,
+    FrameState* frame_state
+) {
+    level_camera_matrices(camera_position, camera_rotation, frame_state->camera_vp, frame_state->camera_inv_v);
+    glm_mat4_inv(
+        frame_state->camera_vp,
+        frame_state->camera_inv_vp
+    );
+    glm_vec4_copy(camera_position, frame_state->camera_position);
+}
+
+void build_frame_data(
+    vec4        camera_position,
+    versor      camera_rotation,
+    f64         time,
+    f64         delta,
+    FrameState* frame_state,
+    FrameData*  frame_data
+) {
+    *frame_state = (FrameState){0};
+
+    write_frame_camera(camera_position, camera_rotation, frame_state);
+
+    f32 sun_state = time * 0.05;
+    sun_state     = sun_state - floor(sun_state / PI) * PI;
+
+    frame_state->sun_direction[0] = cosf(sun_state);
+    frame_state->sun_direction[1] = sinf(sun_state);
+
+    *frame_data = (FrameData) {
+        .camera_vp       = (f32*)frame_state->camera_vp,
+        .camera_inv_vp   = (f32*)frame_state->camera_inv_vp,
+        .camera_inv_v    = (f32*)frame_state->camera_inv_v,
+        .camera_position = (f32*)frame_state->camera_position,
+        .sun_direction   = (f32*)frame_state->sun_direction,
+        .time            = time,
+        .delta           = delta
     };
-    CtxHandle gpu_ctx = NULL;
-    CtxHandle res_ctx = NULL;
+}
 
-    gpu_ctx = gpu_start(&gpu_info);
-    res_ctx = res_start();
+/* drawn state lags one tick behind simulation, alpha walks previous -> current */
+void interpolate_snapshot(
+    const RenderThread* render_thread,
+    SimSnapshot*        snapshot,
+    vec4                camera_position,
+    versor              camera_rotation,
+    f64*                time
+) {
+    LARGE_INTEGER performance_counter = (LARGE_INTEGER){0};
+    QueryPerformanceCounter(&performance_counter);
 
-    if(gpu_ctx == NULL) {
-        LOG_ERROR("failed to start gpu");
-        goto fail;
+    f32 alpha = (f64)(performance_counter.QuadPart - snapshot->publish_counter) / (f64)render_thread->tick_counts;
+    alpha     = CLAMP(0.0f, 1.0f, alpha);
+
+    glm_vec4_lerp(snapshot->camera_position_prev, snapshot->camera_position, alpha, camera_position);
+    glm_quat_slerp(snapshot->camera_rotation_prev, snapshot->camera_rotation, alpha, camera_rotation);
+
+    *time = snapshot->time - (1.0 - alpha) / MAIN_SIM_TICK_RATE;
+}
+
+/* newest simulation state right before submit, cuts up to a frame of input latency */
+void latch_render_camera(
+    void* latch_data
+) {
+    RenderLatch* render_latch = (RenderLatch*)latch_data;
+    SimSnapshot* snapshot     = snapshot_consume(&render_latch->render_thread->snapshots);
+
+    vec4   camera_position = {0};
+    versor camera_rotation = {0};
+    f64    time            = 0.0;
+
+    interpolate_snapshot(render_latch->render_thread, snapshot, camera_position, camera_rotation, &time);
+    write_frame_camera(camera_position, camera_rotation, render_latch->frame_state);
+}
+
+DWORD WINAPI render_thread_main(
+    LPVOID param
+) {
+    RenderThread* render_thread = (RenderThread*)param;
+    i32           render_result = 0;
+    i64           old_counter   = 0;
+
+    /* jobs are submitted from the recording thread, so it owns the job system */
+    CtxHandle job_ctx = job_start(0);
+    if(job_ctx == NULL) {
+        LOG_ERROR("failed to start jobs");
+        render_result = 1;
     }
-    if(res_ctx == NULL) {
-        LOG_ERROR("failed to start resources");
-        goto fail;
+
+    while(render_result == 0 && render_thread->running) {
+        SimSnapshot* snapshot = snapshot_consume(&render_thread->snapshots);
+        if(snapshot == NULL) {
+            SwitchToThread();
+            continue;
+        }
+
+        LARGE_INTEGER performance_counter = (LARGE_INTEGER){0};
+        QueryPerformanceCounter(&performance_counter);
+
+        const f64 delta = old_counter == 0 ? 0.0 : (f64)(performance_counter.QuadPart - old_counter) / (f64)render_thread->counter_frequency;
+        old_counter = performance_counter.QuadPart;
+
+        vec4   camera_position = {0};
+        versor camera_rotation = {0};
+        f64    time            = 0.0;
+        interpolate_snapshot(render_thread, snapshot, camera_position, camera_rotation, &time);
+
+        FrameState  frame_state  = {0};
+        FrameData   frame_data   = {0};
+        RenderLatch render_latch = {
+            .render_thread = render_thread,
+            .frame_state   = &frame_state
+        };
+        build_frame_data(camera_position, camera_rotation, time, delta, &frame_state, &frame_data);
+        frame_data.latch      = latch_render_camera;
+        frame_data.latch_data = &render_latch;
+
+        render_result = graphics_render_frame(render_thread->gpu_ctx, job_ctx, &frame_data);
+        if(render_result == 1) {
+            LOG_ERROR("failed to render frame");
+        }
     }
 
-    if(!graphics_load(gpu_ctx, res_ctx)) {
-        LOG_ERROR("failed to init graphics");
+    if(job_ctx != NULL) {
+        job_stop(job_ctx);
+    }
+
+    InterlockedExchange(&render_thread->result, render_result);
+    InterlockedExchange(&render_thread->running, FALSE);
+
+    return 0;
+}
+
+/* 0 = quit
+   1 = fail */
+i32 run_serial(
+    CtxHandle gpu_ctx
+) {
+    CtxHandle job_ctx = job_start(0);
+    if(job_ctx == NULL) {
+        LOG_ERROR("failed to start jobs");
         goto fail;
     }
 
     while(1) {
         i32 update_result  = 0;
         i32 render_result  = 0;
-        
-        mat4 camera_vp       = {0};
-        mat4 camera_inv_vp   = {0};
-        mat4 camera_inv_v    = {0};
-        vec4 camera_position = {0};
-        vec4 sun_direction   = {0};
+
+        vec4   camera_position = {0};
+        versor camera_rotation = {0};
 
         f64 time  = 0.0;
         f64 delta = 0.0;
 
         update_result = update_level(
-            camera_vp, 
-            camera_inv_v,
+            0.0,
             camera_position,
-            &time, 
+            camera_rotation,
+            &time,
             &delta
         );
         if(update_result == 1) {
@@ -62,29 +254,12 @@ i32 main(i32 argc, char** argv) {
         if(update_result == 2) {
             break;
         }
-        glm_mat4_inv(
-            camera_vp, 
-            camera_inv_vp
-        );
 
-        f32 sun_state = time * 0.05;
-        sun_state     = sun_state - floor(sun_state / PI) * PI;
+        FrameState frame_state = {0};
+        FrameData  frame_data  = {0};
+        build_frame_data(camera_position, camera_rotation, time, delta, &frame_state, &frame_data);
 
-        sun_direction[0] = cosf(sun_state);
-        sun_direction[1] = sinf(sun_state);
-
-
-        FrameData frame_data = {
-            .camera_vp       = (f32*)camera_vp,
-            .camera_inv_vp   = (f32*)camera_inv_vp,
-            .camera_inv_v    = (f32*)camera_inv_v,
-            .camera_position = (f32*)camera_position,
-            .sun_direction   = (f32*)sun_direction,
-            .time            = time,
-            .delta           = delta
-        };
-
-        render_result = graphics_render_frame(gpu_ctx, &frame_data);
+        render_result = graphics_render_frame(gpu_ctx, job_ctx, &frame_data);
         if(render_result == 1) {
             LOG_ERROR("failed to render frame");
             goto fail;
@@ -93,7 +268,187 @@ i32 main(i32 argc, char** argv) {
             break;
         }
     }
-    
+
+    job_stop(job_ctx);
+
+    return 0;
+
+    fail: {
+        if(job_ctx != NULL) {
+            job_stop(job_ctx);
+        }
+        return 1;
+    }
+}
+
+/* simulation at fixed tick on this thread, rendering on its own thread */
+/* 0 = quit
+   1 = fail */
+i32 run_pipelined(
+    CtxHandle gpu_ctx
+) {
+    RenderThread  render_thread       = (RenderThread){0};
+
+    HANDLE        thread              = NULL;
+    HANDLE        tick_timer          = NULL;
+    LARGE_INTEGER frequency_counter   = (LARGE_INTEGER){0};
+    LARGE_INTEGER performance_counter = (LARGE_INTEGER){0};
+    SimSnapshot   snapshot            = (SimSnapshot){0};
+    b32           is_first_tick       = TRUE;
+
+    if(!QueryPerformanceFrequency(&frequency_counter)) {
+        LOG_ERROR("failed to query frequency counter");
+        goto fail;
+    }
+    if(!QueryPerformanceCounter(&performance_counter)) {
+        LOG_ERROR("failed to query performance counter");
+        goto fail;
+    }
+
+    render_thread = (RenderThread) {
+        .gpu_ctx           = gpu_ctx,
+        .snapshots         = {
+            .write_id  = 0,
+            .shared_id = 1,
+            .read_id   = 2
+        },
+        .counter_frequency = frequency_counter.QuadPart,
+        .tick_counts       = (i64)((f64)frequency_counter.QuadPart / MAIN_SIM_TICK_RATE),
+        .running           = TRUE
+    };
+
+    /* high resolution timer is not available before windows 10 1803 */
+    tick_timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if(tick_timer == NULL) {
+        tick_timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+
+    thread = CreateThread(NULL, 0, render_thread_main, &render_thread, 0, NULL);
+    if(thread == NULL) {
+        LOG_ERROR("failed to create render thread");
+        goto fail;
+    }
+
+    i64 next_tick = performance_counter.QuadPart;
+    while(render_thread.running) {
+        QueryPerformanceCounter(&performance_counter);
+
+        if(performance_counter.QuadPart - next_tick > render_thread.tick_counts * MAIN_SIM_MAX_CATCH_UP) {
+            next_tick = performance_counter.QuadPart;
+        }
+
+        while(performance_counter.QuadPart >= next_tick) {
+            f64 delta = 0.0;
+
+            glm_vec4_copy(snapshot.camera_position, snapshot.camera_position_prev);
+            glm_vec4_copy(snapshot.camera_rotation, snapshot.camera_rotation_prev);
+
+            const i32 update_result = update_level(
+                1.0 / MAIN_SIM_TICK_RATE,
+                snapshot.camera_position,
+                snapshot.camera_rotation,
+                &snapshot.time,
+                &delta
+            );
+            if(update_result == 1) {
+                LOG_ERROR("failed to update level");
+                goto fail;
+            }
+            if(update_result == 2) {
+                goto quit;
+            }
+            if(is_first_tick) {
+                glm_vec4_copy(snapshot.camera_position, snapshot.camera_position_prev);
+                glm_vec4_copy(snapshot.camera_rotation, snapshot.camera_rotation_prev);
+                is_first_tick = FALSE;
+            }
+
+            QueryPerformanceCounter(&performance_counter);
+            snapshot.publish_counter = performance_counter.QuadPart;
+            snapshot_publish(&render_thread.snapshots, &snapshot);
+
+            next_tick += render_thread.tick_counts;
+        }
+
+        /* sleep until next tick */
+        const i64 counts_left = next_tick - performance_counter.QuadPart;
+        if(tick_timer != NULL && counts_left > 0) {
+            const LARGE_INTEGER due_time = {
+                .QuadPart = -(i64)((f64)counts_left * 10000000.0 / (f64)frequency_counter.QuadPart)
+            };
+            SetWaitableTimer(tick_timer, &due_time, 0, NULL, NULL, FALSE);
+            WaitForSingleObject(tick_timer, INFINITE);
+        } else {
+            SwitchToThread();
+        }
+    }
+
+    quit: {
+        InterlockedExchange(&render_thread.running, FALSE);
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+        if(tick_timer != NULL) {
+            CloseHandle(tick_timer);
+        }
+        return render_thread.result == 1 ? 1 : 0;
+    }
+
+    fail: {
+        if(thread != NULL) {
+            InterlockedExchange(&render_thread.running, FALSE);
+            WaitForSingleObject(thread, INFINITE);
+            CloseHandle(thread);
+        }
+        if(tick_timer != NULL) {
+            CloseHandle(tick_timer);
+        }
+        return 1;
+    }
+}
+
+i32 main(i32 argc, char** argv) {
+    /* startup */
+    const GpuInfo gpu_info = {
+        .window_name          = "Wreck",
+        .frame_buffer_x       = 1920,
+        .frame_buffer_y       = 1080,
+        .pci_vendor_id        = 0x1002, /* 0x1002 0x10DE */
+        .pci_device_id        = 0x1638, /* 0x1638 0x25E0 */
+        .vulkan_debug_enabled = FALSE,
+        .frames_in_flight     = 2,
+        .frame_overlap_check  = FALSE
+    };
+    /* frame time becomes max(sim, render) instead of sim + render */
+    const b32 render_thread_enabled = TRUE;
+    /* replays the recorded static frame instead of recording passes on job workers */
+    const b32 baked_frames_enabled  = FALSE;
+
+    CtxHandle gpu_ctx = NULL;
+    CtxHandle res_ctx = NULL;
+
+    gpu_ctx = gpu_start(&gpu_info);
+    res_ctx = res_start();
+
+    if(gpu_ctx == NULL) {
+        LOG_ERROR("failed to start gpu");
+        goto fail;
+    }
+    if(res_ctx == NULL) {
+        LOG_ERROR("failed to start resources");
+        goto fail;
+    }
+
+    if(!graphics_load(gpu_ctx, res_ctx, baked_frames_enabled)) {
+        LOG_ERROR("failed to init graphics");
+        goto fail;
+    }
+
+    /* update_level pumps window messages, so simulation stays on the window thread */
+    const i32 run_result = render_thread_enabled ? run_pipelined(gpu_ctx) : run_serial(gpu_ctx);
+    if(run_result == 1) {
+        goto fail;
+    }
+
     graphics_unload(gpu_ctx);
     gpu_stop(gpu_ctx);
     res_stop(res_ctx);
@@ -104,5 +459,3 @@ i32 main(i32 argc, char** argv) {
         return 1;
     }
 }
-
-
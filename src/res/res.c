@@ -1,41 +1,36 @@
 #include "res.h"
+#include "../arena/arena.h"
 #include <windows.h>
 
-#define RES_VIRTUAL_BASE          (0x0000000000000000)
-#define RES_VIRTUAL_SHADERS_BASE  (0x0000000000000000)
-#define RES_VIRTUAL_SHADERS_LIMIT (0x00000000001FF000)
-#define RES_VIRTUAL_LIMIT         (0x0000000000200000)
+/* context lives at the start of its own permanent arena */
+#define RES_ARENA_PERMANENT_SIZE (0x0000000000010000)
+/* shader binaries, reset by res_free_shaders */
+#define RES_ARENA_SHADERS_SIZE   (0x0000000004000000)
 
 typedef struct {
-    void* base;
-    void* limit;
-    void* shaders_arena_base;
-    void* shaders_arena_limit;
-    u64   shaders_used_size;
-    u64   shaders_commit_size;
+    Arena arena_permanent;
+    Arena arena_shaders;
 } ResContext;
 
 CtxHandle res_start(void) {
-    const u64 context_size = ALIGN(sizeof(ResContext), 0x1000);
-    const u64 virtual_size = context_size + 0x1000 + RES_VIRTUAL_LIMIT;
+    Arena arena_permanent = (Arena){0};
+    if(!arena_create(&arena_permanent, ARENA_LIFETIME_PERMANENT, RES_ARENA_PERMANENT_SIZE)) {
+        LOG_ERROR("failed to create resources permanent arena");
+        goto fail;
+    }
 
-    ResContext* context = VirtualAlloc(NULL, virtual_size, MEM_RESERVE, PAGE_READWRITE);
+    ResContext* context = arena_push(&arena_permanent, sizeof(ResContext), 0);
     if(context == NULL) {
-        LOG_ERROR("failed to allocate resources virtual address space");
+        LOG_ERROR("failed to allocate resources context");
         goto fail;
     }
-    if(VirtualAlloc(context, context_size, MEM_COMMIT, PAGE_READWRITE) == NULL) {
-        LOG_ERROR("failed to commit resources context memory");
+    context->arena_permanent = arena_permanent;
+
+    if(!arena_create(&context->arena_shaders, ARENA_LIFETIME_LEVEL, RES_ARENA_SHADERS_SIZE)) {
+        LOG_ERROR("failed to create resources shaders arena");
         goto fail;
     }
 
-    *context = (ResContext) {
-        .base               = (u8*)context + 0x1000 + RES_VIRTUAL_BASE,
-        .limit              = (u8*)context + 0x1000 + RES_VIRTUAL_LIMIT,
-        .shaders_arena_base  = (u8*)context + 0x1000 + RES_VIRTUAL_SHADERS_BASE,
-        .shaders_arena_limit = (u8*)context + 0x1000 + RES_VIRTUAL_SHADERS_LIMIT
-    };
-
     return context;
 
     fail: {
@@ -46,10 +41,12 @@ CtxHandle res_start(void) {
 void res_stop(
     CtxHandle ctx
 ) {
-    ResContext* context = (ResContext*)ctx;
-    if(!VirtualFree(context, 0, MEM_RELEASE)) {
-        LOG_ERROR("failed to free resources virtual memory");
-    }
+    ResContext* context         = (ResContext*)ctx;
+    Arena       arena_permanent = context->arena_permanent;
+
+    arena_destroy(&context->arena_shaders);
+    /* context is gone after this */
+    arena_destroy(&arena_permanent);
 }
 
 void* res_load_shader(
@@ -57,7 +54,8 @@ void* res_load_shader(
     const char* name,
     u64*        size
 ) {
-    ResContext* res_cxt = (ResContext*)ctx;
+    ResContext*       res_cxt = (ResContext*)ctx;
+    const ArenaMarker marker  = arena_marker(&res_cxt->arena_shaders);
 
     LARGE_INTEGER file_size = (LARGE_INTEGER){0};
     HANDLE        file      = INVALID_HANDLE_VALUE;
@@ -82,32 +80,15 @@ void* res_load_shader(
         goto fail;
     }
 
-    /* commit memory */
-    const u64 shader_offset   = res_cxt->shaders_used_size;
-    const u64 shader_size     = file_size.QuadPart;
-    const u64 new_used_size   = shader_offset + shader_size;
-    const u64 new_commit_size = ALIGN(new_used_size, 0x1000);
-    
-    if(new_commit_size > RES_VIRTUAL_SHADERS_LIMIT - RES_VIRTUAL_SHADERS_BASE) {
-        LOG_ERROR(
-            "shaders exceed dedicated memory space: %llu/%llu", 
-            new_commit_size, (u64)(RES_VIRTUAL_SHADERS_LIMIT - RES_VIRTUAL_SHADERS_BASE)
-        );
+    /* spir-v is read as words */
+    const u64 shader_size   = file_size.QuadPart;
+    void*     shader_buffer = arena_push(&res_cxt->arena_shaders, shader_size, sizeof(u32));
+    if(shader_buffer == NULL) {
+        LOG_ERROR("shaders exceed dedicated memory space: %s", name);
         goto fail;
     }
 
-    if(res_cxt->shaders_commit_size < new_commit_size) {
-        if(VirtualAlloc(res_cxt->shaders_arena_base, new_commit_size, MEM_COMMIT, PAGE_READWRITE) == NULL) {
-            LOG_ERROR("failed to commit shaders memory");
-            goto fail;
-        }
-    }
-    res_cxt->shaders_used_size   = new_used_size;
-    res_cxt->shaders_commit_size = new_commit_size;
-
     /* read file */
-    void* shader_buffer = (u8*)res_cxt->shaders_arena_base + shader_offset;
-
     if(!ReadFile(file, shader_buffer, shader_size, NULL, NULL)) {
         LOG_ERROR("failed to read shader file: %s", name);
         goto fail;
@@ -117,21 +98,12 @@ void* res_load_shader(
     return shader_buffer;
 
     fail: {
+        arena_rewind(&res_cxt->arena_shaders, marker);
         return NULL;
     }
 }
 
 void res_free_shaders(CtxHandle ctx) {
     ResContext* res_cxt = (ResContext*)ctx;
-
-    if(!VirtualFree(
-        res_cxt->shaders_arena_base,
-        res_cxt->shaders_commit_size,
-        MEM_DECOMMIT
-    )) {
-        LOG_ERROR("failed to decommit shaders memory");
-    }
-    
-    res_cxt->shaders_used_size   = 0;
-    res_cxt->shaders_commit_size = 0;
+    arena_reset(&res_cxt->arena_shaders, 0);
 }
@@ -0,0 +1,354 @@
+#include "graph.h"
+#include "../../job/job.h"
+
+#if JOB_MAX_WORKERS > GPU_MAX_RECORD_THREADS
+    #error "job workers are used as gpu record threads"
+#endif
+
+/* images, surface and buffers share one resource index space */
+#define GRAPH_MAX_RESOURCES     (GRAPH_MAX_IMAGES + GRAPH_MAX_BUFFERS)
+#define GRAPH_MAX_PASS_ACCESSES (32)
+
+#if GRAPH_MAX_PASSES > 32
+    #error "pass dependencies are kept as u32 masks"
+#endif
+
+typedef struct {
+    u32 resource;
+    b32 read;
+    b32 write;
+} GraphAccess;
+
+/* one pass recorded by a job worker */
+typedef struct {
+    CtxHandle            gpu_ctx;
+    const GraphPassInfo* pass_info;
+    u32                  pass_id;
+} GraphPassJob;
+
+/* U32_MAX = invalid id */
+u32 graph_image_resource(
+    u32 image_id
+) {
+    if(image_id == GPU_IMAGE_SURFACE_ID) {
+        return GPU_MAX_STATIC_IMAGES;
+    }
+    return (image_id < GPU_MAX_STATIC_IMAGES) ? image_id : U32_MAX;
+}
+
+u32 graph_buffer_resource(
+    u32 buffer_id
+) {
+    return (buffer_id < GPU_MAX_STATIC_BUFFERS) ? GRAPH_MAX_IMAGES + buffer_id : U32_MAX;
+}
+
+b32 graph_add_access(
+    GraphAccess* accesses,
+    u32*         accesses_count,
+    u32          resource,
+    b32          read,
+    b32          write
+) {
+    if(resource == U32_MAX) {
+        LOG_ERROR("invalid graph resource id");
+        goto fail;
+    }
+    if(*accesses_count == GRAPH_MAX_PASS_ACCESSES) {
+        LOG_ERROR("too many pass accesses: %u/%u", *accesses_count, GRAPH_MAX_PASS_ACCESSES);
+        goto fail;
+    }
+
+    accesses[(*accesses_count)++] = (GraphAccess) {
+        .resource = resource,
+        .read     = read,
+        .write    = write
+    };
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+b32 graph_gather_accesses(
+    const GraphPassInfo* pass_info,
+    GraphAccess*         accesses,
+    u32*                 accesses_count
+) {
+    *accesses_count = 0;
+
+    for(u32 i = 0; i != pass_info->images_read_count; i++) {
+        if(!graph_add_access(accesses, accesses_count, graph_image_resource(pass_info->images_read[i]), TRUE, FALSE)) {
+            goto fail;
+        }
+    }
+    for(u32 i = 0; i != pass_info->buffers_read_count; i++) {
+        if(!graph_add_access(accesses, accesses_count, graph_buffer_resource(pass_info->buffers_read[i]), TRUE, FALSE)) {
+            goto fail;
+        }
+    }
+    for(u32 i = 0; i != pass_info->attachments_color_count; i++) {
+        if(!graph_add_access(accesses, accesses_count, graph_image_resource(pass_info->attachments_color[i]), pass_info->do_not_clear, TRUE)) {
+            goto fail;
+        }
+    }
+    if(pass_info->attachment_depth != U32_MAX) {
+        if(!graph_add_access(accesses, accesses_count, graph_image_resource(pass_info->attachment_depth), pass_info->do_not_clear, TRUE)) {
+            goto fail;
+        }
+    }
+
+    return TRUE;
+
+    fail: {
+        LOG_ERROR("invalid graph pass: \"%s\"", pass_info->name);
+        return FALSE;
+    }
+}
+
+b32 graph_compile(
+    const GraphInfo* graph_info,
+    RenderGraph*     graph
+) {
+    const u32   passes_count = graph_info->pass_infos_count;
+
+    GraphAccess accesses       [GRAPH_MAX_PASSES][GRAPH_MAX_PASS_ACCESSES];
+    u32         accesses_counts[GRAPH_MAX_PASSES];
+    /* producers a pass reads from, and everything it has to run after */
+    u32         depends_read   [GRAPH_MAX_PASSES] = {0};
+    u32         depends_order  [GRAPH_MAX_PASSES] = {0};
+    u32         last_writers   [GRAPH_MAX_RESOURCES];
+    u32         readers        [GRAPH_MAX_RESOURCES] = {0};
+
+    if(passes_count > GRAPH_MAX_PASSES) {
+        LOG_ERROR("too many graph passes: %u/%u", passes_count, GRAPH_MAX_PASSES);
+        goto fail;
+    }
+
+    *graph = (RenderGraph){0};
+    for(u32 i = 0; i != GRAPH_MAX_RESOURCES; i++) {
+        last_writers[i] = U32_MAX;
+    }
+
+    /* dependencies, declaration order defines which write a read sees */
+    for(u32 i = 0; i != passes_count; i++) {
+        if(!graph_gather_accesses(&graph_info->pass_infos[i], accesses[i], &accesses_counts[i])) {
+            goto fail;
+        }
+
+        for(u32 j = 0; j != accesses_counts[i]; j++) {
+            const GraphAccess* access      = &accesses[i][j];
+            const u32          last_writer = last_writers[access->resource];
+
+            /* read after write */
+            if(access->read && last_writer != U32_MAX) {
+                depends_read [i] |= 1u << last_writer;
+                depends_order[i] |= 1u << last_writer;
+            }
+            /* write after write and write after read */
+            if(access->write) {
+                if(last_writer != U32_MAX) {
+                    depends_order[i] |= 1u << last_writer;
+                }
+                depends_order[i] |= readers[access->resource] & ~(1u << i);
+            }
+        }
+        for(u32 j = 0; j != accesses_counts[i]; j++) {
+            const GraphAccess* access = &accesses[i][j];
+
+            if(access->write) {
+                last_writers[access->resource] = i;
+                readers     [access->resource] = 0;
+            }
+            else {
+                readers[access->resource] |= 1u << i;
+            }
+        }
+    }
+
+    /* culling, producers always come before their readers so one backward sweep is enough */
+    u32 live = 0;
+    for(u32 i = 0; i != graph_info->images_output_count; i++) {
+        const u32 resource = graph_image_resource(graph_info->images_output[i]);
+
+        if(resource == U32_MAX) {
+            LOG_ERROR("invalid graph output image: %u", graph_info->images_output[i]);
+            goto fail;
+        }
+        if(last_writers[resource] == U32_MAX) {
+            LOG_WARNING("graph output image is never written: %u", graph_info->images_output[i]);
+            continue;
+        }
+        live |= 1u << last_writers[resource];
+    }
+    for(u32 i = passes_count; i != 0; i--) {
+        if(live & (1u << (i - 1))) {
+            live |= depends_read[i - 1];
+        }
+    }
+
+    /* topological order, among ready passes the earliest declared goes first */
+    u32 scheduled = 0;
+    while(scheduled != live) {
+        u32 next = U32_MAX;
+        for(u32 i = 0; i != passes_count; i++) {
+            const u32 pass_bit = 1u << i;
+
+            if(!(live & pass_bit) || (scheduled & pass_bit)) {
+                continue;
+            }
+            if((depends_order[i] & live & ~scheduled) == 0) {
+                next = i;
+                break;
+            }
+        }
+        if(next == U32_MAX) {
+            LOG_ERROR("graph has a dependency cycle");
+            goto fail;
+        }
+
+        scheduled |= 1u << next;
+        graph->passes[graph->passes_count++] = &graph_info->pass_infos[next];
+    }
+    graph->passes_culled = passes_count - graph->passes_count;
+
+    /* lifetimes in execution order */
+    GraphLifetime lifetimes[GRAPH_MAX_RESOURCES];
+    for(u32 i = 0; i != GRAPH_MAX_RESOURCES; i++) {
+        lifetimes[i] = (GraphLifetime) {U32_MAX, U32_MAX};
+    }
+
+    for(u32 i = 0; i != graph->passes_count; i++) {
+        const u32 pass_id = (u32)(graph->passes[i] - graph_info->pass_infos);
+
+        for(u32 j = 0; j != accesses_counts[pass_id]; j++) {
+            const GraphAccess* access   = &accesses[pass_id][j];
+            GraphLifetime*     lifetime = &lifetimes[access->resource];
+
+            if(lifetime->first_pass == U32_MAX) {
+                lifetime->first_pass = i;
+            }
+            lifetime->last_pass = i;
+        }
+    }
+    memcpy(graph->image_lifetimes,  lifetimes,                    sizeof(graph->image_lifetimes ));
+    memcpy(graph->buffer_lifetimes, lifetimes + GRAPH_MAX_IMAGES, sizeof(graph->buffer_lifetimes));
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
+
+/* passes drawing to the surface cover the screen, the rest only the render area of their targets */
+DrawingInfo graph_drawing_info(
+    const GraphPassInfo* pass_info,
+    u32                  screen_x,
+    u32                  screen_y,
+    u32                  render_x,
+    u32                  render_y
+) {
+    b32 is_surface = FALSE;
+    for(u32 i = 0; i != pass_info->attachments_color_count; i++) {
+        if(pass_info->attachments_color[i] == GPU_IMAGE_SURFACE_ID) {
+            is_surface = TRUE;
+        }
+    }
+
+    return (DrawingInfo) {
+        .do_not_clear            = pass_info->do_not_clear,
+        .offset_x                = 0,
+        .offset_y                = 0,
+        .size_x                  = is_surface ? screen_x : render_x,
+        .size_y                  = is_surface ? screen_y : render_y,
+        .min_depth               = 0.0,
+        .max_depth               = 1.0,
+        .attachments_color       = pass_info->attachments_color,
+        .images_read             = pass_info->images_read,
+        .buffers_read            = pass_info->buffers_read,
+        .attachment_depth        = pass_info->attachment_depth,
+        .attachments_color_count = pass_info->attachments_color_count,
+        .images_read_count       = pass_info->images_read_count,
+        .buffers_read_count      = pass_info->buffers_read_count
+    };
+}
+
+void record_graph_pass_job(
+    void* data,
+    u32   worker_id
+) {
+    const GraphPassJob* pass_job = (const GraphPassJob*)data;
+
+    if(!gpu_render_pass_begin(pass_job->gpu_ctx, pass_job->pass_id, worker_id)) {
+        LOG_ERROR("failed to begin pass: \"%s\"", pass_job->pass_info->name);
+        return;
+    }
+    gpu_render_pass_bind_graphics_pipeline(pass_job->gpu_ctx, pass_job->pass_id, pass_job->pass_info->pipeline_id, NULL);
+    pass_job->pass_info->draw(pass_job->gpu_ctx, pass_job->pass_id, pass_job->pass_info->draw_data);
+    gpu_render_pass_end(pass_job->gpu_ctx, pass_job->pass_id);
+}
+
+b32 graph_execute(
+    CtxHandle          gpu_ctx,
+    CtxHandle          job_ctx,
+    const RenderGraph* graph,
+    b32                baked,
+    u32                screen_x,
+    u32                screen_y,
+    u32                render_x,
+    u32                render_y
+) {
+    GraphPassJob pass_jobs[GRAPH_MAX_PASSES] = {0};
+    JobCounter   passes_counter              = {0};
+
+    /* baked passes are recorded in place */
+    if(baked) {
+        for(u32 i = 0; i != graph->passes_count; i++) {
+            const GraphPassInfo* pass_info    = graph->passes[i];
+            const DrawingInfo    drawing_info = graph_drawing_info(pass_info, screen_x, screen_y, render_x, render_y);
+
+            gpu_render_begin_drawing(gpu_ctx, &drawing_info);
+            gpu_render_bind_graphics_pipeline(gpu_ctx, pass_info->pipeline_id, NULL);
+            pass_info->draw(gpu_ctx, GPU_INLINE_PASS_ID, pass_info->draw_data);
+            gpu_render_end_drawing(gpu_ctx);
+        }
+        return TRUE;
+    }
+
+    /* passes are declared in order, contents are recorded on job workers */
+    gpu_render_begin_passes(gpu_ctx);
+
+    for(u32 i = 0; i != graph->passes_count; i++) {
+        const GraphPassInfo* pass_info    = graph->passes[i];
+        const DrawingInfo    drawing_info = graph_drawing_info(pass_info, screen_x, screen_y, render_x, render_y);
+        const u32            pass_id      = gpu_render_declare_pass(gpu_ctx, &drawing_info);
+
+        if(pass_id == U32_MAX) {
+            LOG_ERROR("failed to declare pass: \"%s\"", pass_info->name);
+            goto fail;
+        }
+
+        pass_jobs[i] = (GraphPassJob) {
+            .gpu_ctx   = gpu_ctx,
+            .pass_info = pass_info,
+            .pass_id   = pass_id
+        };
+    }
+
+    for(u32 i = 0; i != graph->passes_count; i++) {
+        job_submit(job_ctx, record_graph_pass_job, &pass_jobs[i], &passes_counter, NULL);
+    }
+    job_wait(job_ctx, &passes_counter);
+    if(!gpu_render_end_passes(gpu_ctx)) {
+        LOG_ERROR("failed to record graph passes");
+        goto fail;
+    }
+
+    return TRUE;
+
+    fail: {
+        return FALSE;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef _GRAPHICS_GRAPH_INCLUDED
+#define _GRAPHICS_GRAPH_INCLUDED
+
+#include "../../gpu/gpu.h"
+
+#define GRAPH_MAX_PASSES  (16)
+/* static images and the surface */
+#define GRAPH_MAX_IMAGES  (GPU_MAX_STATIC_IMAGES + 1)
+#define GRAPH_MAX_BUFFERS (GPU_MAX_STATIC_BUFFERS)
+
+/* records pass contents through gpu_render_pass_* with pass_id, pipeline is already bound */
+typedef void (*GraphDrawFunc)(CtxHandle gpu_ctx, u32 pass_id, const void* draw_data);
+
+/* attachments are written, kept attachments (do_not_clear) are read too */
+typedef struct {
+    const char*   name;
+    u32           pipeline_id;
+    GraphDrawFunc draw;
+    const void*   draw_data;
+    b32           do_not_clear;
+    const u32*    images_read;
+    const u32*    buffers_read;
+    const u32*    attachments_color;
+    u32           attachment_depth;
+    u32           images_read_count;
+    u32           buffers_read_count;
+    u32           attachments_color_count;
+} GraphPassInfo;
+
+/* passes that don't contribute to outputs are culled */
+typedef struct {
+    const GraphPassInfo* pass_infos;
+    const u32*           images_output;
+    u32                  pass_infos_count;
+    u32                  images_output_count;
+} GraphInfo;
+
+/* first and last compiled pass using a resource, U32_MAX = unused */
+typedef struct {
+    u32 first_pass;
+    u32 last_pass;
+} GraphLifetime;
+
+typedef struct {
+    /* live passes in execution order */
+    const GraphPassInfo* passes[GRAPH_MAX_PASSES];
+    GraphLifetime        image_lifetimes [GRAPH_MAX_IMAGES];
+    GraphLifetime        buffer_lifetimes[GRAPH_MAX_BUFFERS];
+    u32                  passes_count;
+    u32                  passes_culled;
+} RenderGraph;
+
+/* structure only, screen size is applied at execution */
+/* barriers are not planned here on purpose, they depend on state the graph never sees: contents carried over */
+/* from earlier frames, acquired uploads, async compute ownership and aliased memory */
+/* gpu_render derives them per pass from the same declared reads and writes and drops redundant ones */
+b32 graph_compile(const GraphInfo* graph_info, RenderGraph* graph);
+/* baked records in place, otherwise passes are recorded on job workers */
+/* passes drawing to the surface get the screen size, others the render size */
+b32 graph_execute(CtxHandle gpu_ctx, CtxHandle job_ctx, const RenderGraph* graph, b32 baked, u32 screen_x, u32 screen_y, u32 render_x, u32 render_y);
+
+#endif
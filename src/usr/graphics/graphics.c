@@ -4,8 +4,37 @@
 
 #include "resources.h"
 #include "pipelines.h"
+#include "graph.h"
 
 static PipelineInfo pipeline_infos[PIPELINE_COUNT] = {0};
+static RenderGraph  frame_graph                    = {0};
+/* see graphics_load */
+static b32          frames_baked                   = FALSE;
+
+/* render area is scaled toward the target gpu frame time, milliseconds */
+#define GRAPHICS_TARGET_GPU_TIME   (14.0f)
+#define GRAPHICS_MIN_RENDER_SCALE  (0.5f)
+/* frames averaged per adjustment, every change rerecords bakes */
+#define GRAPHICS_SCALE_FRAMES      (32)
+#define GRAPHICS_SCALE_STEP        (0.05f)
+
+typedef struct {
+    f32 scale;
+    f32 gpu_time_sum;
+    u32 gpu_time_frames;
+    u32 render_x;
+    u32 render_y;
+} RenderScale;
+
+static RenderScale render_scale = {.scale = 1.0f};
+
+typedef struct {
+    const FrameData* frame_data;
+    u32              screen_x;
+    u32              screen_y;
+    u32              render_x;
+    u32              render_y;
+} GlobalLatch;
 
 b32 generate_graphics_pipeline(
     CtxHandle        res_ctx,
@@ -151,10 +180,176 @@ b32 load_shaders(
 }
 
 
+/* draw_data points to the vertex count */
+void draw_vertices(
+    CtxHandle   gpu_ctx,
+    u32         pass_id,
+    const void* draw_data
+) {
+    gpu_render_pass_draw(gpu_ctx, pass_id, 1, *(const i32*)draw_data);
+}
+
+/* declaration order, passes that don't end up on the surface are culled */
+static const GraphPassInfo frame_passes[] = {
+    {
+        .name                    = "skybox",
+        .pipeline_id             = PIPELINE_SKYBOX,
+        .draw                    = draw_vertices,
+        .draw_data               = &(i32){6},
+        .buffers_read_count      = 1,
+        .buffers_read            = (u32[]) {
+            BUFFER_GLOBAL
+        },
+        .attachments_color_count = 1,
+        .attachments_color       = (u32[]) {
+            IMAGE_SCREEN_COLOR
+        },
+        .attachment_depth        = IMAGE_SCREEN_DEPTH
+    },
+    {
+        .name                    = "copy color",
+        .pipeline_id             = PIPELINE_COLOR_BLIT,
+        .draw                    = draw_vertices,
+        .draw_data               = &(i32){6},
+        .buffers_read_count      = 1,
+        .buffers_read            = (u32[]) {
+            BUFFER_GLOBAL
+        },
+        .images_read_count       = 1,
+        .images_read             = (u32[]) {
+            IMAGE_SCREEN_COLOR
+        },
+        .attachments_color_count = 1,
+        .attachments_color       = (u32[]) {
+            IMAGE_COPY_COLOR
+        },
+        .attachment_depth        = U32_MAX
+    },
+    {
+        .name                    = "water",
+        .pipeline_id             = PIPELINE_WATER_SURFACE,
+        .draw                    = draw_vertices,
+        .draw_data               = &(i32){(600*600 + (4) * 8) * 6},
+        .do_not_clear            = TRUE,
+        .buffers_read_count      = 1,
+        .buffers_read            = (u32[]) {
+            BUFFER_GLOBAL
+        },
+        .images_read_count       = 1,
+        .images_read             = (u32[]) {
+            IMAGE_COPY_COLOR
+        },
+        .attachments_color_count = 1,
+        .attachments_color       = (u32[]) {
+            IMAGE_SCREEN_COLOR
+        },
+        .attachment_depth        = IMAGE_SCREEN_DEPTH
+    },
+    {
+        .name                    = "copy depth",
+        .pipeline_id             = PIPELINE_DEPTH_BLIT,
+        .draw                    = draw_vertices,
+        .draw_data               = &(i32){6},
+        .buffers_read_count      = 1,
+        .buffers_read            = (u32[]) {
+            BUFFER_GLOBAL
+        },
+        .images_read_count       = 1,
+        .images_read             = (u32[]) {
+            IMAGE_SCREEN_DEPTH
+        },
+        .attachments_color_count = 1,
+        .attachments_color       = (u32[]) {
+            IMAGE_COPY_DEPTH
+        },
+        .attachment_depth        = U32_MAX
+    },
+    {
+        .name                    = "copy color",
+        .pipeline_id             = PIPELINE_COLOR_BLIT,
+        .draw                    = draw_vertices,
+        .draw_data               = &(i32){6},
+        .buffers_read_count      = 1,
+        .buffers_read            = (u32[]) {
+            BUFFER_GLOBAL
+        },
+        .images_read_count       = 1,
+        .images_read             = (u32[]) {
+            IMAGE_SCREEN_COLOR
+        },
+        .attachments_color_count = 1,
+        .attachments_color       = (u32[]) {
+            IMAGE_COPY_COLOR
+        },
+        .attachment_depth        = U32_MAX
+    },
+    {
+        .name                    = "underwater",
+        .pipeline_id             = PIPELINE_UNDERWATER,
+        .draw                    = draw_vertices,
+        .draw_data               = &(i32){32 * 32 * 6},
+        .do_not_clear            = TRUE,
+        .buffers_read_count      = 1,
+        .buffers_read            = (u32[]) {
+            BUFFER_GLOBAL
+        },
+        .images_read_count       = 2,
+        .images_read             = (u32[]) {
+            IMAGE_COPY_COLOR,
+            IMAGE_SCREEN_DEPTH
+        },
+        .attachments_color_count = 1,
+        .attachments_color       = (u32[]) {
+            IMAGE_SCREEN_COLOR
+        },
+        .attachment_depth        = U32_MAX
+    },
+    {
+        .name                    = "surface blit",
+        .pipeline_id             = PIPELINE_SURFACE_BLIT,
+        .draw                    = draw_vertices,
+        .draw_data               = &(i32){6},
+        .buffers_read_count      = 1,
+        .buffers_read            = (u32[]) {
+            BUFFER_GLOBAL
+        },
+        .images_read_count       = 1,
+        .images_read             = (u32[]) {
+            IMAGE_SCREEN_COLOR
+        },
+        .attachments_color_count = 1,
+        .attachments_color       = (u32[]) {
+            IMAGE_SURFACE
+        },
+        .attachment_depth        = U32_MAX
+    }
+};
+
 b32 graphics_load(
     CtxHandle gpu_ctx, 
-    CtxHandle res_ctx
+    CtxHandle res_ctx,
+    b32       baked_frames
 ) {
+    frames_baked = baked_frames;
+
+    /* frame graph is static, ordered and culled once, transient images alias by its lifetimes */ {
+        const GraphInfo graph_info = {
+            .pass_infos          = frame_passes,
+            .pass_infos_count    = ARRAY_SIZE(frame_passes),
+            .images_output       = (u32[]) {
+                IMAGE_SURFACE
+            },
+            .images_output_count = 1
+        };
+        if(!graph_compile(&graph_info, &frame_graph)) {
+            LOG_ERROR("failed to compile frame graph");
+            goto fail;
+        }
+        LOG_MESSAGE(
+            "frame graph: %u passes, %u culled",
+            frame_graph.passes_count, frame_graph.passes_culled
+        );
+    }
 
     /* compile pipelines */ {
         if(!load_shaders(res_ctx, shader_table, pipeline_infos)) {
@@ -179,10 +374,17 @@ b32 graphics_load(
     }    
 
     /* allocate resources */ {
+        ImageInfo frame_image_infos[IMAGE_COUNT];
+        for(u32 i = 0; i != IMAGE_COUNT; i++) {
+            frame_image_infos[i]                = image_infos[i];
+            frame_image_infos[i].lifetime_first = frame_graph.image_lifetimes[i].first_pass;
+            frame_image_infos[i].lifetime_last  = frame_graph.image_lifetimes[i].last_pass;
+        }
+
         const ResourcesInfo resources_info = {
             .buffer_infos       = buffer_infos,
             .buffer_infos_count = BUFFER_COUNT,
-            .image_infos        = image_infos,
+            .image_infos        = frame_image_infos,
             .image_infos_count  = IMAGE_COUNT
         };
         if(!gpu_allocate_resources(gpu_ctx, &resources_info)) {
@@ -207,6 +409,86 @@ b32 graphics_load(
     }
 }
 
+void update_render_scale(
+    RenderScale* scale,
+    f32          gpu_time
+) {
+    if(gpu_time <= 0.0f) {
+        return;
+    }
+    scale->gpu_time_sum += gpu_time;
+    scale->gpu_time_frames++;
+    if(scale->gpu_time_frames < GRAPHICS_SCALE_FRAMES) {
+        return;
+    }
+
+    const f32 average = scale->gpu_time_sum / (f32)scale->gpu_time_frames;
+    scale->gpu_time_sum    = 0.0f;
+    scale->gpu_time_frames = 0;
+
+    /* dead zone keeps the scale from oscillating around the target */
+    const f32 ratio = GRAPHICS_TARGET_GPU_TIME / average;
+    if(ratio > 0.8f && ratio < 1.1f) {
+        return;
+    }
+
+    /* pixel cost is quadratic in scale, (1 + r) / 2 is sqrt(r) close to 1 */
+    f32 new_scale = scale->scale * (1.0f + ratio) * 0.5f;
+    new_scale = CLAMP(GRAPHICS_MIN_RENDER_SCALE, 1.0f, new_scale);
+    new_scale = (f32)(u32)(new_scale / GRAPHICS_SCALE_STEP + 0.5f) * GRAPHICS_SCALE_STEP;
+    scale->scale = MIN(new_scale, 1.0f);
+}
+
+/* late latch, camera is sampled right before the frame is submitted */
+void latch_global_buffer(
+    CtxHandle gpu_ctx,
+    void*     user_data
+) {
+    const GlobalLatch* global_latch = (const GlobalLatch*)user_data;
+    const FrameData*   frame_data   = global_latch->frame_data;
+    const u32          screen_x     = global_latch->screen_x;
+    const u32          screen_y     = global_latch->screen_y;
+    const u32          render_x     = global_latch->render_x;
+    const u32          render_y     = global_latch->render_y;
+
+    if(frame_data->latch != NULL) {
+        frame_data->latch(frame_data->latch_data);
+    }
+
+    const f32* sun_direction = frame_data->sun_direction;
+    const f32* cam_position  = frame_data->camera_position;
+    const f32* cam_vp        = frame_data->camera_vp;
+    const f32* cam_inv_vp    = frame_data->camera_inv_vp;
+    const f32* cam_inv_v     = frame_data->camera_inv_v;
+
+    const GlobalBuffer global_buffer = {
+        .screen_params   = {(f32)render_x, (f32)render_y, (f32)screen_x, (f32)screen_y},
+        .sun_direction   = {sun_direction[0], sun_direction[1], sun_direction[2], sun_direction[3]},
+        .camera_position = {cam_position[0], cam_position[1], cam_position[2], cam_position[3]},
+        .time            = {frame_data->time, frame_data->delta, 0.0, 0.0},
+        .camera_vp       = {
+            cam_vp[0 ], cam_vp[1 ], cam_vp[2 ], cam_vp[3 ],
+            cam_vp[4 ], cam_vp[5 ], cam_vp[6 ], cam_vp[7 ],
+            cam_vp[8 ], cam_vp[9 ], cam_vp[10], cam_vp[11],
+            cam_vp[12], cam_vp[13], cam_vp[14], cam_vp[15]
+        },
+        .camera_inv_vp   = {
+            cam_inv_vp[0 ], cam_inv_vp[1 ], cam_inv_vp[2 ], cam_inv_vp[3 ],
+            cam_inv_vp[4 ], cam_inv_vp[5 ], cam_inv_vp[6 ], cam_inv_vp[7 ],
+            cam_inv_vp[8 ], cam_inv_vp[9 ], cam_inv_vp[10], cam_inv_vp[11],
+            cam_inv_vp[12], cam_inv_vp[13], cam_inv_vp[14], cam_inv_vp[15]
+        },
+        .camera_inv_v    = {
+            cam_inv_v[0 ], cam_inv_v[1 ], cam_inv_v[2 ], cam_inv_v[3 ],
+            cam_inv_v[4 ], cam_inv_v[5 ], cam_inv_v[6 ], cam_inv_v[7 ],
+            cam_inv_v[8 ], cam_inv_v[9 ], cam_inv_v[10], cam_inv_v[11],
+            cam_inv_v[12], cam_inv_v[13], cam_inv_v[14], cam_inv_v[15]
+        }
+    };
+
+    gpu_render_write_buffer(gpu_ctx, BUFFER_GLOBAL, &global_buffer, 0, sizeof(GlobalBuffer));
+}
+
 void graphics_unload(
     CtxHandle gpu_ctx
 ) {
@@ -217,11 +499,12 @@ void graphics_unload(
 
 i32 graphics_render_frame(
     CtxHandle        gpu_ctx, 
+    CtxHandle        job_ctx,
     const FrameData* frame_data
 ) {
-    u32 screen_x = 0;
-    u32 screen_y = 0;
-
+    const b32 baked    = frames_baked;
+    u32       screen_x = 0;
+    u32       screen_y = 0;
     
     /* begin frame */
     i32 frame_begin_result = gpu_render_frame_begin(gpu_ctx, &screen_x, &screen_y);
@@ -233,210 +516,43 @@ i32 graphics_render_frame(
         goto close;
     }
 
-    /* transfer sync buffers */ {
-        const f32* sun_direction = frame_data->sun_direction;
-        const f32* cam_position  = frame_data->camera_position;
-        const f32* cam_vp        = frame_data->camera_vp;
-        const f32* cam_inv_vp    = frame_data->camera_inv_vp;
-        const f32* cam_inv_v     = frame_data->camera_inv_v;
-
-        const GlobalBuffer global_buffer = {
-            .screen_params   = {(f32)screen_x, (f32)screen_y, (f32)FRAME_BUFFER_SIZE_X, (f32)FRAME_BUFFER_SIZE_Y},
-            .sun_direction   = {sun_direction[0], sun_direction[1], sun_direction[2], sun_direction[3]},
-            .camera_position = {cam_position[0], cam_position[1], cam_position[2], cam_position[3]},
-            .time            = {frame_data->time, frame_data->delta, 0.0, 0.0},
-            .camera_vp       = {
-                cam_vp[0 ], cam_vp[1 ], cam_vp[2 ], cam_vp[3 ],
-                cam_vp[4 ], cam_vp[5 ], cam_vp[6 ], cam_vp[7 ],
-                cam_vp[8 ], cam_vp[9 ], cam_vp[10], cam_vp[11],
-                cam_vp[12], cam_vp[13], cam_vp[14], cam_vp[15]
-            },
-            .camera_inv_vp   = {
-                cam_inv_vp[0 ], cam_inv_vp[1 ], cam_inv_vp[2 ], cam_inv_vp[3 ],
-                cam_inv_vp[4 ], cam_inv_vp[5 ], cam_inv_vp[6 ], cam_inv_vp[7 ],
-                cam_inv_vp[8 ], cam_inv_vp[9 ], cam_inv_vp[10], cam_inv_vp[11],
-                cam_inv_vp[12], cam_inv_vp[13], cam_inv_vp[14], cam_inv_vp[15]
-            },
-            .camera_inv_v    = {
-                cam_inv_v[0 ], cam_inv_v[1 ], cam_inv_v[2 ], cam_inv_v[3 ],
-                cam_inv_v[4 ], cam_inv_v[5 ], cam_inv_v[6 ], cam_inv_v[7 ],
-                cam_inv_v[8 ], cam_inv_v[9 ], cam_inv_v[10], cam_inv_v[11],
-                cam_inv_v[12], cam_inv_v[13], cam_inv_v[14], cam_inv_v[15]
-            }
-        };
-
-        gpu_render_write_buffer(gpu_ctx, BUFFER_GLOBAL, &global_buffer, 0, sizeof(GlobalBuffer));
+    /* render area follows the gpu time of retired frames, frame buffers are screen sized */
+    update_render_scale(&render_scale, gpu_render_frame_gpu_time(gpu_ctx));
+    const f32 scale    = render_scale.scale;
+    const u32 render_x = CLAMP(1, screen_x, (u32)((f32)screen_x * scale));
+    const u32 render_y = CLAMP(1, screen_y, (u32)((f32)screen_y * scale));
+    if(render_x != render_scale.render_x || render_y != render_scale.render_y) {
+        render_scale.render_x = render_x;
+        render_scale.render_y = render_y;
+        gpu_render_bake_invalidate(gpu_ctx);
     }
 
-    /* skybox */ {
-        const DrawingInfo skybox_drawing_info = (DrawingInfo) {
-            .offset_x                = 0,
-            .offset_y                = 0,
-            .size_x                  = screen_x,
-            .size_y                  = screen_y,
-            .min_depth               = 0.0,
-            .max_depth               = 1.0,
-            .buffers_read_count      = 1,
-            .buffers_read            = (u32[]) {
-                BUFFER_GLOBAL
-            },
-            .attachments_color_count = 1,
-            .attachments_color       = (u32[]) {
-                IMAGE_SCREEN_COLOR
-            },
-            .attachment_depth        = IMAGE_SCREEN_DEPTH
-        };
-        
-        gpu_render_begin_drawing(gpu_ctx, &skybox_drawing_info);
-        gpu_render_bind_graphics_pipeline(gpu_ctx, PIPELINE_SKYBOX);
-        gpu_render_draw(gpu_ctx, 1, 6);
-        gpu_render_end_drawing(gpu_ctx);
-    }
-
-    /* copy color */ {
-        const DrawingInfo copy_color_drawing_info = (DrawingInfo) {
-            .offset_x                = 0,
-            .offset_y                = 0,
-            .size_x                  = screen_x,
-            .size_y                  = screen_y,
-            .min_depth               = 0.0,
-            .max_depth               = 1.0,
-            .buffers_read_count      = 1,
-            .buffers_read            = (u32[]) {
-                BUFFER_GLOBAL
-            },
-            .images_read_count       = 1,
-            .images_read             = (u32[]) {
-                IMAGE_SCREEN_COLOR
-            },
-            .attachments_color_count = 1,
-            .attachments_color       = (u32[]) {
-                IMAGE_COPY_COLOR
-            },
-            .attachment_depth        = U32_MAX
-        };
-        
-        gpu_render_begin_drawing(gpu_ctx, &copy_color_drawing_info);
-        gpu_render_bind_graphics_pipeline(gpu_ctx, PIPELINE_COLOR_BLIT);
-        gpu_render_draw(gpu_ctx, 1, 6);
-        gpu_render_end_drawing(gpu_ctx);
-    }
-
-    /* water */ {
-        const DrawingInfo water_drawing_info = (DrawingInfo) {
-            .do_not_clear            = TRUE,
-            .offset_x                = 0,
-            .offset_y                = 0,
-            .size_x                  = screen_x,
-            .size_y                  = screen_y,
-            .min_depth               = 0.0,
-            .max_depth               = 1.0,
-            .buffers_read_count      = 1,
-            .buffers_read            = (u32[]) {
-                BUFFER_GLOBAL
-            },
-            .images_read_count       = 1,
-            .images_read             = (u32[]) {
-                IMAGE_COPY_COLOR
-            },
-            .attachments_color_count = 1,
-            .attachments_color       = (u32[]) {
-                IMAGE_SCREEN_COLOR
-            },
-            .attachment_depth        = IMAGE_SCREEN_DEPTH
-        };
-
-        gpu_render_begin_drawing(gpu_ctx, &water_drawing_info);
-        gpu_render_bind_graphics_pipeline(gpu_ctx, PIPELINE_WATER_SURFACE);
-        gpu_render_draw(gpu_ctx, 1, (600*600 + (4) * 8) * 6);
-        gpu_render_end_drawing(gpu_ctx);
-    }
+    /* global buffer is written by the latch, at submit */
+    const GlobalLatch global_latch = {
+        .frame_data = frame_data,
+        .screen_x   = screen_x,
+        .screen_y   = screen_y,
+        .render_x   = render_x,
+        .render_y   = render_y
+    };
+    gpu_render_set_latch(gpu_ctx, latch_global_buffer, (void*)&global_latch);
 
-    /* copy color */ {
-        const DrawingInfo copy_color_drawing_info = (DrawingInfo) {
-            .offset_x                = 0,
-            .offset_y                = 0,
-            .size_x                  = screen_x,
-            .size_y                  = screen_y,
-            .min_depth               = 0.0,
-            .max_depth               = 1.0,
-            .buffers_read_count      = 1,
-            .buffers_read            = (u32[]) {
-                BUFFER_GLOBAL
-            },
-            .images_read_count       = 1,
-            .images_read             = (u32[]) {
-                IMAGE_SCREEN_COLOR
-            },
-            .attachments_color_count = 1,
-            .attachments_color       = (u32[]) {
-                IMAGE_COPY_COLOR
-            },
-            .attachment_depth        = U32_MAX
-        };
-        
-        gpu_render_begin_drawing(gpu_ctx, &copy_color_drawing_info);
-        gpu_render_bind_graphics_pipeline(gpu_ctx, PIPELINE_COLOR_BLIT);
-        gpu_render_draw(gpu_ctx, 1, 6);
-        gpu_render_end_drawing(gpu_ctx);
+    /* baked frame is replayed when nothing changed since it was recorded */
+    if(baked) {
+        if(!gpu_render_bake_begin(gpu_ctx)) {
+            goto bake_end;
+        }
     }
 
-    /* underwater */ {
-        const DrawingInfo underwater_drawing_info = (DrawingInfo) {
-            .do_not_clear            = TRUE,
-            .offset_x                = 0,
-            .offset_y                = 0,
-            .size_x                  = screen_x,
-            .size_y                  = screen_y,
-            .min_depth               = 0.0,
-            .max_depth               = 1.0,
-            .buffers_read_count      = 1,
-            .buffers_read            = (u32[]) {
-                BUFFER_GLOBAL
-            },
-            .images_read_count       = 2,
-            .images_read             = (u32[]) {
-                IMAGE_COPY_COLOR,
-                IMAGE_SCREEN_DEPTH
-            },
-            .attachments_color_count = 1,
-            .attachments_color       = (u32[]) {
-                IMAGE_SCREEN_COLOR
-            },
-            .attachment_depth        = U32_MAX
-        };
-        
-        gpu_render_begin_drawing(gpu_ctx, &underwater_drawing_info);
-        gpu_render_bind_graphics_pipeline(gpu_ctx, PIPELINE_UNDERWATER);
-        gpu_render_draw(gpu_ctx, 1, 32 * 32 * 6);
-        gpu_render_end_drawing(gpu_ctx);
+    if(!graph_execute(gpu_ctx, job_ctx, &frame_graph, baked, screen_x, screen_y, render_x, render_y)) {
+        LOG_ERROR("failed to execute frame graph");
+        goto fail;
     }
 
-    /* surface blit */ {
-        const DrawingInfo surface_blit_drawing_info = (DrawingInfo) {
-            .offset_x                = 0,
-            .offset_y                = 0,
-            .size_x                  = screen_x,
-            .size_y                  = screen_y,
-            .buffers_read_count      = 1,
-            .buffers_read            = (u32[]) {
-                BUFFER_GLOBAL
-            },
-            .images_read_count       = 1,
-            .images_read             = (u32[]) {
-                IMAGE_SCREEN_COLOR
-            },
-            .attachments_color_count = 1,
-            .attachments_color       = (u32[]) {
-                IMAGE_SURFACE
-            },
-            .attachment_depth        = U32_MAX
-        };
+    bake_end: {}
 
-        gpu_render_begin_drawing(gpu_ctx, &surface_blit_drawing_info);
-        gpu_render_bind_graphics_pipeline(gpu_ctx, PIPELINE_SURFACE_BLIT);
-        gpu_render_draw(gpu_ctx, 1, 6);
-        gpu_render_end_drawing(gpu_ctx);
+    if(baked) {
+        gpu_render_bake_end(gpu_ctx);
     }
 
     /* end frame */
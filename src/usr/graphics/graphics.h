@@ -3,18 +3,26 @@
 
 #include "../../base.h"
 
+/* refreshes camera data FrameData points to, called right before submit */
+typedef void (*FrameLatchFunc)(void* latch_data);
+
 typedef struct {
-    const f32* camera_vp;
-    const f32* camera_inv_vp;
-    const f32* camera_inv_v;
-    const f32* camera_position;
-    const f32* sun_direction;
-    f64        time;
-    f64        delta;
+    const f32*     camera_vp;
+    const f32*     camera_inv_vp;
+    const f32*     camera_inv_v;
+    const f32*     camera_position;
+    const f32*     sun_direction;
+    f64            time;
+    f64            delta;
+    /* optional */
+    FrameLatchFunc latch;
+    void*          latch_data;
 } FrameData;
 
-b32  graphics_load(CtxHandle gpu_ctx, CtxHandle res_ctx);
+/* baked_frames records the static frame once per swapchain image and replays it */
+/* otherwise passes are recorded in parallel on job workers every frame */
+b32  graphics_load(CtxHandle gpu_ctx, CtxHandle res_ctx, b32 baked_frames);
 void graphics_unload(CtxHandle gpu_ctx);
-i32  graphics_render_frame(CtxHandle gpu_ctx, const FrameData* frame_data);
+i32  graphics_render_frame(CtxHandle gpu_ctx, CtxHandle job_ctx, const FrameData* frame_data);
 
 #endif
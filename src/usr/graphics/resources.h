@@ -3,8 +3,8 @@
 
 #include "../../gpu/gpu.h"
 
-#define FRAME_BUFFER_SIZE_X (2560)
-#define FRAME_BUFFER_SIZE_Y (1440)
+/* frame buffers follow the swapchain size, percent */
+#define FRAME_BUFFER_SCALE (100)
 
 enum Samplers {
     SAMPLER_LINEAR_REPEAT  = GPU_SAMPLER_LINEAR_REPEAT_ID,
@@ -28,7 +28,7 @@ enum Buffers {
 };
 
 const GpuDescriptorType set_0_bindings[] = {
-    GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+    GPU_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
     GPU_DESCRIPTOR_TYPE_SAMPLER,
     GPU_DESCRIPTOR_TYPE_SAMPLER,
     GPU_DESCRIPTOR_TYPE_SAMPLER,
@@ -65,35 +65,35 @@ typedef struct {
 
 const BufferInfo buffer_infos[BUFFER_COUNT] = {
     [BUFFER_GLOBAL] = (BufferInfo) {
-        .flags = GPU_BUFFER_FLAG_UNIFORM_BUFFER,
+        .flags = GPU_BUFFER_FLAG_UNIFORM_BUFFER | GPU_BUFFER_FLAG_LATE_LATCH,
         .size  = sizeof(GlobalBuffer)
     }
 };
 
 const ImageInfo image_infos[IMAGE_COUNT] = {
     [IMAGE_SCREEN_COLOR] = (ImageInfo) {
-        .flags  = GPU_IMAGE_FLAG_COLOR_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED | GPU_IMAGE_FLAG_STORAGE,
+        .flags  = GPU_IMAGE_FLAG_COLOR_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED | GPU_IMAGE_FLAG_STORAGE | GPU_IMAGE_FLAG_SURFACE_RELATIVE,
         .format = GPU_FORMAT_R16G16B16A16_SFLOAT,
-        .size_x = FRAME_BUFFER_SIZE_X,
-        .size_y = FRAME_BUFFER_SIZE_Y
+        .size_x = FRAME_BUFFER_SCALE,
+        .size_y = FRAME_BUFFER_SCALE
     },
     [IMAGE_SCREEN_DEPTH] = (ImageInfo) {
-        .flags  = GPU_IMAGE_FLAG_DEPTH_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED,
+        .flags  = GPU_IMAGE_FLAG_DEPTH_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED | GPU_IMAGE_FLAG_SURFACE_RELATIVE,
         .format = GPU_FORMAT_D32_SFLOAT,
-        .size_x = FRAME_BUFFER_SIZE_X,
-        .size_y = FRAME_BUFFER_SIZE_Y
+        .size_x = FRAME_BUFFER_SCALE,
+        .size_y = FRAME_BUFFER_SCALE
     },
     [IMAGE_COPY_COLOR] = (ImageInfo) {
-        .flags  = GPU_IMAGE_FLAG_COLOR_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED,
+        .flags  = GPU_IMAGE_FLAG_COLOR_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED | GPU_IMAGE_FLAG_TRANSIENT | GPU_IMAGE_FLAG_SURFACE_RELATIVE,
         .format = GPU_FORMAT_R16G16B16A16_SFLOAT,
-        .size_x = FRAME_BUFFER_SIZE_X,
-        .size_y = FRAME_BUFFER_SIZE_Y
+        .size_x = FRAME_BUFFER_SCALE,
+        .size_y = FRAME_BUFFER_SCALE
     },
     [IMAGE_COPY_DEPTH] = (ImageInfo) {
-        .flags  = GPU_IMAGE_FLAG_COLOR_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED,
+        .flags  = GPU_IMAGE_FLAG_COLOR_ATTACHMENT | GPU_IMAGE_FLAG_SAMPLED | GPU_IMAGE_FLAG_TRANSIENT | GPU_IMAGE_FLAG_SURFACE_RELATIVE,
         .format = GPU_FORMAT_R32_SFLOAT,
-        .size_x = FRAME_BUFFER_SIZE_X,
-        .size_y = FRAME_BUFFER_SIZE_Y
+        .size_x = FRAME_BUFFER_SCALE,
+        .size_y = FRAME_BUFFER_SCALE
     }
 };
 
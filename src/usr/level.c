@@ -14,10 +14,37 @@ static f32  camera_y_rot    = 0.0f;
 static vec4 camera_position = {0.0, 1.0, 0.0, 1.0};
 static vec4 camera_rotation = {0.0, 0.0, 0.0, 1.0};
 
+void level_camera_matrices(vec4 camera_pos, versor camera_rot, mat4 camera_vp, mat4 camera_inv_v) {
+    mat4 transform = {
+        {1.0, 0.0, 0.0, 0.0},
+        {0.0, 1.0, 0.0, 0.0},
+        {0.0, 0.0, 1.0, 0.0},
+        {0.0, 0.0, 0.0, 1.0}
+    };
+    mat4 translate_mat = {
+        {1.0, 0.0, 0.0, 0.0},
+        {0.0, 1.0, 0.0, 0.0},
+        {0.0, 0.0, 1.0, 0.0},
+        {camera_pos[0], camera_pos[1], camera_pos[2], 1.0}
+    };
+    mat4 rotate_mat  = {0};
+    mat4 project_mat = {0};
+    mat4 transform_1 = {0};
+
+    glm_quat_mat4(camera_rot, rotate_mat);
+    glm_perspective(LEVEL_CAMERA_FOV * DEG_TO_RAD, 16.0 / 9.0, LEVEL_CAMERA_NEAR_CLIP, LEVEL_CAMERA_FAR_CLIP, project_mat);
+    project_mat[1][1] = -project_mat[1][1];
+
+    glm_mat4_mul(transform   , translate_mat, transform_1 );
+    glm_mat4_mul(transform_1 , rotate_mat   , camera_inv_v);
+    glm_mat4_inv(camera_inv_v, transform_1                );
+    glm_mat4_mul(project_mat , transform_1  , camera_vp   );
+}
+
 /* 0 = success
    1 = fail    
    2 = quit   */
-i32 update_level(mat4 camera_vp, mat4 camera_inv_v, vec4 camera_pos, f64* out_time, f64* out_delta) {
+i32 update_level(f64 fixed_delta, vec4 camera_pos, versor camera_rot, f64* out_time, f64* out_delta) {
     static b32 is_firt_frame = TRUE;
 
     f64 delta = 0.0;
@@ -26,7 +53,13 @@ i32 update_level(mat4 camera_vp, mat4 camera_inv_v, vec4 camera_pos, f64* out_ti
     LARGE_INTEGER performance_counter = (LARGE_INTEGER){0};
     LARGE_INTEGER frequency_counter   = (LARGE_INTEGER){0};
 
-    if(is_firt_frame) {
+    if(fixed_delta > 0.0) {
+        /* fixed tick, caller paces the updates */
+        if(!is_firt_frame) {
+            delta = fixed_delta;
+            time  = time + delta;
+        }
+    } else if(is_firt_frame) {
         if(!QueryPerformanceCounter(&performance_counter)) {
             LOG_ERROR("failed to query performance counter");
             goto fail;
@@ -149,36 +182,16 @@ i32 update_level(mat4 camera_vp, mat4 camera_inv_v, vec4 camera_pos, f64* out_ti
 
     glm_quat_mul(rotator_y, rotator_x, camera_rotation);
 
-    mat4 transform = {
-        {1.0, 0.0, 0.0, 0.0},
-        {0.0, 1.0, 0.0, 0.0},
-        {0.0, 0.0, 1.0, 0.0},
-        {0.0, 0.0, 0.0, 1.0}
-    };
-    mat4 translate_mat = {
-        {1.0, 0.0, 0.0, 0.0},
-        {0.0, 1.0, 0.0, 0.0},
-        {0.0, 0.0, 1.0, 0.0},
-        {camera_position[0], camera_position[1], camera_position[2], 1.0}
-    };
-    mat4 rotate_mat  = {0};
-    mat4 project_mat = {0};
-    mat4 transform_1 = {0};
-
-    glm_quat_mat4(camera_rotation, rotate_mat);
-    glm_perspective(LEVEL_CAMERA_FOV * DEG_TO_RAD, 16.0 / 9.0, LEVEL_CAMERA_NEAR_CLIP, LEVEL_CAMERA_FAR_CLIP, project_mat);
-    project_mat[1][1] = -project_mat[1][1];
-
-    glm_mat4_mul(transform   , translate_mat, transform_1 );
-    glm_mat4_mul(transform_1 , rotate_mat   , camera_inv_v);
-    glm_mat4_inv(camera_inv_v, transform_1                );
-    glm_mat4_mul(project_mat , transform_1  , camera_vp   );
-
     camera_pos[0] = camera_position[0];
     camera_pos[1] = camera_position[1];
     camera_pos[2] = camera_position[2];
     camera_pos[3] = camera_position[3];
 
+    camera_rot[0] = camera_rotation[0];
+    camera_rot[1] = camera_rotation[1];
+    camera_rot[2] = camera_rotation[2];
+    camera_rot[3] = camera_rotation[3];
+
     /*
     printf(
         "cam pos: {%f, %f, %f, %f}, cam rot: {%f, %f, %f, %f}, mouse_delta: {%d, %d}, time: %f, delta: %f\n",
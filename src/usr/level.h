@@ -21,6 +21,8 @@
 #define LEVEL_CAMERA_NEAR_CLIP    (0.3)
 #define LEVEL_CAMERA_FAR_CLIP     (1000.0)
 
-i32 update_level(mat4 camera_vp, mat4 camera_inv_v, vec4 camera_pos, f64* out_time, f64* out_delta);
+/* fixed_delta 0.0 = measured frame delta */
+i32  update_level(f64 fixed_delta, vec4 camera_pos, versor camera_rot, f64* out_time, f64* out_delta);
+void level_camera_matrices(vec4 camera_pos, versor camera_rot, mat4 camera_vp, mat4 camera_inv_v);
 
 #endif